@@ -5,6 +5,14 @@ option(ABRADE_ENABLE_WARNINGS "Enable strict compiler warnings for Abrade target
 option(ABRADE_WARNINGS_AS_ERRORS "Treat Abrade compiler warnings as errors" ON)
 option(ABRADE_ENABLE_COVERAGE "Enable compiler coverage instrumentation for Abrade targets" OFF)
 
+if(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+  set(ABRADE_ENABLE_USDT_DEFAULT ON)
+else()
+  set(ABRADE_ENABLE_USDT_DEFAULT OFF)
+endif()
+option(ABRADE_ENABLE_USDT "Compile USDT probes into abrade_core (requires sys/sdt.h)"
+  ${ABRADE_ENABLE_USDT_DEFAULT})
+
 function(abrade_target_defaults target)
   target_compile_features(${target} PUBLIC cxx_std_23)
   set_target_properties(${target} PROPERTIES
@@ -1,5 +1,7 @@
 include_guard(GLOBAL)
 
+option(ABRADE_BUILD_BENCHMARKS "Build Catch2 microbenchmarks (not registered with CTest)" OFF)
+
 function(abrade_add_unit_tests target unit_test_sources)
   find_package(Catch2 3 REQUIRED)
   list(APPEND CMAKE_MODULE_PATH "${Catch2_DIR}")
@@ -11,6 +13,14 @@ function(abrade_add_unit_tests target unit_test_sources)
   catch_discover_tests(${target})
 endfunction()
 
+function(abrade_add_benchmarks target benchmark_sources)
+  find_package(Catch2 3 REQUIRED)
+
+  add_executable(${target} ${benchmark_sources})
+  abrade_target_defaults(${target})
+  target_link_libraries(${target} PRIVATE abrade_core Catch2::Catch2WithMain)
+endfunction()
+
 function(abrade_add_scraper_integration_test cli_target)
   find_package(Python3 REQUIRED COMPONENTS Interpreter)
   find_program(ABRADE_OPENSSL_EXECUTABLE
@@ -25,6 +35,9 @@ function(abrade_add_scraper_integration_test cli_target)
   if(ABRADE_OPENSSL_EXECUTABLE)
     list(APPEND ABRADE_SCRAPER_INTEGRATION_COMMAND "--openssl" "${ABRADE_OPENSSL_EXECUTABLE}")
   endif()
+  if(TARGET abrade_top)
+    list(APPEND ABRADE_SCRAPER_INTEGRATION_COMMAND "--top" "$<TARGET_FILE:abrade_top>")
+  endif()
   add_test(
     NAME ScraperIntegration
     COMMAND ${ABRADE_SCRAPER_INTEGRATION_COMMAND}
@@ -1,25 +1,41 @@
 #pragma once
 #include <abrade/content_filter.hpp>
 #include <abrade/exception.hpp>
+#include <abrade/header_filter.hpp>
 #include <abrade/http_status.hpp>
+#include <abrade/near_duplicates.hpp>
 #include <abrade/run_stats.hpp>
+#include <abrade/simhash.hpp>
+#include <abrade/soft_not_found.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/regex.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 
 namespace abrade {
 
+/// How a HEAD response was classified.
+enum class Discovery { miss, found, header_filtered, soft_not_found };
+
 /// Handles HEAD responses by recording successful candidate paths.
 ///
-/// A 2xx status is treated as discovered. Successful candidates are appended to
-/// the configured output file; verbose mode also prints every observed status.
+/// A 2xx status whose header passes the configured header filters and does not
+/// match a learned soft 404 is treated as discovered. Discovered candidates are
+/// appended to the configured output file; verbose mode also prints every
+/// observed status. While `SoftNotFound` is calibrating, 2xx responses only
+/// teach it their fingerprint.
 struct HeadAction {
   /// Opens the append-only output file used for discovered candidates.
-  HeadAction(const std::string& output_path, bool verbose_output) : is_verbose{verbose_output} {
+  HeadAction(const std::string& output_path, bool verbose_output, HeaderFilters header_filters = {},
+             SoftNotFound* soft_not_found = nullptr)
+      : is_verbose{verbose_output}, headers{std::move(header_filters)}, soft_404{soft_not_found} {
     boost::filesystem::path boost_path(output_path);
     boost::system::error_code ec;
     create_directories(boost_path.parent_path(), ec);
@@ -27,32 +43,239 @@ struct HeadAction {
     file.open(output_path, std::ofstream::out | std::ofstream::app);
   }
 
-  /// Records a candidate when the response is successful and optionally logs status.
-  void process(unsigned int status_code, const std::string_view& candidate) {
-    if (is_success_status(status_code)) {
+  /// Classifies a response, records it when found, and optionally logs its status.
+  template <typename Fields>
+  Discovery process(unsigned int status_code, const Fields& header,
+                    const std::string_view& candidate) {
+    const auto discovery = classify(status_code, header);
+    if (discovery == Discovery::found) {
       file << candidate << '\n';
       file.flush();
     }
     if (is_verbose) {
       std::cout << candidate << ": " << status_code << '\n';
     }
+    return discovery;
   }
 
 private:
+  template <typename Fields> Discovery classify(unsigned int status_code, const Fields& header) {
+    if (!is_success_status(status_code)) {
+      return Discovery::miss;
+    }
+    if (soft_404 != nullptr && soft_404->calibrating()) {
+      soft_404->learn(ResponseFingerprint::of(status_code, header));
+      return Discovery::miss;
+    }
+    if (!headers.accepts(header)) {
+      return Discovery::header_filtered;
+    }
+    if (soft_404 != nullptr && soft_404->matches(ResponseFingerprint::of(status_code, header))) {
+      return Discovery::soft_not_found;
+    }
+    return Discovery::found;
+  }
+
   const bool is_verbose;
+  HeaderFilters headers;
+  SoftNotFound* soft_404;
   std::ofstream file;
 };
 
 /// Handles GET responses by writing accepted response bodies to disk.
 ///
-/// Only 2xx response bodies can be persisted. Verbose mode prints diagnostics
-/// but deliberately does not change which bodies are written.
+/// Only 2xx response bodies can be persisted. The query consults `admits` before
+/// reading a body so header filters can reject it without a transfer. Bodies are
+/// streamed into a spool file as they arrive and renamed into place only once
+/// content filters and the configured length range accept them. With a
+/// `SoftNotFound`, 2xx bodies are also SimHashed: during calibration they only
+/// teach it their fingerprint, and afterwards bodies that match are dropped.
+/// With `NearDuplicates`, accepted bodies beyond the first few of a cluster are
+/// listed in its index instead of being written.
 struct GetAction {
-  /// Creates the output directory and configures body filters.
-  GetAction(const std::string& output_dir, ContentFilters filters_in, bool verbose_output,
-            RunStats& run_stats)
-      : re{"[^a-zA-Z0-9.-]"}, is_verbose{verbose_output}, path_dir{output_dir},
-        filters{std::move(filters_in)}, stats{run_stats} {
+  /// One in-flight response body.
+  ///
+  /// Each chunk is scanned by the content filters and appended to
+  /// `<output>.part`, so memory stays bounded by the query's read chunk size.
+  /// `commit` renames accepted spools into place; an uncommitted spool is removed
+  /// on destruction so failed transfers never leave partial output behind.
+  /// A `WorkerPool` may run `write` and `finish`: besides this response they
+  /// only use the mutex-guarded `NearDuplicates` and a `SoftNotFound` that is
+  /// read-only once calibration has finished. `report` stays on the networking thread.
+  struct Response {
+    Response(GetAction& owner, unsigned int status_code, std::string_view candidate_name,
+             std::optional<ResponseFingerprint> response_fingerprint = std::nullopt)
+        : action{owner}, candidate{candidate_name}, scan{owner.filters},
+          is_persistable{is_success_status(status_code)},
+          fingerprint{std::move(response_fingerprint)},
+          is_hashed{is_persistable && (fingerprint || action.clusters != nullptr)} {
+      if (!is_persistable) {
+        return;
+      }
+      if (is_hashed) {
+        body_hash.ignore(candidate);
+      }
+      path = action.output_path(candidate);
+      spool_path = path + ".part";
+      file.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+      file.open(spool_path, std::ofstream::out | std::ofstream::binary);
+    }
+
+    Response(const Response&) = delete;
+    Response(Response&&) = delete;
+    Response& operator=(const Response&) = delete;
+    Response& operator=(Response&&) = delete;
+
+    ~Response() {
+      if (!is_persistable || committed) {
+        return;
+      }
+      try {
+        file.close();
+      } catch (const std::exception&) {
+        // The spool is discarded below; a close failure adds nothing actionable.
+      }
+      boost::system::error_code ignored;
+      boost::filesystem::remove(spool_path, ignored);
+    }
+
+    /// Scans and spools the next body chunk; returns false once filters have rejected the body
+    /// or it has outgrown the configured maximum length.
+    [[nodiscard]] bool write(std::string_view chunk) {
+      if (!is_persistable) {
+        return true;
+      }
+      if (is_hashed) {
+        body_hash.feed(chunk);
+      }
+      scan.feed(chunk);
+      is_oversized = is_oversized || action.headers.exceeds_length(spooled + chunk.size());
+      if (scan.rejected() || is_oversized) {
+        return false;
+      }
+      file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+      spooled += chunk.size();
+      return true;
+    }
+
+    /// Finishes the body, applies filters, and moves an accepted spool into place.
+    ///
+    /// It may run on a body worker, since shared state is limited to the
+    /// thread-safe `NearDuplicates` and reads of a calibrated `SoftNotFound`;
+    /// call `report` afterwards on the thread that owns `RunStats`.
+    void finish() {
+      if (!is_persistable) {
+        return;
+      }
+      file.close();
+      scan.finish();
+      const auto signature = is_hashed ? body_hash.finish() : std::uint64_t{};
+      if (fingerprint) {
+        fingerprint->body_hash = signature;
+        fingerprint->length = spooled;
+        if (action.soft_404->calibrating()) {
+          is_soft_not_found = true;
+          return;
+        }
+      }
+      if (is_oversized || !action.headers.length_accepts(spooled)) {
+        is_length_rejected = true;
+        return;
+      }
+      if (!scan.accepts()) {
+        return;
+      }
+      if (fingerprint && action.soft_404->matches(*fingerprint)) {
+        is_soft_not_found = true;
+        return;
+      }
+      std::optional<NearDuplicates::Assignment> cluster;
+      if (action.clusters != nullptr) {
+        cluster = action.clusters->assign(signature);
+        if (!cluster->is_exemplar) {
+          action.clusters->record(*cluster, candidate);
+          is_near_duplicate = true;
+          return;
+        }
+      }
+      boost::system::error_code ec;
+      boost::filesystem::rename(spool_path, path, ec);
+      if (ec) {
+        if (cluster) {
+          action.clusters->release(*cluster);
+        }
+        throw AbradeException{"commit body", ec};
+      }
+      if (cluster) {
+        action.clusters->record(*cluster, candidate);
+      }
+      committed = true;
+    }
+
+    /// Records the outcome of `finish` as bytes written, a soft 404, a near duplicate, a body
+    /// outside the length range, or a filtered body.
+    ///
+    /// During calibration the fingerprint is learned instead, so call this on the
+    /// thread that owns the `SoftNotFound` as well as `RunStats`.
+    void report() {
+      if (!is_persistable) {
+        return;
+      }
+      if (committed) {
+        action.stats.record_bytes_written(spooled);
+      } else if (is_soft_not_found && action.soft_404->calibrating()) {
+        action.soft_404->learn(std::move(*fingerprint));
+      } else if (is_soft_not_found) {
+        action.stats.record_soft_not_found();
+      } else if (is_near_duplicate) {
+        action.stats.record_near_duplicate();
+      } else if (is_length_rejected) {
+        action.stats.record_header_filtered();
+      } else {
+        action.stats.record_filtered();
+      }
+    }
+
+    /// Returns true once `finish` has dropped the body as a soft 404 or calibration sample.
+    [[nodiscard]] bool soft_not_found() const noexcept { return is_soft_not_found; }
+
+    /// Returns true once `finish` has dropped a body whose streamed length missed the length
+    /// range, which a header without `Content-Length` could not settle.
+    [[nodiscard]] bool length_rejected() const noexcept { return is_length_rejected; }
+
+    /// Finishes and reports on the calling thread.
+    void commit() {
+      finish();
+      report();
+    }
+
+  private:
+    GetAction& action;
+    std::string_view candidate;
+    ContentScan scan;
+    const bool is_persistable;
+    bool committed{};
+    bool is_oversized{};
+    bool is_length_rejected{};
+    bool is_soft_not_found{};
+    bool is_near_duplicate{};
+    std::size_t spooled{};
+    std::optional<ResponseFingerprint> fingerprint;
+    const bool is_hashed;
+    SimHash body_hash;
+    std::string path;
+    std::string spool_path;
+    std::ofstream file;
+  };
+
+  /// Creates the output directory and configures header, body, soft-404, and near-duplicate
+  /// filters.
+  GetAction(const std::string& output_dir, ContentFilters filters_in, RunStats& run_stats,
+            HeaderFilters header_filters = {}, SoftNotFound* soft_not_found = nullptr,
+            NearDuplicates* near_duplicates = nullptr)
+      : re{"[^a-zA-Z0-9.-]"}, path_dir{output_dir},
+        filters{std::move(filters_in)}, headers{std::move(header_filters)},
+        soft_404{soft_not_found}, clusters{near_duplicates}, stats{run_stats} {
     boost::system::error_code ec;
     boost::filesystem::create_directories(output_dir, ec);
     if (ec) {
@@ -60,37 +283,48 @@ struct GetAction {
     }
   }
 
-  /// Writes successful accepted bodies using the candidate as a sanitized filename.
-  void process(unsigned int status_code, std::string_view body, std::string_view candidate) {
-    if (is_verbose) {
-      std::cout << "[ ] Response body from " << candidate << ":\n" << body << '\n';
-    }
-    if (!is_success_status(status_code)) {
-      return;
-    }
-    if (!filters.accepts(body)) {
-      stats.record_filtered();
-      return;
+  /// Returns true when a 2xx response header passes the header filters, so its body is worth
+  /// reading. Every body is worth reading while soft-404 calibration is running.
+  template <typename Fields> [[nodiscard]] bool admits(const Fields& header) const {
+    return (soft_404 != nullptr && soft_404->calibrating()) || headers.accepts(header);
+  }
+
+  /// Starts streaming one response body; the caller writes chunks and then commits.
+  [[nodiscard]] Response open(unsigned int status_code, std::string_view candidate) {
+    return Response{*this, status_code, candidate};
+  }
+
+  /// Starts streaming one response body, fingerprinting it when soft-404 detection is enabled.
+  template <typename Fields>
+  [[nodiscard]] Response open(unsigned int status_code, const Fields& header,
+                              std::string_view candidate) {
+    if (soft_404 == nullptr || !is_success_status(status_code)) {
+      return Response{*this, status_code, candidate};
     }
-    write_out(body, candidate);
+    return Response{*this, status_code, candidate, ResponseFingerprint::of(status_code, header)};
+  }
+
+  /// Writes a fully buffered body using the candidate as a sanitized filename.
+  void process(unsigned int status_code, std::string_view body, std::string_view candidate) {
+    auto response = open(status_code, candidate);
+    static_cast<void>(response.write(body));
+    response.commit();
   }
 
 private:
-  void write_out(std::string_view body, std::string_view candidate) {
+  [[nodiscard]] std::string output_path(std::string_view candidate) const {
     auto path{path_dir};
     path.append("/");
     path.append(regex_replace(std::string{candidate.begin(), candidate.end()}, re, "_"));
-    std::ofstream file;
-    file.exceptions(std::ios_base::failbit | std::ios_base::badbit);
-    file.open(path, std::ofstream::out | std::ofstream::binary);
-    file.write(body.data(), static_cast<std::streamsize>(body.size()));
-    stats.record_bytes_written(body.size());
+    return path;
   }
 
   const boost::regex re;
-  const bool is_verbose;
   const std::string path_dir;
   ContentFilters filters;
+  HeaderFilters headers;
+  SoftNotFound* soft_404;
+  NearDuplicates* clusters;
   RunStats& stats;
 };
 } // namespace abrade
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <abrade/controller.hpp>
+#include <abrade/generator.hpp>
+#include <abrade/latency_histogram.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace abrade {
+
+/// What one concurrency level of a `--calibrate` sweep measured.
+struct CalibrationStep {
+  std::size_t concurrency{};
+  std::size_t finished{};
+  std::size_t failed{};
+  /// From the step's start to its last completion.
+  double seconds{};
+  /// Latency of the candidates that succeeded.
+  LatencyHistogram latency;
+
+  /// Returns finished candidates per second.
+  [[nodiscard]] double throughput() const noexcept {
+    return seconds > 0.0 ? static_cast<double>(finished) / seconds : 0.0;
+  }
+
+  /// Returns the share of finished candidates that failed.
+  [[nodiscard]] double error_rate() const noexcept {
+    return finished == 0U ? 0.0 : static_cast<double>(failed) / static_cast<double>(finished);
+  }
+
+  /// Formats the step as one line of the calibration curve.
+  [[nodiscard]] std::string describe() const {
+    std::ostringstream line;
+    line.setf(std::ios::fixed);
+    line.precision(1);
+    line << "[ ] Calibration: " << concurrency << " coros: " << throughput() << " req/s, "
+         << 100.0 * error_rate() << "% errors, latency p50/p90/p99 "
+         << static_cast<double>(latency.percentile(0.5)) / 1000.0 << '/'
+         << static_cast<double>(latency.percentile(0.9)) / 1000.0 << '/'
+         << static_cast<double>(latency.percentile(0.99)) / 1000.0 << " ms (" << finished
+         << " candidates)";
+    return line.str();
+  }
+};
+
+/// Keeps one step of a calibration sweep at its concurrency and measures it.
+///
+/// It never samples; the scraper's latency and completion reports go straight
+/// into a `CalibrationStep`.
+struct CalibrationController : Controller {
+  explicit CalibrationController(std::size_t level)
+      : Controller{std::numeric_limits<std::size_t>::max()} {
+    measured.concurrency = level;
+  }
+
+  void register_completion(std::size_t current_coroutines) override {
+    measured.finished++;
+    last_completion = std::chrono::steady_clock::now();
+    Controller::register_completion(current_coroutines);
+  }
+
+  void register_latency(std::chrono::steady_clock::duration latency) override {
+    measured.latency.record(latency);
+  }
+
+  std::size_t recommended_coroutines() const noexcept override { return measured.concurrency; }
+
+  double measured_velocity() const noexcept override { return step().throughput(); }
+
+  /// Returns what the step measured so far.
+  [[nodiscard]] CalibrationStep step() const noexcept {
+    auto current = measured;
+    current.failed = current.finished - static_cast<std::size_t>(current.latency.count());
+    current.seconds = std::chrono::duration<double>{last_completion - started}.count();
+    return current;
+  }
+
+protected:
+  void sample(double /*velocity*/, std::size_t /*current_coroutines*/) override {}
+
+private:
+  CalibrationStep measured;
+  std::chrono::steady_clock::time_point started{std::chrono::steady_clock::now()};
+  std::chrono::steady_clock::time_point last_completion{started};
+};
+
+/// Hands out at most `limit` candidates from another generator, leaving the rest in it.
+struct LimitedGenerator : Generator {
+  LimitedGenerator(Generator& generator_source, std::size_t candidate_limit)
+      : source{generator_source}, limit{candidate_limit} {}
+
+  std::optional<std::string> next() override {
+    if (taken == limit) {
+      return std::nullopt;
+    }
+    auto candidate = source.next();
+    if (candidate) {
+      taken++;
+    }
+    return candidate;
+  }
+
+private:
+  Generator& source;
+  std::size_t limit, taken{};
+};
+
+/// Plans a `--calibrate` sweep and turns its curve into concurrency bounds.
+///
+/// Levels double from `first_level`, or `--min` when that is higher, up to
+/// `--max`. Each runs `candidates_per_coroutine` candidates per coroutine, and
+/// at least `minimum_candidates`, taken in order from the scan's own
+/// candidates. The sweep stops once more than `error_threshold` of a step's
+/// candidates fail, once throughput grows by less than `growth` for
+/// `stalled_steps` steps in a row, or after `maximum_steps`.
+///
+/// The knee is the lowest level reaching `knee_share` of the best throughput
+/// among steps within the error threshold. It becomes `--init`; `--min` is a
+/// quarter of it, and `--max` four times it, but no higher than the last level
+/// within the error threshold when a step exceeded it. All three stay within
+/// the configured `--min` and `--max`.
+class CalibrationSweep {
+public:
+  static constexpr std::size_t first_level{8};
+  static constexpr std::size_t candidates_per_coroutine{4};
+  static constexpr std::size_t minimum_candidates{50};
+  static constexpr std::size_t maximum_steps{16};
+  static constexpr std::size_t stalled_steps{2};
+  static constexpr double growth{1.1};
+  static constexpr double error_threshold{0.05};
+  static constexpr double knee_share{0.9};
+
+  CalibrationSweep(std::size_t minimum_coroutines, std::size_t maximum_coroutines)
+      : min_coro{minimum_coroutines}, max_coro{maximum_coroutines} {}
+
+  /// Returns the concurrency of the next step, or `std::nullopt` once the sweep is over.
+  [[nodiscard]] std::optional<std::size_t> next_level() const noexcept {
+    if (steps.empty()) {
+      return std::min(std::max(first_level, min_coro), max_coro);
+    }
+    const auto& last = steps.back();
+    if (exhausted || steps.size() == maximum_steps || last.concurrency >= max_coro ||
+        last.error_rate() > error_threshold || stalls >= stalled_steps) {
+      return std::nullopt;
+    }
+    return std::min(last.concurrency * 2U, max_coro);
+  }
+
+  /// Returns how many candidates the step at `level` runs.
+  [[nodiscard]] static std::size_t candidates(std::size_t level) noexcept {
+    return std::max(level * candidates_per_coroutine, minimum_candidates);
+  }
+
+  /// Adds a finished step; a step that finished fewer candidates than planned ran out of them.
+  void record(const CalibrationStep& step) {
+    exhausted = step.finished < candidates(step.concurrency);
+    if (!steps.empty() && step.throughput() < best_throughput() * growth) {
+      stalls++;
+    } else {
+      stalls = 0;
+    }
+    steps.push_back(step);
+  }
+
+  /// Returns every step so far, in sweep order.
+  [[nodiscard]] const std::vector<CalibrationStep>& curve() const noexcept { return steps; }
+
+  /// Returns the recommended initial concurrency; the first level before any step.
+  [[nodiscard]] std::size_t initial() const noexcept {
+    const auto best = best_throughput();
+    for (const auto& step : steps) {
+      if (step.error_rate() <= error_threshold && step.throughput() >= knee_share * best) {
+        return bounded(step.concurrency);
+      }
+    }
+    return bounded(steps.empty() ? first_level : steps.front().concurrency);
+  }
+
+  /// Returns the recommended minimum concurrency.
+  [[nodiscard]] std::size_t minimum() const noexcept { return bounded(initial() / 4U); }
+
+  /// Returns the recommended maximum concurrency.
+  [[nodiscard]] std::size_t maximum() const noexcept {
+    auto ceiling = initial() * 4U;
+    if (!steps.empty() && steps.back().error_rate() > error_threshold) {
+      ceiling = initial();
+      for (const auto& step : steps) {
+        if (step.error_rate() <= error_threshold) {
+          ceiling = std::max(ceiling, step.concurrency);
+        }
+      }
+    }
+    return bounded(ceiling);
+  }
+
+private:
+  [[nodiscard]] double best_throughput() const noexcept {
+    double best{};
+    for (const auto& step : steps) {
+      if (step.error_rate() <= error_threshold) {
+        best = std::max(best, step.throughput());
+      }
+    }
+    return best;
+  }
+
+  [[nodiscard]] std::size_t bounded(std::size_t level) const noexcept {
+    return std::clamp(level, min_coro, max_coro);
+  }
+
+  std::size_t min_coro, max_coro, stalls{};
+  bool exhausted{};
+  std::vector<CalibrationStep> steps;
+};
+} // namespace abrade
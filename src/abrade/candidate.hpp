@@ -1,5 +1,7 @@
 #pragma once
+#include <boost/beast/http/verb.hpp>
 #include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -20,5 +22,9 @@ struct Candidate {
   std::map<std::string, std::string> headers;
   /// Future extension point for candidate-specific request bodies.
   std::vector<char> contents;
+  /// Method sent instead of the query's own; set only on follow-ups a query asks to retry.
+  std::optional<boost::beast::http::verb> method;
+  /// True on a follow-up that repeats this hop on a new connection rather than redirecting.
+  bool retry{};
 };
 } // namespace abrade
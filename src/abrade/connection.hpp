@@ -2,8 +2,10 @@
 #include <abrade/endpoint.hpp>
 #include <abrade/exception.hpp>
 #include <abrade/network_timeout.hpp>
+#include <abrade/run_stats.hpp>
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <boost/asio.hpp>
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/spawn.hpp>
@@ -89,14 +91,17 @@ private:
 /// unless strict teardown mode is enabled.
 struct PlaintextConnection {
   PlaintextConnection(const std::string& host_name, bool strict_teardown,
-                      boost::asio::io_context& io_context)
+                      boost::asio::io_context& io_context, RunStats& run_stats)
       : sensitive_teardown{strict_teardown}, endpoint{parse_host_endpoint(host_name, "80", 80)},
-        ios{io_context} {}
+        ios{io_context}, stats{run_stats} {}
 
   /// Resolves the target host, connects the socket, and returns a managed plaintext stream.
   auto connect(boost::asio::ip::tcp::socket& sock, const boost::asio::yield_context& yield) {
     auto result = std::make_unique<Connection<boost::asio::ip::tcp::socket&>>(
         [st = sensitive_teardown](auto& stream) {
+          if (!stream.is_open()) {
+            return; // The query already dropped the connection on purpose.
+          }
           boost::system::error_code shutdown_error;
           stream.shutdown(boost::asio::ip::tcp::socket::shutdown_both, shutdown_error);
           if (st && shutdown_error != boost::asio::error::eof) {
@@ -106,15 +111,18 @@ struct PlaintextConnection {
         sock);
 
     boost::asio::ip::tcp::resolver resolver{ios};
+    PhaseTimer phase{stats, Phase::resolve, &sock};
     const auto lookup_result =
         await_resolver_with_timeout<boost::asio::ip::tcp::resolver::results_type>(
             resolver, "resolve host", yield, [this, &resolver](auto token) {
               return resolver.async_resolve(endpoint.host, endpoint.service, token);
             });
+    phase.next(Phase::connect);
     await_stream_with_timeout(result->get(), "tcp connect", yield,
                               [&result, &lookup_result](auto token) {
                                 boost::asio::async_connect(result->get(), lookup_result, token);
                               });
+    phase.finish();
 
     return result;
   }
@@ -123,6 +131,7 @@ private:
   bool sensitive_teardown;
   HostEndpoint endpoint;
   boost::asio::io_context& ios;
+  RunStats& stats;
 };
 
 /// Opens direct TLS connections.
@@ -132,10 +141,10 @@ private:
 /// when enabled. DNS-name targets are also sent through SNI.
 struct TlsConnection {
   TlsConnection(const std::string& host_name, bool is_verify, bool strict_teardown,
-                boost::asio::io_context& io_context)
+                boost::asio::io_context& io_context, RunStats& run_stats)
       : sensitive_teardown{strict_teardown}, verify_peer{is_verify},
         endpoint{parse_host_endpoint(host_name, "443", 443)},
-        context{boost::asio::ssl::context::tls_client}, ios{io_context} {
+        context{boost::asio::ssl::context::tls_client}, ios{io_context}, stats{run_stats} {
     boost::system::error_code ec;
     if (is_verify) {
       context.set_default_verify_paths(ec);
@@ -154,6 +163,9 @@ struct TlsConnection {
     auto result =
         std::make_unique<Connection<boost::asio::ssl::stream<boost::asio::ip::tcp::socket&>>>(
             [&yield, st = sensitive_teardown](auto& stream) {
+              if (!stream.lowest_layer().is_open()) {
+                return; // The query already dropped the connection on purpose.
+              }
               boost::system::error_code ec;
               stream.async_shutdown(yield[ec]);
               if (st && ec && ec != boost::asio::error::eof) {
@@ -164,18 +176,21 @@ struct TlsConnection {
     detail::configure_tls_peer(result->get(), endpoint, verify_peer);
 
     boost::asio::ip::tcp::resolver resolver{ios};
+    PhaseTimer phase{stats, Phase::resolve, &sock};
     const auto lookup_result =
         await_resolver_with_timeout<boost::asio::ip::tcp::resolver::results_type>(
             resolver, "resolve host", yield, [this, &resolver](auto token) {
               return resolver.async_resolve(endpoint.host, endpoint.service, token);
             });
+    phase.next(Phase::connect);
     await_stream_with_timeout(sock, "ssl connect", yield, [&sock, &lookup_result](auto token) {
       boost::asio::async_connect(sock, lookup_result, token);
     });
-
+    phase.next(Phase::tls);
     await_stream_with_timeout(result->get(), "ssl handshake", yield, [&result](auto token) {
       result->get().async_handshake(boost::asio::ssl::stream_base::client, token);
     });
+    phase.finish();
 
     return result;
   }
@@ -186,6 +201,7 @@ private:
   HostEndpoint endpoint;
   boost::asio::ssl::context context;
   boost::asio::io_context& ios;
+  RunStats& stats;
 };
 
 /// Opens plaintext TCP connections through a SOCKS5 proxy.
@@ -194,15 +210,19 @@ private:
 /// SOCKS5 no-authentication method is supported.
 struct ProxiedConnection {
   ProxiedConnection(const std::string& proxy, const std::string& host_name, bool strict_teardown,
-                    boost::asio::io_context& io_context)
+                    boost::asio::io_context& io_context, RunStats& run_stats)
       : sensitive_teardown{strict_teardown}, endpoint{parse_host_endpoint(host_name, "80", 80)},
-        proxy_endpoint{parse_host_endpoint(proxy, "1080", 1080)}, ios{io_context} {}
+        proxy_endpoint{parse_host_endpoint(proxy, "1080", 1080)}, ios{io_context},
+        stats{run_stats} {}
 
   /// Connects to the proxy, negotiates SOCKS5, and returns a managed plaintext stream to the
   /// target.
   auto connect(boost::asio::ip::tcp::socket& sock, const boost::asio::yield_context& yield) {
     auto result = std::make_unique<Connection<boost::asio::ip::tcp::socket&>>(
         [st = sensitive_teardown](auto& stream) {
+          if (!stream.is_open()) {
+            return; // The query already dropped the connection on purpose.
+          }
           boost::system::error_code shutdown_error;
           stream.shutdown(boost::asio::ip::tcp::socket::shutdown_both, shutdown_error);
           if (st && shutdown_error && shutdown_error != boost::asio::error::eof) {
@@ -212,15 +232,18 @@ struct ProxiedConnection {
         sock);
 
     boost::asio::ip::tcp::resolver resolver{ios};
+    PhaseTimer phase{stats, Phase::resolve, &sock};
     const auto proxy_lookup =
         await_resolver_with_timeout<boost::asio::ip::tcp::resolver::results_type>(
             resolver, "resolve proxy", yield, [this, &resolver](auto token) {
               return resolver.async_resolve(proxy_endpoint.host, proxy_endpoint.service, token);
             });
+    phase.next(Phase::connect);
     await_stream_with_timeout(result->get(), "proxy connect", yield,
                               [&result, &proxy_lookup](auto token) {
                                 boost::asio::async_connect(result->get(), proxy_lookup, token);
                               });
+    phase.next(Phase::proxy);
 
     static const std::array<unsigned char, 3> auth_request{5, 1, 0};
     await_stream_with_timeout(result->get(), "proxy write auth", yield, [&result](auto token) {
@@ -278,6 +301,7 @@ struct ProxiedConnection {
       err_msg.append(std::to_string(connect_response.at(1)));
       throw AbradeException{std::move(err_msg)};
     }
+    phase.finish();
 
     return result;
   }
@@ -287,6 +311,7 @@ private:
   HostEndpoint endpoint;
   HostEndpoint proxy_endpoint;
   boost::asio::io_context& ios;
+  RunStats& stats;
 };
 
 /// Opens TLS connections through a SOCKS5 proxy.
@@ -296,11 +321,12 @@ private:
 /// semantics as `TlsConnection`, including SNI for DNS-name targets.
 struct ProxiedTlsConnection {
   ProxiedTlsConnection(const std::string& proxy, const std::string& host_name, bool is_verify,
-                       bool strict_teardown, boost::asio::io_context& io_context)
+                       bool strict_teardown, boost::asio::io_context& io_context,
+                       RunStats& run_stats)
       : sensitive_teardown{strict_teardown}, verify_peer{is_verify},
         endpoint{parse_host_endpoint(host_name, "443", 443)},
         proxy_endpoint{parse_host_endpoint(proxy, "1080", 1080)},
-        context{boost::asio::ssl::context::tls_client}, ios{io_context} {
+        context{boost::asio::ssl::context::tls_client}, ios{io_context}, stats{run_stats} {
     boost::system::error_code ec;
     if (is_verify) {
       context.set_default_verify_paths(ec);
@@ -318,6 +344,9 @@ struct ProxiedTlsConnection {
     auto result =
         std::make_unique<Connection<boost::asio::ssl::stream<boost::asio::ip::tcp::socket&>>>(
             [&yield, st = sensitive_teardown](auto& stream) {
+              if (!stream.lowest_layer().is_open()) {
+                return; // The query already dropped the connection on purpose.
+              }
               boost::system::error_code ec;
               stream.async_shutdown(yield[ec]);
               if (st && ec && ec != boost::asio::error::eof) {
@@ -328,14 +357,17 @@ struct ProxiedTlsConnection {
     detail::configure_tls_peer(result->get(), endpoint, verify_peer);
 
     boost::asio::ip::tcp::resolver resolver{ios};
+    PhaseTimer phase{stats, Phase::resolve, &sock};
     const auto proxy_lookup =
         await_resolver_with_timeout<boost::asio::ip::tcp::resolver::results_type>(
             resolver, "resolve proxy", yield, [this, &resolver](auto token) {
               return resolver.async_resolve(proxy_endpoint.host, proxy_endpoint.service, token);
             });
+    phase.next(Phase::connect);
     await_stream_with_timeout(sock, "proxy connect", yield, [&sock, &proxy_lookup](auto token) {
       boost::asio::async_connect(sock, proxy_lookup, token);
     });
+    phase.next(Phase::proxy);
 
     static const std::array<unsigned char, 3> auth_request{5, 1, 0};
     await_stream_with_timeout(sock, "proxy write auth", yield, [&sock](auto token) {
@@ -388,10 +420,11 @@ struct ProxiedTlsConnection {
       err_msg.append(std::to_string(connect_response.at(1)));
       throw AbradeException{std::move(err_msg)};
     }
-
+    phase.next(Phase::tls);
     await_stream_with_timeout(result->get(), "proxied ssl handshake", yield, [&result](auto token) {
       result->get().async_handshake(boost::asio::ssl::stream_base::client, token);
     });
+    phase.finish();
 
     return result;
   }
@@ -403,5 +436,6 @@ private:
   HostEndpoint proxy_endpoint;
   boost::asio::ssl::context context;
   boost::asio::io_context& ios;
+  RunStats& stats;
 };
 } // namespace abrade
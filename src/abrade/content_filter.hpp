@@ -1,8 +1,12 @@
 #pragma once
 
+#include <abrade/literal_matcher.hpp>
+#include <abrade/regex_set.hpp>
 #include <algorithm>
 #include <boost/regex.hpp>
+#include <cstddef>
 #include <iterator>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -20,13 +24,84 @@ namespace detail {
   return boost::regex_search(body.begin(), body.end(), pattern);
 #endif
 }
+
+/// Incremental regex search over a body delivered in chunks.
+///
+/// Boost partial matching tells us where a match could still begin, so only the
+/// text from that point onward is retained between chunks. The retained window is
+/// capped; a match longer than the cap may be missed, which keeps memory bounded.
+class StreamingRegexSearch {
+public:
+  static constexpr std::size_t max_window{1024U * 1024U};
+
+  explicit StreamingRegexSearch(const boost::regex& regex) : pattern{&regex} {}
+
+  /// Appends a chunk and searches for a complete match that ends inside the body seen so far.
+  void feed(std::string_view chunk) {
+    if (found) {
+      return;
+    }
+    window.append(chunk);
+    search(boost::match_partial | boost::match_not_eob | boost::match_not_eol);
+  }
+
+  /// Runs the final search that may anchor at the end of the body.
+  void finish() {
+    if (!found) {
+      search(boost::match_default);
+    }
+    window.clear();
+  }
+
+  [[nodiscard]] bool matched() const noexcept { return found; }
+
+private:
+  void search(boost::match_flag_type flags) {
+#if defined(__clang_analyzer__)
+    static_cast<void>(flags);
+#else
+    if (context != 0U) {
+      flags |= boost::match_prev_avail;
+    }
+    const auto begin = std::next(window.cbegin(), static_cast<std::ptrdiff_t>(context));
+    boost::match_results<std::string::const_iterator> match;
+    if (!boost::regex_search(begin, window.cend(), match, *pattern, flags)) {
+      retain_from(window.size());
+      return;
+    }
+    if (match[0].matched) {
+      found = true;
+      window.clear();
+      return;
+    }
+    retain_from(static_cast<std::size_t>(std::distance(window.cbegin(), match[0].first)));
+#endif
+  }
+
+  void retain_from(std::size_t offset) {
+    // Keep one character of look-behind so anchors and word boundaries see real context.
+    offset = std::max(offset, window.size() > max_window ? window.size() - max_window : 0U);
+    const auto keep_from = offset == 0U ? 0U : offset - 1U;
+    window.erase(0, keep_from);
+    context = offset == 0U ? 0U : 1U;
+  }
+
+  const boost::regex* pattern;
+  std::string window;
+  std::size_t context{};
+  bool found{};
+};
 } // namespace detail
 
 /// Repeatable filters applied to successful GET response bodies before persistence.
 ///
 /// Required filters are conjunctive: every literal and regular expression must match.
 /// Rejected filters are also conjunctive as blockers: any matching literal or regular
-/// expression prevents the body from being written.
+/// expression prevents the body from being written. All literals, required and
+/// rejected, are compiled into one `LiteralMatcher`, and every regex the DFA can
+/// express is compiled into one `RegexSet`, so a body is scanned once for each
+/// no matter how many filters are configured. Regexes outside the DFA subset fall
+/// back to a `boost::regex` search of their own.
 struct ContentFilters {
   ContentFilters() = default;
 
@@ -36,39 +111,193 @@ struct ContentFilters {
       : required_literals{std::move(required_text)}, rejected_literals{std::move(rejected_text)},
         required_patterns{std::move(required_regex_text)},
         rejected_patterns{std::move(rejected_regex_text)} {
-    required_regexes.reserve(required_patterns.size());
-    std::ranges::transform(required_patterns, std::back_inserter(required_regexes),
-                           [](const auto& pattern) { return boost::regex{pattern}; });
-    rejected_regexes.reserve(rejected_patterns.size());
-    std::ranges::transform(rejected_patterns, std::back_inserter(rejected_regexes),
+    auto literals = required_literals;
+    literals.insert(literals.end(), rejected_literals.begin(), rejected_literals.end());
+    literal_matcher = LiteralMatcher{literals};
+    auto patterns = required_patterns;
+    patterns.insert(patterns.end(), rejected_patterns.begin(), rejected_patterns.end());
+    regexes.reserve(patterns.size());
+    std::ranges::transform(patterns, std::back_inserter(regexes),
                            [](const auto& pattern) { return boost::regex{pattern}; });
+    regex_set = RegexSet{patterns};
   }
 
   /// Returns true when no body filters are configured.
   [[nodiscard]] bool empty() const noexcept {
-    return required_literals.empty() && rejected_literals.empty() && required_regexes.empty() &&
-           rejected_regexes.empty();
+    return required_literals.empty() && rejected_literals.empty() && regexes.empty();
   }
 
   /// Returns true when a response body satisfies all configured filters.
   [[nodiscard]] bool accepts(std::string_view body) const {
-    const auto body_contains = [body](const auto& text) { return body.contains(text); };
-    const auto body_matches = [body](const auto& pattern) {
-      return detail::regex_matches(body, pattern);
+    auto found = initial_literal_hits();
+    static_cast<void>(literal_matcher.scan(LiteralMatcher::start_state, body,
+                                           [&found](std::size_t index) { found[index] = true; }));
+    RegexSet::Scanner regex_scanner{regex_set};
+    regex_scanner.feed(body);
+    const auto matched = [this, body, &regex_scanner](std::size_t index) {
+      return regex_set.supports(index) ? regex_scanner.matched(index)
+                                       : detail::regex_matches(body, regexes[index]);
     };
 
-    return std::ranges::all_of(required_literals, body_contains) &&
-           std::ranges::all_of(required_regexes, body_matches) &&
-           std::ranges::none_of(rejected_literals, body_contains) &&
-           std::ranges::none_of(rejected_regexes, body_matches);
+    return literals_accept(found) && required_regexes_found(matched) &&
+           !rejected_regex_found(matched);
   }
 
 private:
+  friend class ContentScan;
+
+  /// Returns one flag per literal, indexed required-then-rejected; empty literals always match.
+  [[nodiscard]] std::vector<bool> initial_literal_hits() const {
+    std::vector<bool> found;
+    found.reserve(required_literals.size() + rejected_literals.size());
+    for (const auto* literals : {&required_literals, &rejected_literals}) {
+      std::ranges::transform(*literals, std::back_inserter(found),
+                             [](const auto& literal) { return literal.empty(); });
+    }
+    return found;
+  }
+
+  [[nodiscard]] bool required_literals_found(const std::vector<bool>& found) const {
+    return std::all_of(found.begin(), rejected_begin(found), [](bool value) { return value; });
+  }
+
+  [[nodiscard]] bool rejected_literal_found(const std::vector<bool>& found) const {
+    return std::any_of(rejected_begin(found), found.end(), [](bool value) { return value; });
+  }
+
+  [[nodiscard]] bool literals_accept(const std::vector<bool>& found) const {
+    return required_literals_found(found) && !rejected_literal_found(found);
+  }
+
+  [[nodiscard]] std::vector<bool>::const_iterator
+  rejected_begin(const std::vector<bool>& found) const {
+    return std::next(found.begin(), static_cast<std::ptrdiff_t>(required_literals.size()));
+  }
+
+  /// Regex indexes follow `regexes`: required patterns first, then rejected ones.
+  template <typename Matched> [[nodiscard]] bool required_regexes_found(Matched matched) const {
+    for (std::size_t index{}; index < required_patterns.size(); ++index) {
+      if (!matched(index)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <typename Matched> [[nodiscard]] bool rejected_regex_found(Matched matched) const {
+    for (auto index = required_patterns.size(); index < regexes.size(); ++index) {
+      if (matched(index)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Returns true when some filter could still reject a body that satisfied every requirement.
+  [[nodiscard]] bool has_rejections() const noexcept {
+    return !rejected_literals.empty() || !rejected_patterns.empty();
+  }
+
   std::vector<std::string> required_literals;
   std::vector<std::string> rejected_literals;
   std::vector<std::string> required_patterns;
   std::vector<std::string> rejected_patterns;
-  std::vector<boost::regex> required_regexes;
-  std::vector<boost::regex> rejected_regexes;
+  LiteralMatcher literal_matcher;
+  std::vector<boost::regex> regexes;
+  RegexSet regex_set;
+};
+
+/// Evaluates `ContentFilters` over a response body that arrives in chunks.
+///
+/// The literal automaton and regex DFA states are carried between chunks, so
+/// matches that straddle a chunk boundary are still found without re-scanning
+/// any bytes. Regexes outside the DFA subset use `detail::StreamingRegexSearch`.
+/// Call `finish` after the last chunk and before reading `accepts`.
+///
+/// The verdict can settle before the body ends. A rejected literal or regex
+/// match is final, so `rejected` lets callers abandon the transfer. When no
+/// rejected filters are configured, the body is `satisfied` as soon as every
+/// required filter has matched, and later chunks are not scanned at all.
+class ContentScan {
+public:
+  explicit ContentScan(const ContentFilters& content_filters)
+      : filters{content_filters}, literal_found{content_filters.initial_literal_hits()},
+        regex_scanner{content_filters.regex_set} {
+    fallback_regexes.reserve(filters.regexes.size());
+    for (std::size_t index{}; index < filters.regexes.size(); ++index) {
+      if (filters.regex_set.supports(index)) {
+        fallback_regexes.emplace_back();
+      } else {
+        fallback_regexes.emplace_back(std::in_place, filters.regexes[index]);
+      }
+    }
+    settle();
+  }
+
+  /// Scans the next body chunk unless the verdict has already settled.
+  void feed(std::string_view chunk) {
+    if (is_rejected || is_satisfied) {
+      return;
+    }
+    if (!literals_settled) {
+      literal_state = filters.literal_matcher.scan(
+          literal_state, chunk, [this](std::size_t index) { literal_found[index] = true; });
+    }
+    regex_scanner.feed(chunk);
+    for (auto& regex : fallback_regexes) {
+      if (regex) {
+        regex->feed(chunk);
+      }
+    }
+    settle();
+  }
+
+  /// Completes end-anchored fallback regex searches after the final chunk.
+  void finish() {
+    for (auto& regex : fallback_regexes) {
+      if (regex) {
+        regex->finish();
+      }
+    }
+  }
+
+  /// Returns true once a rejected filter has matched; no later chunk can change the outcome.
+  [[nodiscard]] bool rejected() const noexcept { return is_rejected; }
+
+  /// Returns true once every required filter has matched and nothing can reject the body.
+  [[nodiscard]] bool satisfied() const noexcept { return is_satisfied; }
+
+  /// Returns true when the scanned body satisfies all configured filters.
+  [[nodiscard]] bool accepts() const {
+    const auto matched = [this](std::size_t index) { return regex_matched(index); };
+    return filters.literals_accept(literal_found) && filters.required_regexes_found(matched) &&
+           !filters.rejected_regex_found(matched);
+  }
+
+private:
+  [[nodiscard]] bool regex_matched(std::size_t index) const {
+    const auto& fallback = fallback_regexes[index];
+    return fallback ? fallback->matched() : regex_scanner.matched(index);
+  }
+
+  void settle() {
+    const auto matched = [this](std::size_t index) { return regex_matched(index); };
+    const auto required_literals_done = filters.required_literals_found(literal_found);
+    is_rejected =
+        filters.rejected_literal_found(literal_found) || filters.rejected_regex_found(matched);
+    is_satisfied = !filters.has_rejections() && required_literals_done &&
+                   filters.required_regexes_found(matched);
+    literals_settled = filters.literal_matcher.empty() ||
+                       (required_literals_done && filters.rejected_literals.empty());
+  }
+
+  const ContentFilters& filters;
+  LiteralMatcher::State literal_state{LiteralMatcher::start_state};
+  std::vector<bool> literal_found;
+  RegexSet::Scanner regex_scanner;
+  std::vector<std::optional<detail::StreamingRegexSearch>> fallback_regexes;
+  bool literals_settled{};
+  bool is_rejected{};
+  bool is_satisfied{};
 };
 } // namespace abrade
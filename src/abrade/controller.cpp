@@ -4,31 +4,32 @@ namespace abrade {
 
 using namespace std;
 
+ostream& Controller::log() const {
+  // A stream without a buffer fails every write, so it discards them.
+  static ostream discarded{nullptr};
+  return is_muted ? discarded : cout;
+}
+
 FixedController::FixedController(size_t fixed_coroutines, size_t fixed_sampling_interval)
-    : start{chrono::steady_clock::now()}, coroutines{fixed_coroutines},
-      sampling_interval{fixed_sampling_interval}, completed{} {}
+    : Controller{fixed_sampling_interval}, coroutines{fixed_coroutines} {}
 
-void FixedController::register_completion(size_t current_coroutines) {
-  if (++completed < sampling_interval) {
-    return;
-  }
-  const auto end = chrono::steady_clock::now();
-  const chrono::duration<double> elapsed = end - start;
-  const auto velocity = static_cast<double>(completed) / static_cast<double>(elapsed.count());
-  cout << "[ ] Request velocity: " << velocity << " rps. Recommended coros (fixed): " << coroutines
-       << "; Current coros: " << current_coroutines << '\n';
-  start = end;
-  completed = 0;
+void FixedController::sample(double sample_velocity, size_t current_coroutines) {
+  velocity = sample_velocity;
+  record_sample(velocity, current_coroutines, coroutines);
+  log() << "[ ] Request velocity: " << velocity << " rps. Recommended coros (fixed): " << coroutines
+        << "; Current coros: " << current_coroutines << '\n';
 }
 
 size_t FixedController::recommended_coroutines() const noexcept { return coroutines; }
 
+double FixedController::measured_velocity() const noexcept { return velocity; }
+
 AdaptiveController::AdaptiveController(size_t initial_coroutines, size_t sample_size,
                                        size_t controller_sample_interval, size_t minimum_coroutines,
                                        size_t maximum_coroutines)
-    : coroutines{sample_size}, velocities{sample_size}, start{chrono::steady_clock::now()},
-      completed{}, sample_interval{controller_sample_interval}, recommended{initial_coroutines},
-      max_coro{maximum_coroutines}, min_coro{minimum_coroutines} {}
+    : Controller{controller_sample_interval}, coroutines{sample_size}, velocities{sample_size},
+      recommended{initial_coroutines}, max_coro{maximum_coroutines},
+      min_coro{minimum_coroutines} {}
 
 void AdaptiveController::increase_recommendation() noexcept {
   if (recommended < max_coro) {
@@ -36,18 +37,12 @@ void AdaptiveController::increase_recommendation() noexcept {
   }
 }
 
-void AdaptiveController::register_completion(size_t current_coroutines) {
-  if (++completed < sample_interval) {
-    return;
-  }
-  const auto end = chrono::steady_clock::now();
-  const chrono::duration<double> elapsed = end - start;
-  velocities.push_back(static_cast<double>(completed) / static_cast<double>(elapsed.count()));
+void AdaptiveController::sample(double sample_velocity, size_t current_coroutines) {
+  velocities.push_back(sample_velocity);
   coroutines.push_back(current_coroutines);
-  cout << "[ ] Request velocity: " << velocities.back()
-       << " rps. Concurrent requests: " << coroutines.back() << '\n';
-  start = end;
-  completed = 0;
+  record_sample(velocities.back(), current_coroutines, recommended);
+  log() << "[ ] Request velocity: " << velocities.back()
+        << " rps. Concurrent requests: " << coroutines.back() << '\n';
 
   if (velocities.size() < 2) {
     increase_recommendation();
@@ -89,4 +84,193 @@ void AdaptiveController::register_completion(size_t current_coroutines) {
 }
 
 size_t AdaptiveController::recommended_coroutines() const noexcept { return recommended; }
+
+double AdaptiveController::measured_velocity() const noexcept {
+  return velocities.empty() ? 0.0 : velocities.back();
+}
+
+AimdController::AimdController(const RunStats& run_stats, size_t initial_coroutines,
+                               size_t sample_size, size_t controller_sample_interval,
+                               size_t minimum_coroutines, size_t maximum_coroutines)
+    : Controller{controller_sample_interval}, stats{run_stats}, latencies{sample_size},
+      recommended{initial_coroutines}, increase{max<size_t>(initial_coroutines / 10U, 1U)},
+      max_coro{maximum_coroutines}, min_coro{minimum_coroutines},
+      // Stats may already hold earlier requests, such as a calibration sweep's; judge only ours.
+      finished_before{run_stats.candidates_finished()}, errors_before{run_stats.errors()},
+      timeouts_before{run_stats.timeouts()},
+      latency_count_before{run_stats.latency(Phase::first_byte).count()},
+      latency_sum_before{run_stats.latency(Phase::first_byte).sum()} {}
+
+string_view AimdController::detect_congestion() {
+  const auto finished = stats.candidates_finished() - finished_before;
+  const auto errors = stats.errors() - errors_before;
+  const auto timeouts = stats.timeouts() - timeouts_before;
+  const auto& ttfb = stats.latency(Phase::first_byte);
+  const auto responses = ttfb.count() - latency_count_before;
+  const auto waited = ttfb.sum() - latency_sum_before;
+  finished_before = stats.candidates_finished();
+  errors_before = stats.errors();
+  timeouts_before = stats.timeouts();
+  latency_count_before = ttfb.count();
+  latency_sum_before = ttfb.sum();
+
+  // The lowest recent mean stands in for the target's unloaded latency.
+  const auto baseline =
+      latencies.empty() ? 0.0 : *min_element(latencies.begin(), latencies.end());
+  const auto latency =
+      responses == 0U ? 0.0 : static_cast<double>(waited) / static_cast<double>(responses);
+  if (responses != 0U) {
+    latencies.push_back(latency);
+  }
+  const auto share = [finished](size_t count) {
+    return finished == 0U ? 0.0 : static_cast<double>(count) / static_cast<double>(finished);
+  };
+  if (share(timeouts) > timeout_threshold) {
+    return "timeouts";
+  }
+  if (share(errors) > error_threshold) {
+    return "errors";
+  }
+  if (baseline > 0.0 && latency > latency_threshold * baseline) {
+    return "latency";
+  }
+  return {};
+}
+
+void AimdController::sample(double sample_velocity, size_t current_coroutines) {
+  velocity = sample_velocity;
+  record_sample(velocity, current_coroutines, recommended);
+
+  const auto signal = detect_congestion();
+  log() << "[ ] Request velocity: " << velocity << " rps. Recommended coros (aimd): "
+        << recommended << "; Current coros: " << current_coroutines;
+  if (cooling_down) {
+    cooling_down = false;
+  } else if (!signal.empty()) {
+    const auto reduced = static_cast<double>(recommended) * decrease_factor;
+    recommended = max(static_cast<size_t>(reduced), min_coro);
+    slow_start = false;
+    cooling_down = true;
+    last_congestion = signal;
+    log() << "; backing off on " << signal;
+  } else if (current_coroutines * 10U >= recommended * 9U) {
+    recommended = min(slow_start ? recommended * 2U : recommended + increase, max_coro);
+  }
+  log() << '\n';
+}
+
+size_t AimdController::recommended_coroutines() const noexcept { return recommended; }
+
+double AimdController::measured_velocity() const noexcept { return velocity; }
+
+string_view AimdController::congestion() const noexcept { return last_congestion; }
+
+GradientController::GradientController(size_t initial_coroutines, size_t sample_size,
+                                       size_t controller_sample_interval, size_t minimum_coroutines,
+                                       size_t maximum_coroutines)
+    : Controller{controller_sample_interval}, delivery_rates{sample_size},
+      recommended{initial_coroutines}, max_coro{maximum_coroutines}, min_coro{minimum_coroutines},
+      rtt_expiry{sample_size} {}
+
+void GradientController::register_latency(chrono::steady_clock::duration latency) {
+  latency_sum += chrono::duration<double>{latency}.count();
+  latency_count++;
+}
+
+size_t GradientController::bounded(double target) const noexcept {
+  return clamp(static_cast<size_t>(llround(max(target, 0.0))), min_coro, max_coro);
+}
+
+void GradientController::adjust(size_t current_coroutines, double rtt) {
+  if (probing) {
+    // The queue drained for this sample, so its RTT is the target's, however it changed.
+    probing = false;
+    base_rtt = rtt;
+    rtt_age = 0;
+    recommended = probe_restore;
+    return;
+  }
+  if (base_rtt == 0.0 || rtt <= base_rtt) {
+    base_rtt = rtt;
+    rtt_age = 0;
+  } else {
+    rtt_age++;
+  }
+  const auto app_limited = current_coroutines * 10U < recommended * 9U;
+  if (startup) {
+    // Running out of candidates says nothing about where the rate levels off.
+    if (app_limited) {
+      return;
+    }
+    if (delivery_rates.back() >= startup_rate * startup_growth) {
+      startup_rate = delivery_rates.back();
+      startup_stalls = 0;
+      recommended = min(recommended * 2U, max_coro);
+      return;
+    }
+    if (++startup_stalls < startup_rounds) {
+      return;
+    }
+    startup = false;
+    recommended = bounded(bandwidth_delay_product());
+    return;
+  }
+  if (rtt_age >= rtt_expiry) {
+    probing = true;
+    probe_restore = recommended;
+    recommended = bounded(probe_gain * bandwidth_delay_product());
+    return;
+  }
+  const auto gradient = max(base_rtt / rtt, minimum_gradient);
+  const auto current = static_cast<double>(recommended);
+  auto target = min(gradient * current + sqrt(current), bdp_gain * bandwidth_delay_product());
+  if (app_limited) {
+    target = min(target, current);
+  }
+  recommended = bounded(target);
+}
+
+void GradientController::register_completion(size_t current_coroutines) {
+  coroutine_sum += static_cast<double>(current_coroutines);
+  coroutine_count++;
+  Controller::register_completion(current_coroutines);
+}
+
+void GradientController::sample(double sample_velocity, size_t current_coroutines) {
+  velocity = sample_velocity;
+  record_sample(velocity, current_coroutines, recommended);
+  const auto mean_coroutines = coroutine_sum / static_cast<double>(coroutine_count);
+  coroutine_sum = 0.0;
+  coroutine_count = 0;
+
+  log() << "[ ] Request velocity: " << velocity << " rps. Recommended coros (gradient): "
+        << recommended << "; Current coros: " << current_coroutines;
+  // A sample in which every candidate failed has no RTT to judge.
+  if (latency_count != 0U && latency_sum > 0.0) {
+    const auto rtt = latency_sum / static_cast<double>(latency_count);
+    delivery_rates.push_back(mean_coroutines / rtt);
+    adjust(current_coroutines, rtt);
+    log() << "; RTT: " << rtt * 1000.0 << " ms (min " << base_rtt * 1000.0
+          << " ms); BDP: " << bandwidth_delay_product();
+  }
+  latency_sum = 0.0;
+  latency_count = 0;
+  log() << '\n';
+}
+
+size_t GradientController::recommended_coroutines() const noexcept { return recommended; }
+
+double GradientController::measured_velocity() const noexcept { return velocity; }
+
+double GradientController::min_rtt() const noexcept { return base_rtt; }
+
+double GradientController::bandwidth_delay_product() const noexcept {
+  return delivery_rates.empty()
+             ? 0.0
+             : *max_element(delivery_rates.begin(), delivery_rates.end()) * base_rtt;
+}
+
+bool GradientController::in_startup() const noexcept { return startup; }
+
+bool GradientController::probing_rtt() const noexcept { return probing; }
 } // namespace abrade
@@ -1,29 +1,129 @@
 #pragma once
+#include <abrade/probes.hpp>
+#include <abrade/run_stats.hpp>
 #include <algorithm>
 #include <boost/circular_buffer.hpp>
 #include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <numeric>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace abrade {
 
+/// One controller measurement, kept so a run report can show how concurrency evolved.
+struct ControllerSample {
+  /// Seconds since the controller was created.
+  double seconds{};
+  /// Completions per second over the sampling interval.
+  double velocity{};
+  /// Active coroutines when the sample was taken.
+  size_t coroutines{};
+  /// Recommendation in force when the sample was taken.
+  size_t recommended{};
+};
+
 /// Chooses how many scraper coroutines should be active after each completion.
 ///
 /// The scraper consults the controller after every completed candidate. A
 /// controller may keep concurrency fixed or adapt it based on observed
-/// throughput.
+/// throughput or latency. Every velocity measurement is kept in `samples`.
+///
+/// Completions accumulate into a sample that closes after `sample_interval` of
+/// them. After `sample_on_ticks`, a sample instead closes on the first `tick`
+/// once it has at least that many, so a `ControllerTimer` can sample on
+/// wall-clock windows while slow targets still get enough completions to judge.
 struct Controller {
-  Controller() = default;
+  explicit Controller(size_t sample_interval) : completions_per_sample{sample_interval} {}
   Controller(const Controller&) = default;
   Controller(Controller&&) = default;
   Controller& operator=(const Controller&) = default;
   Controller& operator=(Controller&&) = default;
   virtual ~Controller() = default;
   /// Records a completed request and the current concurrency level.
-  virtual void register_completion(size_t current_coroutines) = 0;
+  virtual void register_completion(size_t current_coroutines) {
+    last_coroutines = current_coroutines;
+    if (++completions >= completions_per_sample && !timed) {
+      close_sample();
+    }
+  }
+  /// Records how long a candidate that succeeded took, just before its `register_completion`.
+  ///
+  /// Failed candidates report no latency: a refused connection is not a round
+  /// trip, and a timeout only measures the timeout. The default ignores it.
+  virtual void register_latency(std::chrono::steady_clock::duration /*latency*/) {}
   /// Returns the desired number of active request coroutines.
   virtual size_t recommended_coroutines() const noexcept = 0;
+  /// Returns the completion velocity, in requests per second, of the latest sample; 0 before one.
+  virtual double measured_velocity() const noexcept = 0;
+
+  /// Closes samples on `tick` instead of by count, once they hold `minimum_completions`.
+  void sample_on_ticks(size_t minimum_completions) noexcept {
+    completions_per_sample = minimum_completions;
+    timed = true;
+  }
+
+  /// Ends a wall-clock window; a sample short of its minimum stays open into the next one.
+  void tick() {
+    if (timed && completions != 0U && completions >= completions_per_sample) {
+      close_sample();
+    }
+  }
+
+  /// Returns every measurement taken so far, oldest first.
+  const std::vector<ControllerSample>& samples() const noexcept { return history; }
+
+  /// Stops printing a line per sample, as when a progress line reports the run; `samples` still
+  /// records each one.
+  void mute() noexcept { is_muted = true; }
+
+  /// Times samples with `source` from now on, as a simulator running in virtual time does.
+  void use_clock(std::function<std::chrono::steady_clock::time_point()> source) {
+    clock = std::move(source);
+    created = clock();
+    window_start = created;
+  }
+
+protected:
+  /// Acts on a closed sample's completions per second, with the concurrency at its last completion.
+  virtual void sample(double velocity, size_t current_coroutines) = 0;
+
+  /// Returns where per-sample diagnostics go: `std::cout`, or a discarding stream once muted.
+  std::ostream& log() const;
+
+  /// Appends a measurement to `samples` and fires the `controller` probe.
+  void record_sample(double velocity, size_t coroutines, size_t recommended) {
+    ABRADE_PROBE3(controller, coroutines, recommended, std::llround(velocity * 1000.0));
+    const std::chrono::duration<double> since_created = clock() - created;
+    history.push_back(ControllerSample{since_created.count(), velocity, coroutines, recommended});
+  }
+
+private:
+  void close_sample() {
+    const auto end = clock();
+    const std::chrono::duration<double> elapsed = end - window_start;
+    // Virtual clocks can close a window in no time at all.
+    const auto velocity =
+        elapsed.count() > 0.0 ? static_cast<double>(completions) / elapsed.count() : 0.0;
+    window_start = end;
+    completions = 0;
+    sample(velocity, last_coroutines);
+  }
+
+  std::function<std::chrono::steady_clock::time_point()> clock{
+      [] { return std::chrono::steady_clock::now(); }};
+  std::chrono::steady_clock::time_point created{clock()};
+  std::chrono::steady_clock::time_point window_start{created};
+  std::vector<ControllerSample> history;
+  size_t completions_per_sample, completions{}, last_coroutines{};
+  bool timed{};
+  bool is_muted{};
 };
 
 /// Keeps the scraper at a fixed concurrency level.
@@ -33,14 +133,16 @@ struct Controller {
 struct FixedController : Controller {
   explicit FixedController(size_t fixed_coroutines, size_t fixed_sampling_interval);
 
-  void register_completion(size_t current_coroutines) override;
-
   size_t recommended_coroutines() const noexcept override;
 
+  double measured_velocity() const noexcept override;
+
+protected:
+  void sample(double sample_velocity, size_t current_coroutines) override;
+
 private:
-  std::chrono::time_point<std::chrono::steady_clock> start;
-  const size_t coroutines, sampling_interval;
-  size_t completed;
+  const size_t coroutines;
+  double velocity{};
 };
 
 /// Adjusts concurrency using a simple velocity/concurrency trend estimate.
@@ -52,16 +154,135 @@ struct AdaptiveController : Controller {
                               size_t controller_sample_interval, size_t minimum_coroutines,
                               size_t maximum_coroutines);
 
-  void register_completion(size_t current_coroutines) override;
-
   size_t recommended_coroutines() const noexcept override;
 
+  double measured_velocity() const noexcept override;
+
+protected:
+  void sample(double sample_velocity, size_t current_coroutines) override;
+
 private:
   void increase_recommendation() noexcept;
 
   boost::circular_buffer<size_t> coroutines;
   boost::circular_buffer<double> velocities;
-  std::chrono::time_point<std::chrono::steady_clock> start;
-  size_t completed, sample_interval, recommended, max_coro, min_coro;
+  size_t recommended, max_coro, min_coro;
+};
+
+/// Adjusts concurrency with TCP-style additive increase and multiplicative decrease.
+///
+/// At every sample it looks at the candidates finished since the previous one.
+/// More than `error_threshold` of them failing, more than `timeout_threshold`
+/// timing out, or a mean time to first byte above `latency_threshold` times the
+/// lowest mean of the last `sample_size` samples is congestion: the recommendation is multiplied by
+/// `decrease_factor`, and the next sample is not judged so the cut can take
+/// effect. Otherwise the recommendation doubles per sample until the first
+/// congestion, like TCP slow start, and then grows by a tenth of the initial
+/// concurrency per sample. It only grows while the scraper keeps at least 90%
+/// of it active, so running out of candidates does not inflate it.
+struct AimdController : Controller {
+  static constexpr double error_threshold{0.05};
+  static constexpr double timeout_threshold{0.01};
+  static constexpr double latency_threshold{2.0};
+  static constexpr double decrease_factor{0.5};
+
+  explicit AimdController(const RunStats& run_stats, size_t initial_coroutines, size_t sample_size,
+                          size_t controller_sample_interval, size_t minimum_coroutines,
+                          size_t maximum_coroutines);
+
+  size_t recommended_coroutines() const noexcept override;
+
+  double measured_velocity() const noexcept override;
+
+  /// Returns the congestion signal behind the latest decrease, or an empty view before one.
+  std::string_view congestion() const noexcept;
+
+protected:
+  void sample(double sample_velocity, size_t current_coroutines) override;
+
+private:
+  /// Returns the congestion signal in the candidates finished since the previous sample, if any.
+  std::string_view detect_congestion();
+
+  const RunStats& stats;
+  boost::circular_buffer<double> latencies;
+  size_t recommended, increase, max_coro, min_coro;
+  size_t finished_before, errors_before, timeouts_before;
+  std::uint64_t latency_count_before, latency_sum_before;
+  double velocity{};
+  bool slow_start{true};
+  bool cooling_down{};
+  std::string_view last_congestion;
+};
+
+/// Sizes concurrency to the target's bandwidth-delay product, like TCP Vegas and BBR.
+///
+/// At every sample it takes the mean latency of the candidates that succeeded
+/// since the previous one as the current RTT, and the lowest such mean as the
+/// minimum RTT. By Little's law the delivery
+/// rate is the mean concurrency over the RTT, and the bandwidth-delay product
+/// is the highest delivery rate of the last `sample_size` samples times the
+/// minimum RTT: the concurrency that keeps the target busy without a queue.
+///
+/// During startup the recommendation doubles per sample until the delivery rate
+/// grows by less than `startup_growth` for `startup_rounds` samples in a row,
+/// then drops to the bandwidth-delay product to drain the queue doubling built.
+/// After that each sample moves it to `gradient * recommended +
+/// sqrt(recommended)`, where the gradient is the minimum RTT over the current
+/// RTT, floored at `minimum_gradient`: unchanged RTT probes up by the square
+/// root, and queueing shrinks it in proportion. It never exceeds `bdp_gain`
+/// times the bandwidth-delay product, and only grows while the scraper keeps at
+/// least 90% of it active.
+///
+/// A queue that never drains would hide the minimum RTT, so when `sample_size`
+/// samples pass without matching it, one sample runs at `probe_gain` times the
+/// bandwidth-delay product and its RTT becomes the new minimum.
+struct GradientController : Controller {
+  static constexpr double startup_growth{1.25};
+  static constexpr size_t startup_rounds{2};
+  static constexpr double minimum_gradient{0.5};
+  static constexpr double bdp_gain{2.0};
+  static constexpr double probe_gain{0.5};
+
+  explicit GradientController(size_t initial_coroutines, size_t sample_size,
+                              size_t controller_sample_interval, size_t minimum_coroutines,
+                              size_t maximum_coroutines);
+
+  void register_completion(size_t current_coroutines) override;
+
+  void register_latency(std::chrono::steady_clock::duration latency) override;
+
+  size_t recommended_coroutines() const noexcept override;
+
+  double measured_velocity() const noexcept override;
+
+  /// Returns the minimum RTT in seconds, or 0 before a sample with latencies.
+  double min_rtt() const noexcept;
+
+  /// Returns the estimated bandwidth-delay product in coroutines, or 0 before one.
+  double bandwidth_delay_product() const noexcept;
+
+  /// True until the delivery rate stops growing with concurrency.
+  bool in_startup() const noexcept;
+
+  /// True while a sample runs below the bandwidth-delay product to remeasure the minimum RTT.
+  bool probing_rtt() const noexcept;
+
+protected:
+  void sample(double sample_velocity, size_t current_coroutines) override;
+
+private:
+  /// Applies one sample's current RTT to the recommendation.
+  void adjust(size_t current_coroutines, double rtt);
+
+  /// Returns the recommendation nearest `target` within the configured bounds.
+  size_t bounded(double target) const noexcept;
+
+  boost::circular_buffer<double> delivery_rates;
+  size_t recommended, max_coro, min_coro, rtt_expiry;
+  size_t latency_count{}, coroutine_count{}, startup_stalls{}, rtt_age{}, probe_restore{};
+  double latency_sum{}, coroutine_sum{}, velocity{}, startup_rate{}, base_rtt{};
+  bool startup{true};
+  bool probing{};
 };
 } // namespace abrade
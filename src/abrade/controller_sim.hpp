@@ -0,0 +1,369 @@
+#pragma once
+
+#include <abrade/controller.hpp>
+#include <abrade/exception.hpp>
+#include <abrade/run_stats.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace abrade {
+
+/// A simulated target: a pool of workers in front of an unbounded FIFO queue.
+///
+/// A request waits in the queue until one of `capacity` workers is free, is
+/// served for `service_time` scaled by log-normal noise with mean 1, and its
+/// response arrives `round_trip` later. With a `cliff`, a request arriving
+/// while that many are already working or queued is refused after one round
+/// trip with probability `cliff_error_rate`, like a server shedding load.
+struct ServerModel {
+  /// Requests served at once.
+  std::size_t capacity{200};
+  /// Mean time a worker spends on one request.
+  std::chrono::milliseconds service_time{50};
+  /// Network time added to every response.
+  std::chrono::milliseconds round_trip{20};
+  /// Requests in the server past which it refuses new ones; 0 never refuses.
+  std::size_t cliff{};
+  /// Share of requests refused past the cliff.
+  double cliff_error_rate{};
+  /// Standard deviation of the service-time multiplier's logarithm; 0 serves in exactly
+  /// `service_time`.
+  double noise{};
+
+  /// Returns the throughput, in requests per second, of every worker kept busy.
+  [[nodiscard]] double ideal_throughput() const noexcept {
+    return static_cast<double>(capacity) /
+           std::chrono::duration<double>{service_time}.count();
+  }
+};
+
+/// A named `ServerModel` that every controller is benchmarked against.
+struct Scenario {
+  std::string_view name;
+  std::string_view description;
+  ServerModel server;
+};
+
+/// The standard scenarios of `abrade_controller_sim`, all reachable from the default `--init`.
+inline const std::array<Scenario, 4> scenarios{{
+    {"steady", "4000 rps behind 200 workers with 10% noise",
+     ServerModel{200, std::chrono::milliseconds{50}, std::chrono::milliseconds{20}, 0, 0.0, 0.1}},
+    {"cliff", "steady, but refusing half of all requests past 400 in the server",
+     ServerModel{200, std::chrono::milliseconds{50}, std::chrono::milliseconds{20}, 400, 0.5,
+                 0.1}},
+    {"slow", "20 rps behind 10 workers with 20% noise",
+     ServerModel{10, std::chrono::milliseconds{500}, std::chrono::milliseconds{50}, 0, 0.0, 0.2}},
+    {"noisy", "steady with 80% noise",
+     ServerModel{200, std::chrono::milliseconds{50}, std::chrono::milliseconds{20}, 0, 0.0, 0.8}},
+}};
+
+/// How `ControllerSimulation` drives a controller.
+struct SimulationSettings {
+  /// Virtual time simulated.
+  std::chrono::seconds duration{120};
+  /// Controller sampling window, as `--swin`; 0 leaves the controller sampling by count.
+  std::chrono::milliseconds sample_window{1000};
+  /// Fewest completions a timed sample closes with, as `--smin`.
+  std::size_t minimum_completions{20};
+  /// Time after which a request fails as a timeout, like the network timeout.
+  std::chrono::milliseconds timeout{30000};
+  /// Seed of the service-time and refusal draws; a seed always replays the same run.
+  std::uint64_t seed{1};
+};
+
+/// One second of a simulated scan.
+struct SimulatedSecond {
+  std::size_t successes{};
+  std::size_t errors{};
+  /// Sum of successful request latencies, in seconds.
+  double latency{};
+  /// Recommendation at the end of the second.
+  std::size_t recommended{};
+};
+
+/// What a controller achieved against a `ServerModel`.
+///
+/// The steady state is the last quarter of the run. Convergence is the first
+/// second from which the recommendation stays within 20% of its steady-state
+/// mean; a controller that never settles converges at the end of the run. An
+/// overload episode is a run of seconds in which more than 5% of candidates
+/// failed or the mean latency exceeded twice the unloaded service time plus
+/// round trip.
+struct SimulationResult {
+  double convergence_seconds{};
+  /// Successful requests per second in the steady state.
+  double throughput{};
+  /// `ServerModel::ideal_throughput`.
+  double ideal_throughput{};
+  /// Mean successful request latency in the steady state, in milliseconds.
+  double latency_ms{};
+  /// Mean recommendation in the steady state.
+  double concurrency{};
+  /// Half the spread of the recommendation in the steady state.
+  double oscillation{};
+  std::size_t overload_episodes{};
+  /// Share of all finished candidates that failed.
+  double error_rate{};
+  /// Every simulated second, in order.
+  std::vector<SimulatedSecond> seconds;
+};
+
+/// Drives a `Controller` against a `ServerModel` in deterministic virtual time.
+///
+/// Coroutines behave like the scraper's: each one starting a request first
+/// spawns more until the recommendation is active, and each one finishing a
+/// request reports it to the controller and exits while more than the
+/// recommendation are active. Successful requests report their latency and
+/// time to first byte; refusals and timeouts are recorded in `RunStats` as
+/// errors, so controllers that read it see the causes a real scan would.
+class ControllerSimulation {
+public:
+  ControllerSimulation(const ServerModel& server_model, const SimulationSettings& run_settings)
+      : server{server_model}, settings{run_settings}, random{run_settings.seed} {}
+
+  /// Runs `controller`, recording into the `stats` it may read, and summarizes the run.
+  ///
+  /// A simulation runs once; replaying a scenario takes a new one.
+  [[nodiscard]] SimulationResult run(Controller& controller, RunStats& stats) {
+    driven = &controller;
+    recorded = &stats;
+    controller.use_clock([this] { return now; });
+    if (settings.sample_window.count() != 0) {
+      controller.sample_on_ticks(settings.minimum_completions);
+      schedule(settings.sample_window, Event::tick);
+    }
+    schedule(std::chrono::seconds{1}, Event::second);
+    seconds.clear();
+    seconds.emplace_back();
+
+    active = 1;
+    start_request();
+    const auto end = epoch + settings.duration;
+    while (!events.empty() && events.top().at <= end) {
+      const auto event = events.top();
+      events.pop();
+      now = event.at;
+      handle(event);
+    }
+    return summarize();
+  }
+
+private:
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  struct Event {
+    enum Kind { served, response, refused, timed_out, tick, second };
+
+    TimePoint at;
+    std::uint64_t order;
+    Kind kind;
+    std::size_t request;
+
+    /// Orders the queue by time, then by scheduling order so ties replay identically.
+    bool operator>(const Event& other) const noexcept {
+      return at != other.at ? at > other.at : order > other.order;
+    }
+  };
+
+  struct Request {
+    TimePoint sent;
+    bool resolved{};
+  };
+
+  void schedule(std::chrono::steady_clock::duration delay, Event::Kind kind,
+                std::size_t request = 0) {
+    events.push(Event{now + delay, scheduled++, kind, request});
+  }
+
+  void handle(const Event& event) {
+    switch (event.kind) {
+    case Event::served:
+      serve_next();
+      schedule(server.round_trip, Event::response, event.request);
+      break;
+    case Event::response:
+      finish(event.request, nullptr);
+      break;
+    case Event::refused:
+      finish(event.request, &refusal);
+      break;
+    case Event::timed_out:
+      finish(event.request, &timeout);
+      break;
+    case Event::tick:
+      driven->tick();
+      schedule(settings.sample_window, Event::tick);
+      break;
+    case Event::second:
+      seconds.back().recommended = driven->recommended_coroutines();
+      seconds.emplace_back();
+      schedule(std::chrono::seconds{1}, Event::second);
+      break;
+    }
+  }
+
+  /// Spawns coroutines up to the recommendation, then sends this coroutine's request.
+  void start_request() {
+    std::size_t spawned{};
+    while (active < driven->recommended_coroutines()) {
+      active++;
+      spawned++;
+    }
+    for (std::size_t request{}; request <= spawned; ++request) {
+      send();
+    }
+  }
+
+  void send() {
+    const auto id = requests.size();
+    requests.push_back(Request{now});
+    recorded->record_candidate_started();
+    recorded->record_attempt();
+    schedule(settings.timeout, Event::timed_out, id);
+    const auto in_server = working + waiting.size();
+    if (server.cliff != 0U && in_server >= server.cliff &&
+        std::uniform_real_distribution<double>{}(random) < server.cliff_error_rate) {
+      schedule(server.round_trip, Event::refused, id);
+      return;
+    }
+    waiting.push(id);
+    if (working < server.capacity) {
+      working++;
+      serve_next();
+    }
+  }
+
+  /// Hands the oldest queued request to the worker that just became free, if any is queued.
+  void serve_next() {
+    if (waiting.empty()) {
+      working--;
+      return;
+    }
+    const auto id = waiting.front();
+    waiting.pop();
+    auto service = std::chrono::duration<double>{server.service_time}.count();
+    if (server.noise > 0.0) {
+      // Shifting the mean of the logarithm keeps the multiplier's mean at 1.
+      std::normal_distribution<double> logarithm{-server.noise * server.noise / 2.0, server.noise};
+      service *= std::exp(logarithm(random));
+    }
+    schedule(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                 std::chrono::duration<double>{service}),
+             Event::served, id);
+  }
+
+  void finish(std::size_t id, const ErrorCause* failure) {
+    auto& request = requests[id];
+    // A response after its timeout, or a timeout after its response, has nothing left to decide.
+    if (request.resolved) {
+      return;
+    }
+    request.resolved = true;
+    const auto latency = now - request.sent;
+    if (failure == nullptr) {
+      recorded->record_response(200);
+      recorded->record_phase(Phase::first_byte, latency);
+      driven->register_latency(latency);
+      seconds.back().successes++;
+      seconds.back().latency += std::chrono::duration<double>{latency}.count();
+    } else {
+      recorded->record_error(*failure);
+      seconds.back().errors++;
+    }
+    recorded->record_candidate_finished();
+    driven->register_completion(active);
+    if (active > driven->recommended_coroutines()) {
+      active--;
+      return;
+    }
+    start_request();
+  }
+
+  [[nodiscard]] SimulationResult summarize() {
+    // The second in progress when the run ended is partial.
+    seconds.pop_back();
+    SimulationResult result;
+    result.ideal_throughput = server.ideal_throughput();
+    if (seconds.empty()) {
+      return result;
+    }
+    const auto steady = seconds.size() - std::max<std::size_t>(seconds.size() / 4U, 1U);
+    std::size_t successes{}, total_successes{}, total_errors{};
+    double latency{}, concurrency{};
+    auto lowest = seconds[steady].recommended;
+    auto highest = lowest;
+    for (auto second = steady; second < seconds.size(); ++second) {
+      const auto& measured = seconds[second];
+      successes += measured.successes;
+      latency += measured.latency;
+      concurrency += static_cast<double>(measured.recommended);
+      lowest = std::min(lowest, measured.recommended);
+      highest = std::max(highest, measured.recommended);
+    }
+    const auto steady_seconds = static_cast<double>(seconds.size() - steady);
+    result.throughput = static_cast<double>(successes) / steady_seconds;
+    result.latency_ms = successes == 0U ? 0.0 : 1000.0 * latency / static_cast<double>(successes);
+    result.concurrency = concurrency / steady_seconds;
+    result.oscillation = static_cast<double>(highest - lowest) / 2.0;
+
+    const auto band = std::max(0.2 * result.concurrency, 1.0);
+    auto converged = seconds.size();
+    while (converged > 0U &&
+           std::abs(static_cast<double>(seconds[converged - 1U].recommended) -
+                    result.concurrency) <= band) {
+      converged--;
+    }
+    result.convergence_seconds = static_cast<double>(converged);
+
+    const auto unloaded = 2.0 * std::chrono::duration<double>{server.service_time +
+                                                              server.round_trip}
+                                    .count();
+    auto overloaded = false;
+    for (const auto& measured : seconds) {
+      const auto finished = measured.successes + measured.errors;
+      const auto is_overloaded =
+          (finished != 0U &&
+           static_cast<double>(measured.errors) > 0.05 * static_cast<double>(finished)) ||
+          (measured.successes != 0U &&
+           measured.latency / static_cast<double>(measured.successes) > unloaded);
+      if (is_overloaded && !overloaded) {
+        result.overload_episodes++;
+      }
+      overloaded = is_overloaded;
+      total_successes += measured.successes;
+      total_errors += measured.errors;
+    }
+    const auto total = total_successes + total_errors;
+    result.error_rate =
+        total == 0U ? 0.0 : static_cast<double>(total_errors) / static_cast<double>(total);
+    result.seconds = seconds;
+    return result;
+  }
+
+  const ServerModel server;
+  const SimulationSettings settings;
+  std::mt19937_64 random;
+  const ErrorCause refusal{ErrorCause::of(std::runtime_error{"connection refused"})};
+  const ErrorCause timeout{ErrorCause::of(AbradeException::timeout("get query"))};
+  static constexpr TimePoint epoch{};
+  TimePoint now{epoch};
+  std::priority_queue<Event, std::vector<Event>, std::greater<>> events;
+  std::uint64_t scheduled{};
+  std::vector<Request> requests;
+  std::queue<std::size_t> waiting;
+  std::size_t working{}, active{};
+  std::vector<SimulatedSecond> seconds;
+  Controller* driven{};
+  RunStats* recorded{};
+};
+} // namespace abrade
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <abrade/controller.hpp>
+#include <abrade/periodic_timer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <cstddef>
+
+namespace abrade {
+
+/// Samples a controller on wall-clock windows instead of every so many completions.
+///
+/// Every `window` a `PeriodicTimer` ticks the controller, which closes a sample
+/// once it holds `minimum_completions`. A window with fewer stays open into the
+/// next, so a slow target is judged on enough completions and a fast one is not
+/// judged on sub-second noise. Call `stop` once the scan finishes.
+class ControllerTimer {
+public:
+  ControllerTimer(boost::asio::io_context& io_context, Controller& sampled,
+                  std::chrono::milliseconds window, std::size_t minimum_completions)
+      : ticker{io_context, window, [&sampled] { sampled.tick(); }} {
+    sampled.sample_on_ticks(minimum_completions);
+  }
+
+  /// Schedules the first window.
+  void start() { ticker.start(); }
+
+  /// Cancels pending windows.
+  void stop() { ticker.stop(); }
+
+private:
+  PeriodicTimer ticker;
+};
+} // namespace abrade
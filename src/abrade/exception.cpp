@@ -2,8 +2,49 @@
 
 namespace abrade {
 
-AbradeException::AbradeException(const std::string& msg) : runtime_error{msg} {}
+AbradeException::AbradeException(const std::string& msg) : runtime_error{msg}, failed_action{msg} {}
 
 AbradeException::AbradeException(const std::string& msg, const boost::system::error_code& ec)
-    : runtime_error{msg + "; Code " + std::to_string(ec.value()) + "; Message " + ec.message()} {}
+    : runtime_error{msg + "; Code " + std::to_string(ec.value()) + "; Message " + ec.message()},
+      failed_action{msg}, error{ec} {}
+
+AbradeException AbradeException::timeout(const std::string& action) {
+  AbradeException exception{action + " timeout"};
+  exception.failed_action = action;
+  exception.is_timeout = true;
+  return exception;
+}
+
+const std::string& AbradeException::action() const noexcept { return failed_action; }
+
+const boost::system::error_code& AbradeException::code() const noexcept { return error; }
+
+bool AbradeException::timed_out() const noexcept { return is_timeout; }
+
+ErrorCause ErrorCause::of(const std::exception& error) {
+  const auto* abrade_error = dynamic_cast<const AbradeException*>(&error);
+  if (abrade_error == nullptr) {
+    if (const auto* system_error = dynamic_cast<const boost::system::system_error*>(&error)) {
+      return ErrorCause{"candidate", system_error->code().category().name(),
+                        system_error->code().message()};
+    }
+    return ErrorCause{"candidate", "runtime", error.what()};
+  }
+  if (abrade_error->timed_out()) {
+    return ErrorCause{abrade_error->action(), "timeout", {}};
+  }
+  const auto& code = abrade_error->code();
+  if (!code) {
+    return ErrorCause{abrade_error->action(), "abrade", {}};
+  }
+  return ErrorCause{abrade_error->action(), code.category().name(), code.message()};
+}
+
+std::string ErrorCause::label() const {
+  auto formatted = action + " (" + category;
+  if (!reason.empty()) {
+    formatted += ": " + reason;
+  }
+  return formatted + ")";
+}
 } // namespace abrade
@@ -1,5 +1,7 @@
 #pragma once
 #include <boost/system/system_error.hpp>
+#include <compare>
+#include <exception>
 #include <stdexcept>
 #include <string>
 
@@ -8,9 +10,48 @@ namespace abrade {
 /// Application exception that carries Abrade context and optional Boost system errors.
 ///
 /// Networking and parser helpers throw this when the caller should see
-/// product-level context rather than a raw library exception.
+/// product-level context rather than a raw library exception. The failed
+/// action, error code, and whether the network timeout fired stay available
+/// separately so failures can be grouped by `ErrorCause`.
 struct AbradeException : std::runtime_error {
   explicit AbradeException(const std::string& msg);
   AbradeException(const std::string& msg, const boost::system::error_code& ec);
+
+  /// Builds the exception thrown when `action` did not finish within the network timeout.
+  [[nodiscard]] static AbradeException timeout(const std::string& action);
+
+  /// Returns the failed action, such as `tcp connect`, without error-code text.
+  [[nodiscard]] const std::string& action() const noexcept;
+  /// Returns the error code the action failed with; empty when there was none.
+  [[nodiscard]] const boost::system::error_code& code() const noexcept;
+  /// Returns true when the network timeout cancelled the action.
+  [[nodiscard]] bool timed_out() const noexcept;
+
+private:
+  std::string failed_action;
+  boost::system::error_code error;
+  bool is_timeout{};
+};
+
+/// Why a candidate failed, coarse enough to count.
+///
+/// `action` is the operation that failed, which for network errors is the
+/// phase name passed to the timeout helpers. `category` is the error code's
+/// category (`system`, `asio.ssl`, `beast.http`, ...), `timeout` when the
+/// network timeout fired, `abrade` for protocol failures without a code, and
+/// `runtime` for any other exception. `reason` is the error code's message, or
+/// the exception text for `runtime`; other exceptions have the action `candidate`.
+struct ErrorCause {
+  /// Classifies a failure caught by the scraper.
+  [[nodiscard]] static ErrorCause of(const std::exception& error);
+
+  /// Formats the cause as `action (category: reason)` for the run summary.
+  [[nodiscard]] std::string label() const;
+
+  auto operator<=>(const ErrorCause&) const = default;
+
+  std::string action;
+  std::string category;
+  std::string reason;
 };
 } // namespace abrade
@@ -8,6 +8,7 @@
 #include <limits>
 #include <numeric>
 #include <stdexcept>
+#include <utility>
 
 namespace abrade {
 
@@ -232,6 +233,15 @@ std::optional<string> StdinGenerator::next() {
   return nullopt;
 }
 
+ListGenerator::ListGenerator(vector<string> list_targets) : targets{std::move(list_targets)} {}
+
+std::optional<string> ListGenerator::next() {
+  if (index == targets.size()) {
+    return nullopt;
+  }
+  return targets[index++];
+}
+
 std::optional<string> UriGenerator::next() {
   if (is_complete) {
     return nullopt;
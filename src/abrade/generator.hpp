@@ -38,6 +38,19 @@ private:
   bool is_complete{};
 };
 
+/// Generates a fixed list of URI targets in order.
+///
+/// Used for internally derived candidates, such as soft-404 calibration
+/// targets, that must run through the same scraper as user candidates.
+struct ListGenerator : Generator {
+  explicit ListGenerator(std::vector<std::string> list_targets);
+  std::optional<std::string> next() override;
+
+private:
+  std::vector<std::string> targets;
+  size_t index{};
+};
+
 /// Parsed brace token inside a URI pattern template.
 ///
 /// This is an internal parser value used while building `UriGenerator`. `start`
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <abrade/http_status.hpp>
+#include <boost/beast/http/field.hpp>
+#include <boost/beast/http/verb.hpp>
+#include <cstddef>
+
+namespace abrade {
+
+/// Request shape used instead of HEAD: a GET for the first body byte only.
+struct RangedGet {
+  /// Applies GET with `Range: bytes=0-0`, so a cooperating server sends at most one body byte.
+  template <typename Request> static void set_method(Request& request) {
+    request.method(boost::beast::http::verb::get);
+    request.set(boost::beast::http::field::range, "bytes=0-0");
+  }
+};
+
+/// Decides when a HEAD scan must fall back to ranged GETs for the rest of the run.
+///
+/// A HEAD answered with 405 or 501 is always rechecked with a `RangedGet`, and
+/// so are the first `verification_budget` other HEAD answers of 400 or above.
+/// The run switches to ranged GETs once a recheck shows that the server rejects
+/// HEAD or answers it with a miss where GET succeeds. Switching is one-way.
+/// Abrade scans one host per run, so this state is per host.
+class HeadFallback {
+public:
+  /// Number of ordinary HEAD misses rechecked with GET before trusting HEAD.
+  static constexpr std::size_t verification_budget{8};
+
+  explicit HeadFallback(bool is_enabled) noexcept
+      : enabled{is_enabled}, verifications_left{is_enabled ? verification_budget : 0U} {}
+
+  /// Returns true once requests should be sent as ranged GETs instead of HEAD.
+  [[nodiscard]] bool active() const noexcept { return is_active; }
+
+  /// Returns true when a HEAD answer should be rechecked with a ranged GET.
+  [[nodiscard]] bool should_recheck(unsigned int head_status) noexcept {
+    if (!enabled) {
+      return false;
+    }
+    if (rejects_head(head_status)) {
+      return true;
+    }
+    if (is_active || verifications_left == 0U || head_status < 400U) {
+      return false;
+    }
+    verifications_left--;
+    return true;
+  }
+
+  /// Records a recheck outcome and returns true when it switched the run to ranged GETs.
+  bool observe(unsigned int head_status, unsigned int get_status) noexcept {
+    const auto disagrees = (rejects_head(head_status) && !rejects_head(get_status)) ||
+                           (!is_success_status(head_status) && is_success_status(get_status));
+    return disagrees && activate();
+  }
+
+  /// Switches the run to ranged GETs and returns true when it was not already switched.
+  bool activate() noexcept {
+    if (is_active || !enabled) {
+      return false;
+    }
+    is_active = true;
+    return true;
+  }
+
+  /// Returns true for statuses servers use to refuse the HEAD method.
+  [[nodiscard]] static bool rejects_head(unsigned int status_code) noexcept {
+    return status_code == 405U || status_code == 501U;
+  }
+
+private:
+  bool enabled;
+  bool is_active{};
+  std::size_t verifications_left;
+};
+} // namespace abrade
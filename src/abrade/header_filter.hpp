@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <boost/beast/http/field.hpp>
+#include <boost/regex.hpp>
+#include <charconv>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace abrade {
+
+namespace detail {
+[[nodiscard]] inline std::string lowercase(std::string_view text) {
+  std::string result{text};
+  std::ranges::transform(result, result.begin(), [](char element) {
+    return element >= 'A' && element <= 'Z' ? static_cast<char>(element - 'A' + 'a') : element;
+  });
+  return result;
+}
+
+/// Returns the media type of a Content-Type value, without parameters or surrounding space.
+[[nodiscard]] inline std::string media_type(std::string_view value) {
+  value = value.substr(0, value.find(';'));
+  const auto first = value.find_first_not_of(" \t");
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const auto last = value.find_last_not_of(" \t");
+  return lowercase(value.substr(first, last - first + 1U));
+}
+} // namespace detail
+
+/// Repeatable filters applied to 2xx response headers before any body is read.
+///
+/// Content types are compared case-insensitively on the media type, and a
+/// configured `type/*` matches any subtype; a response without Content-Type fails
+/// a content-type filter. The Content-Length range is inclusive; a response
+/// that does not declare its length passes the header check, and GET applies
+/// the range to the body actually received instead. Header regexes are searched
+/// in each `Name: value` field line: a required regex must match some field and a
+/// rejected regex must match none.
+struct HeaderFilters {
+  static constexpr auto unbounded_length = std::numeric_limits<std::uint64_t>::max();
+
+  HeaderFilters() = default;
+
+  HeaderFilters(const std::vector<std::string>& content_type_text, std::uint64_t min_length,
+                std::uint64_t max_length, const std::vector<std::string>& required_regex_text,
+                const std::vector<std::string>& rejected_regex_text)
+      : minimum_length{min_length}, maximum_length{max_length} {
+    std::ranges::transform(content_type_text, std::back_inserter(content_types),
+                           [](const auto& type) { return detail::media_type(type); });
+    std::ranges::transform(required_regex_text, std::back_inserter(required_regexes),
+                           [](const auto& pattern) { return boost::regex{pattern}; });
+    std::ranges::transform(rejected_regex_text, std::back_inserter(rejected_regexes),
+                           [](const auto& pattern) { return boost::regex{pattern}; });
+  }
+
+  /// Returns true when no header filters are configured.
+  [[nodiscard]] bool empty() const noexcept {
+    return content_types.empty() && minimum_length == 0U &&
+           maximum_length == unbounded_length && required_regexes.empty() &&
+           rejected_regexes.empty();
+  }
+
+  /// Returns true when a response header passes every configured filter.
+  template <typename Fields> [[nodiscard]] bool accepts(const Fields& header) const {
+    if (!content_types.empty()) {
+      const auto found = header.find(boost::beast::http::field::content_type);
+      if (found == header.end() ||
+          !content_type_accepts(std::string_view{found->value().data(), found->value().size()})) {
+        return false;
+      }
+    }
+    if (const auto length = declared_length(header); length && !length_accepts(*length)) {
+      return false;
+    }
+    const auto line_matches = [&header](const boost::regex& pattern) {
+      return std::ranges::any_of(header, [&pattern](const auto& field) {
+        std::string line{field.name_string().data(), field.name_string().size()};
+        line.append(": ");
+        line.append(field.value().data(), field.value().size());
+        return boost::regex_search(line, pattern);
+      });
+    };
+    return std::ranges::all_of(required_regexes, line_matches) &&
+           std::ranges::none_of(rejected_regexes, line_matches);
+  }
+
+  /// Returns true when a body of `length` bytes lies inside the configured range.
+  [[nodiscard]] bool length_accepts(std::uint64_t length) const noexcept {
+    return length >= minimum_length && length <= maximum_length;
+  }
+
+  /// Returns true once `length` bytes already exceed the configured maximum.
+  [[nodiscard]] bool exceeds_length(std::uint64_t length) const noexcept {
+    return length > maximum_length;
+  }
+
+  /// Returns the representation length a header declares, if it declares a valid one.
+  ///
+  /// A partial response declares the full length after the `/` of its Content-Range;
+  /// anything else declares it in Content-Length.
+  template <typename Fields>
+  [[nodiscard]] static std::optional<std::uint64_t> declared_length(const Fields& header) {
+    if (const auto range = header.find(boost::beast::http::field::content_range);
+        range != header.end()) {
+      const std::string_view value{range->value().data(), range->value().size()};
+      const auto slash = value.rfind('/');
+      return slash == std::string_view::npos ? std::nullopt
+                                             : parse_length(value.substr(slash + 1U));
+    }
+    const auto found = header.find(boost::beast::http::field::content_length);
+    if (found == header.end()) {
+      return std::nullopt;
+    }
+    return parse_length(std::string_view{found->value().data(), found->value().size()});
+  }
+
+private:
+  [[nodiscard]] static std::optional<std::uint64_t> parse_length(std::string_view value) {
+    std::uint64_t length{};
+    const auto* const end = value.data() + value.size();
+    const auto [parsed_end, ec] = std::from_chars(value.data(), end, length);
+    if (ec != std::errc{} || parsed_end != end) {
+      return std::nullopt;
+    }
+    return length;
+  }
+
+  [[nodiscard]] bool content_type_accepts(std::string_view value) const {
+    const auto type = detail::media_type(value);
+    return std::ranges::any_of(content_types, [&type](const auto& configured) {
+      if (configured.ends_with("/*")) {
+        return type.starts_with(std::string_view{configured}.substr(0, configured.size() - 1U));
+      }
+      return type == configured;
+    });
+  }
+
+  std::vector<std::string> content_types;
+  std::uint64_t minimum_length{};
+  std::uint64_t maximum_length{unbounded_length};
+  std::vector<boost::regex> required_regexes;
+  std::vector<boost::regex> rejected_regexes;
+};
+} // namespace abrade
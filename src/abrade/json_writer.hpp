@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace abrade {
+
+namespace detail {
+template <typename Value> struct is_optional : std::false_type {};
+template <typename Value> struct is_optional<std::optional<Value>> : std::true_type {};
+
+/// Streams compact JSON, inserting the commas between members and elements.
+///
+/// Only the shapes Abrade's reports need are supported: objects, arrays, strings,
+/// booleans, integers, doubles, optionals (empty ones become `null`), and
+/// string vectors. Non-finite doubles become `null`.
+class JsonWriter {
+public:
+  explicit JsonWriter(std::ostream& output) : out{output} {}
+
+  void begin_object(std::string_view name = {}) { open(name, '{'); }
+  void end_object() { close('}'); }
+  void begin_array(std::string_view name = {}) { open(name, '['); }
+  void end_array() { close(']'); }
+
+  /// Writes `"name": value` inside an object.
+  template <typename Value> void member(std::string_view name, const Value& value) {
+    key(name);
+    element(value);
+  }
+
+  /// Writes one value inside an array, or the value of the pending member.
+  template <typename Value> void element(const Value& value) {
+    separate();
+    if constexpr (is_optional<Value>::value) {
+      if (value) {
+        is_pending_value = true;
+        element(*value);
+      } else {
+        out << "null";
+      }
+    } else if constexpr (std::is_same_v<Value, bool>) {
+      out << (value ? "true" : "false");
+    } else if constexpr (std::is_integral_v<Value>) {
+      out << value;
+    } else if constexpr (std::is_floating_point_v<Value>) {
+      number(static_cast<double>(value));
+    } else if constexpr (std::is_convertible_v<const Value&, std::string_view>) {
+      string(value);
+    } else {
+      out << '[';
+      firsts.push_back(true);
+      for (const auto& item : value) {
+        element(item);
+      }
+      close(']');
+    }
+  }
+
+private:
+  void open(std::string_view name, char bracket) {
+    if (!name.empty()) {
+      key(name);
+    }
+    separate();
+    out << bracket;
+    firsts.push_back(true);
+  }
+
+  void close(char bracket) {
+    firsts.pop_back();
+    out << bracket;
+  }
+
+  void key(std::string_view name) {
+    separate();
+    string(name);
+    out << ':';
+    is_pending_value = true;
+  }
+
+  void separate() {
+    if (is_pending_value) {
+      is_pending_value = false;
+      return;
+    }
+    if (firsts.empty()) {
+      return;
+    }
+    if (firsts.back()) {
+      firsts.back() = false;
+    } else {
+      out << ',';
+    }
+  }
+
+  void number(double value) {
+    if (!std::isfinite(value)) {
+      out << "null";
+      return;
+    }
+    std::array<char, 32> digits{};
+    const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value);
+    out << std::string_view{digits.data(), static_cast<std::size_t>(result.ptr - digits.data())};
+  }
+
+  void string(std::string_view text) {
+    out << '"';
+    for (const auto character : text) {
+      switch (character) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      case '\r':
+        out << "\\r";
+        break;
+      case '\t':
+        out << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(character) < 0x20U) {
+          constexpr std::string_view hex{"0123456789abcdef"};
+          const std::size_t code{static_cast<unsigned char>(character)};
+          out << "\\u00" << hex[code >> 4U] << hex[code & 0xFU];
+        } else {
+          out << character;
+        }
+      }
+    }
+    out << '"';
+  }
+
+  std::ostream& out;
+  std::vector<bool> firsts;
+  bool is_pending_value{};
+};
+} // namespace detail
+} // namespace abrade
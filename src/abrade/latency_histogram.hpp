@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace abrade {
+
+/// Fixed-size log-linear latency histogram in the style of HdrHistogram.
+///
+/// Values are microseconds. Each power of two is split into `sub_buckets`
+/// linear buckets, so a reported percentile is within 1/`sub_buckets` (6.25%)
+/// of the true value across the whole 64-bit range. Recording is one index
+/// computation and an increment; no allocation happens after construction.
+class LatencyHistogram {
+public:
+  /// Linear buckets per power of two.
+  static constexpr std::uint64_t sub_buckets{16};
+  /// Number of low bits that select a linear bucket.
+  static constexpr int sub_bucket_bits{4};
+
+  /// Records one latency sample; negative durations count as zero.
+  void record(std::chrono::steady_clock::duration elapsed) noexcept {
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    const auto value = micros > 0 ? static_cast<std::uint64_t>(micros) : std::uint64_t{};
+    counts[index_of(value)]++;
+    total++;
+    sum_of_values += value;
+    largest = std::max(largest, value);
+  }
+
+  /// Returns the number of recorded samples.
+  [[nodiscard]] std::uint64_t count() const noexcept { return total; }
+
+  /// Returns the largest recorded sample in microseconds.
+  [[nodiscard]] std::uint64_t max() const noexcept { return largest; }
+
+  /// Returns the sum of all recorded samples in microseconds.
+  [[nodiscard]] std::uint64_t sum() const noexcept { return sum_of_values; }
+
+  /// Returns how many samples fall at or below `value` microseconds.
+  ///
+  /// Samples that share `value`'s bucket count as below it, so the result may
+  /// include samples up to 6.25% above `value`.
+  [[nodiscard]] std::uint64_t count_at_or_below(std::uint64_t value) const noexcept {
+    std::uint64_t seen{};
+    for (std::size_t index{}; index <= index_of(value); ++index) {
+      seen += counts[index];
+    }
+    return seen;
+  }
+
+  /// Returns the value, in microseconds, at or below which `quantile` of the samples fall.
+  ///
+  /// Like HdrHistogram, this reports the highest value that shares the bucket of
+  /// the sample at that rank, capped at the largest recorded sample. Returns zero
+  /// when no samples were recorded.
+  [[nodiscard]] std::uint64_t percentile(double quantile) const noexcept {
+    if (total == 0U) {
+      return 0U;
+    }
+    const auto rank = std::max<std::uint64_t>(
+        1U, static_cast<std::uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) *
+                                                 static_cast<double>(total))));
+    std::uint64_t seen{};
+    for (std::size_t index{}; index < counts.size(); ++index) {
+      seen += counts[index];
+      if (seen >= rank) {
+        return std::min(highest_in_bucket(index), largest);
+      }
+    }
+    return largest;
+  }
+
+private:
+  static_assert(sub_buckets == std::uint64_t{1} << sub_bucket_bits);
+  /// Values below `sub_buckets` map one-to-one; each higher octave adds `sub_buckets` buckets.
+  static constexpr std::size_t bucket_count{sub_buckets *
+                                            static_cast<std::uint64_t>(65 - sub_bucket_bits)};
+
+  static std::size_t index_of(std::uint64_t value) noexcept {
+    if (value < sub_buckets) {
+      return static_cast<std::size_t>(value);
+    }
+    const auto shift = std::bit_width(value) - 1 - sub_bucket_bits;
+    const auto sub_bucket = (value >> shift) - sub_buckets;
+    return static_cast<std::size_t>(sub_buckets * static_cast<std::uint64_t>(shift + 1) +
+                                    sub_bucket);
+  }
+
+  static std::uint64_t highest_in_bucket(std::size_t index) noexcept {
+    if (index < sub_buckets) {
+      return index;
+    }
+    const auto shift = index / sub_buckets - 1U;
+    const auto lowest = (sub_buckets + index % sub_buckets) << shift;
+    return lowest + ((std::uint64_t{1} << shift) - 1U);
+  }
+
+  std::array<std::uint64_t, bucket_count> counts{};
+  std::uint64_t total{};
+  std::uint64_t largest{};
+  std::uint64_t sum_of_values{};
+};
+} // namespace abrade
@@ -0,0 +1,92 @@
+#include <abrade/literal_matcher.hpp>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+
+namespace abrade {
+
+using namespace std;
+
+namespace {
+constexpr auto missing_state = numeric_limits<LiteralMatcher::State>::max();
+} // namespace
+
+LiteralMatcher::LiteralMatcher(const vector<string>& literals) {
+  // Bytes that appear in no literal share class 0, which keeps the table narrow.
+  size_t next_class{1};
+  for (const auto& literal : literals) {
+    for (const auto element : literal) {
+      auto& byte_class = byte_classes.at(static_cast<unsigned char>(element));
+      if (byte_class == 0U) {
+        byte_class = static_cast<uint16_t>(next_class++);
+      }
+    }
+  }
+  if (next_class == 1U) {
+    return;
+  }
+  class_count = next_class;
+
+  // Build the trie of goto edges.
+  vector<State> edges(class_count, missing_state);
+  vector<vector<uint32_t>> outputs(1);
+  for (size_t index{}; index < literals.size(); ++index) {
+    const auto& literal = literals[index];
+    if (literal.empty()) {
+      continue;
+    }
+    size_t state{};
+    for (const auto element : literal) {
+      const auto byte_class = byte_classes.at(static_cast<unsigned char>(element));
+      const auto edge = (state * class_count) + byte_class;
+      if (edges[edge] == missing_state) {
+        if (outputs.size() >= missing_state) {
+          throw runtime_error{"Literal set too large for matcher."};
+        }
+        edges[edge] = static_cast<State>(outputs.size());
+        outputs.emplace_back();
+        edges.resize(edges.size() + class_count, missing_state);
+      }
+      state = edges[edge];
+    }
+    outputs[state].push_back(static_cast<uint32_t>(index));
+  }
+
+  // Breadth-first failure links, folded into a complete transition table.
+  vector<State> failure(outputs.size(), start_state);
+  deque<State> pending;
+  for (size_t byte_class{}; byte_class < class_count; ++byte_class) {
+    auto& next = edges[byte_class];
+    if (next == missing_state) {
+      next = start_state;
+    } else {
+      pending.push_back(next);
+    }
+  }
+  while (!pending.empty()) {
+    const auto state = pending.front();
+    pending.pop_front();
+    const auto row = static_cast<size_t>(state) * class_count;
+    const auto failure_row = static_cast<size_t>(failure[state]) * class_count;
+    for (size_t byte_class{}; byte_class < class_count; ++byte_class) {
+      auto& next = edges[row + byte_class];
+      if (next == missing_state) {
+        next = edges[failure_row + byte_class];
+        continue;
+      }
+      failure[next] = edges[failure_row + byte_class];
+      const auto& inherited = outputs[failure[next]];
+      outputs[next].insert(outputs[next].end(), inherited.begin(), inherited.end());
+      pending.push_back(next);
+    }
+  }
+
+  transitions = std::move(edges);
+  output_offsets.reserve(outputs.size() + 1U);
+  for (const auto& state_outputs : outputs) {
+    output_offsets.push_back(static_cast<uint32_t>(output_literals.size()));
+    output_literals.insert(output_literals.end(), state_outputs.begin(), state_outputs.end());
+  }
+  output_offsets.push_back(static_cast<uint32_t>(output_literals.size()));
+}
+} // namespace abrade
@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace abrade {
+
+/// Aho-Corasick automaton that finds any number of literals in one pass over a body.
+///
+/// The automaton is compiled once from the configured literals. Failure links are
+/// folded into a dense transition table over byte equivalence classes, so `scan`
+/// costs one table lookup per input byte regardless of how many literals exist.
+/// Scanning is resumable: the returned state carries partial matches across
+/// chunk boundaries. Empty literals never produce callbacks; callers treat them as
+/// trivially present.
+class LiteralMatcher {
+public:
+  using State = std::uint32_t;
+
+  /// Root state used to start a scan.
+  static constexpr State start_state{0};
+
+  LiteralMatcher() = default;
+
+  /// Compiles the automaton; literal indexes are reported by `scan`.
+  explicit LiteralMatcher(const std::vector<std::string>& literals);
+
+  /// Returns true when no non-empty literal was compiled.
+  [[nodiscard]] bool empty() const noexcept { return transitions.empty(); }
+
+  /// Advances `state` over `text` and calls `on_match(index)` for every literal occurrence.
+  template <typename OnMatch>
+  [[nodiscard]] State scan(State state, std::string_view text, OnMatch&& on_match) const {
+    if (empty()) {
+      return state;
+    }
+    for (const auto element : text) {
+      state = transitions[(static_cast<std::size_t>(state) * class_count) +
+                          byte_classes[static_cast<unsigned char>(element)]];
+      for (auto output = output_offsets[state]; output < output_offsets[state + 1U]; ++output) {
+        on_match(static_cast<std::size_t>(output_literals[output]));
+      }
+    }
+    return state;
+  }
+
+private:
+  std::array<std::uint16_t, 256> byte_classes{};
+  std::size_t class_count{};
+  std::vector<State> transitions;
+  std::vector<std::uint32_t> output_offsets;
+  std::vector<std::uint32_t> output_literals;
+};
+} // namespace abrade
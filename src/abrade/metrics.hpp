@@ -0,0 +1,295 @@
+#pragma once
+
+#include <abrade/controller.hpp>
+#include <abrade/exception.hpp>
+#include <abrade/run_stats.hpp>
+#include <array>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
+#include <boost/beast/http.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace abrade {
+
+namespace detail {
+/// Upper bounds of the exported latency buckets, as microseconds and as their `le` label.
+struct LatencyBound {
+  std::uint64_t micros;
+  std::string_view label;
+};
+
+inline constexpr std::array<LatencyBound, 15> latency_bounds{
+    {{500, "0.0005"},
+     {1000, "0.001"},
+     {2500, "0.0025"},
+     {5000, "0.005"},
+     {10000, "0.01"},
+     {25000, "0.025"},
+     {50000, "0.05"},
+     {100000, "0.1"},
+     {250000, "0.25"},
+     {500000, "0.5"},
+     {1000000, "1.0"},
+     {2500000, "2.5"},
+     {5000000, "5.0"},
+     {10000000, "10.0"},
+     {30000000, "30.0"}}};
+
+/// Escapes a label value as OpenMetrics requires.
+inline std::string label_value(std::string_view value) {
+  std::string escaped;
+  for (const auto character : value) {
+    if (character == '\\' || character == '"') {
+      escaped.push_back('\\');
+      escaped.push_back(character);
+    } else if (character == '\n') {
+      escaped.append("\\n");
+    } else {
+      escaped.push_back(character);
+    }
+  }
+  return escaped;
+}
+
+/// Writes OpenMetrics families with their `# TYPE` and `# HELP` metadata.
+class OpenMetricsWriter {
+public:
+  explicit OpenMetricsWriter(std::ostringstream& output) : out{output} {}
+
+  template <typename Value>
+  void counter(std::string_view name, std::string_view help, Value value) {
+    family(name, "counter", help);
+    out << "abrade_" << name << "_total " << value << '\n';
+  }
+
+  template <typename Value> void gauge(std::string_view name, std::string_view help, Value value) {
+    family(name, "gauge", help);
+    out << "abrade_" << name << ' ' << value << '\n';
+  }
+
+  void family(std::string_view name, std::string_view type, std::string_view help) {
+    out << "# TYPE abrade_" << name << ' ' << type << '\n'
+        << "# HELP abrade_" << name << ' ' << help << '\n';
+  }
+
+private:
+  std::ostringstream& out;
+};
+} // namespace detail
+
+/// Formats a snapshot of a run as OpenMetrics text.
+///
+/// Every `RunStats` counter is a counter family, with responses also labelled by
+/// status code and errors by `ErrorCause`; in-flight candidates, coroutines
+/// waiting in each `CoroutineState`, worker threads, and the controller's
+/// recommendation and latest velocity are gauges; each `Phase` is one series of
+/// the `abrade_phase_latency_seconds` histogram.
+/// Buckets come from the `LatencyHistogram`, so a bucket may include samples up
+/// to 6.25% above its bound.
+[[nodiscard]] inline std::string openmetrics(const RunStats& stats, const Controller& controller) {
+  std::ostringstream out;
+  out.precision(9);
+  detail::OpenMetricsWriter metrics{out};
+  metrics.counter("requests", "HTTP requests sent, including redirect follow-ups.",
+                  stats.attempted());
+  metrics.counter("candidates_finished", "Candidates whose requests completed or failed.",
+                  stats.candidates_finished());
+  metrics.family("responses", "counter", "Completed HTTP responses by status class.");
+  out << "abrade_responses_total{class=\"2xx\"} " << stats.success_2xx() << '\n'
+      << "abrade_responses_total{class=\"other\"} " << stats.non_2xx() << '\n';
+  metrics.family("responses_by_status", "counter", "Completed HTTP responses by status code.");
+  for (const auto& [status_code, count] : stats.status_codes()) {
+    out << "abrade_responses_by_status_total{code=\"" << status_code << "\"} " << count << '\n';
+  }
+  metrics.counter("hits", "Candidates reported as found.", stats.hits());
+  metrics.counter("filtered_bodies", "2xx bodies rejected by content or length filters.",
+                  stats.filtered());
+  metrics.counter("header_filtered", "2xx responses rejected by header filters.",
+                  stats.header_filtered());
+  metrics.counter("soft_not_found", "2xx responses matching a learned soft 404.",
+                  stats.soft_not_found());
+  metrics.counter("near_duplicates", "Accepted bodies not written because their cluster was full.",
+                  stats.near_duplicates());
+  metrics.counter("probes", "HEAD probes answered in probe mode.", stats.probes());
+  metrics.counter("promotions", "Probe hits promoted to GET.", stats.promotions());
+  metrics.counter("head_fallbacks", "Ranged GETs sent in place of HEAD.", stats.head_fallbacks());
+  metrics.counter("head_rechecks", "Extra ranged GETs sent to verify HEAD answers.",
+                  stats.head_rechecks());
+  metrics.counter("errors", "Candidates that failed with a transport or runtime error.",
+                  stats.errors());
+  metrics.family("errors_by_cause", "counter", "Candidate failures by action and error category.");
+  for (const auto& [cause, count] : stats.error_causes()) {
+    out << "abrade_errors_by_cause_total{action=\"" << detail::label_value(cause.action)
+        << "\",category=\"" << detail::label_value(cause.category) << "\",reason=\""
+        << detail::label_value(cause.reason) << "\"} " << count << '\n';
+  }
+  metrics.counter("bytes_received", "Response-body bytes read from the network.",
+                  stats.bytes_received());
+  metrics.counter("bytes_written", "Response-body bytes written to disk.", stats.bytes_written());
+  metrics.counter("bodies_skipped", "Bodies abandoned after their header.",
+                  stats.bodies_skipped());
+  metrics.counter("bodies_aborted", "Bodies abandoned mid-transfer by a rejecting filter.",
+                  stats.bodies_aborted());
+  metrics.counter("bytes_avoided", "Declared body bytes never transferred.",
+                  stats.bytes_avoided());
+  metrics.counter("worker_jobs", "Body jobs finished by worker threads.", stats.worker_jobs());
+  metrics.counter("worker_waits", "Requests that waited for a free worker slot.",
+                  stats.worker_waits());
+  metrics.counter("worker_busy_seconds", "Time worker threads spent on body jobs.",
+                  std::chrono::duration<double>{stats.worker_busy()}.count());
+  metrics.gauge("in_flight", "Candidates currently being requested.", stats.in_flight());
+  metrics.family("coroutines_waiting", "gauge", "Coroutines waiting in each request state.");
+  for (std::size_t state{}; state < state_names.size(); ++state) {
+    out << "abrade_coroutines_waiting{state=\"" << state_names[state] << "\"} "
+        << stats.waiting(static_cast<CoroutineState>(state)) << '\n';
+  }
+  metrics.gauge("worker_threads", "Threads that filter and spool GET bodies.",
+                stats.worker_threads());
+  metrics.gauge("worker_queue_peak", "Most body jobs queued or running at once.",
+                stats.worker_queue_peak());
+  metrics.gauge("controller_recommended_coroutines", "Concurrency the controller asks for.",
+                controller.recommended_coroutines());
+  metrics.gauge("controller_velocity", "Completions per second in the latest controller sample.",
+                controller.measured_velocity());
+  metrics.gauge("elapsed_seconds", "Seconds since the run started.", stats.elapsed_seconds());
+
+  metrics.family("phase_latency_seconds", "histogram", "Latency of each request phase.");
+  for (std::size_t phase{}; phase < phase_names.size(); ++phase) {
+    const auto& histogram = stats.latency(static_cast<Phase>(phase));
+    const auto series = std::string{"abrade_phase_latency_seconds"};
+    for (const auto& bound : detail::latency_bounds) {
+      out << series << "_bucket{phase=\"" << phase_names[phase] << "\",le=\"" << bound.label
+          << "\"} " << histogram.count_at_or_below(bound.micros) << '\n';
+    }
+    out << series << "_bucket{phase=\"" << phase_names[phase] << "\",le=\"+Inf\"} "
+        << histogram.count() << '\n'
+        << series << "_count{phase=\"" << phase_names[phase] << "\"} " << histogram.count() << '\n'
+        << series << "_sum{phase=\"" << phase_names[phase] << "\"} "
+        << static_cast<double>(histogram.sum()) / 1e6 << '\n';
+  }
+  out << "# EOF\n";
+  return out.str();
+}
+
+/// Serves `openmetrics` over HTTP from the scraper's io_context.
+///
+/// `GET /metrics` answers with the current snapshot and every other target
+/// with 404. Each connection carries one request and is then closed, and idle
+/// clients are dropped after `idle_timeout`. Rendering happens only when a
+/// client asks, so an unscraped endpoint costs the run nothing beyond a pending
+/// accept. The accept keeps the io_context busy, so call `stop` once the scan
+/// finishes. A failed accept (such as running out of descriptors mid-scan)
+/// waits `accept_backoff` before retrying rather than spinning on the
+/// io_context the scan shares.
+class MetricsServer {
+public:
+  /// Seconds a client may take to send its request.
+  static constexpr std::chrono::seconds idle_timeout{5};
+  /// Pause before accepting again after an accept fails.
+  static constexpr std::chrono::milliseconds accept_backoff{100};
+
+  /// Binds `endpoint` or throws `AbradeException`; a zero port picks an ephemeral one.
+  MetricsServer(boost::asio::io_context& io_context, const boost::asio::ip::tcp::endpoint& endpoint,
+                const RunStats& run_stats, const Controller& run_controller)
+      : ios{io_context}, acceptor{io_context}, backoff{io_context}, stats{run_stats},
+        controller{run_controller} {
+    boost::system::error_code ec;
+    acceptor.open(endpoint.protocol(), ec);
+    if (!ec) {
+      acceptor.set_option(boost::asio::socket_base::reuse_address{true}, ec);
+    }
+    if (!ec) {
+      acceptor.bind(endpoint, ec);
+    }
+    if (!ec) {
+      acceptor.listen(boost::asio::socket_base::max_listen_connections, ec);
+    }
+    if (ec) {
+      throw AbradeException{"metrics listen", ec};
+    }
+  }
+
+  /// Starts accepting scrapes.
+  void start() {
+    boost::asio::spawn(
+        ios, [this](const boost::asio::yield_context& yield) { accept(yield); },
+        boost::asio::detached);
+  }
+
+  /// Stops accepting; connections already accepted finish their response.
+  void stop() {
+    boost::system::error_code ignored;
+    acceptor.close(ignored);
+    backoff.cancel();
+  }
+
+  /// Returns the bound address and port.
+  [[nodiscard]] boost::asio::ip::tcp::endpoint local_endpoint() const {
+    return acceptor.local_endpoint();
+  }
+
+private:
+  void accept(const boost::asio::yield_context& yield) {
+    while (acceptor.is_open()) {
+      boost::asio::ip::tcp::socket socket{ios};
+      boost::system::error_code ec;
+      acceptor.async_accept(socket, yield[ec]);
+      if (ec == boost::asio::error::operation_aborted) {
+        return;
+      }
+      if (ec) {
+        backoff.expires_after(accept_backoff);
+        backoff.async_wait(yield[ec]);
+        continue;
+      }
+      boost::asio::spawn(
+          ios,
+          [this, client = std::move(socket)](const boost::asio::yield_context& session) mutable {
+            serve(std::move(client), session);
+          },
+          boost::asio::detached);
+    }
+  }
+
+  void serve(boost::asio::ip::tcp::socket socket, const boost::asio::yield_context& yield) {
+    namespace http = boost::beast::http;
+    boost::beast::tcp_stream stream{std::move(socket)};
+    boost::beast::flat_buffer buffer;
+    http::request<http::empty_body> request;
+    boost::system::error_code ec;
+    stream.expires_after(idle_timeout);
+    http::async_read(stream, buffer, request, yield[ec]);
+    if (ec) {
+      return;
+    }
+    const auto is_metrics = request.method() == http::verb::get && request.target() == "/metrics";
+    http::response<http::string_body> response{is_metrics ? http::status::ok
+                                                          : http::status::not_found,
+                                               request.version()};
+    response.set(http::field::content_type,
+                 is_metrics ? "application/openmetrics-text; version=1.0.0; charset=utf-8"
+                            : "text/plain; charset=utf-8");
+    response.body() = is_metrics ? openmetrics(stats, controller) : "not found\n";
+    response.keep_alive(false);
+    response.prepare_payload();
+    http::async_write(stream, response, yield[ec]);
+    stream.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+  }
+
+  boost::asio::io_context& ios;
+  boost::asio::ip::tcp::acceptor acceptor;
+  boost::asio::steady_timer backoff;
+  const RunStats& stats;
+  const Controller& controller;
+};
+} // namespace abrade
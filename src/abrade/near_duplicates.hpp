@@ -0,0 +1,130 @@
+#pragma once
+
+#include <abrade/simhash.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace abrade {
+
+/// Groups GET bodies into clusters of near duplicates by their SimHash signature.
+///
+/// A body joins the first cluster whose founding signature is at most
+/// `max_distance` bits away; otherwise it founds a new cluster. Only the first
+/// `exemplars` members of a cluster are kept on disk. `assign` reserves an
+/// exemplar slot; once the body is stored or dropped, `record` lists it in a
+/// tab-separated index of cluster number, `kept` or `duplicate`, and candidate,
+/// and `release` frees the slot of an exemplar that could not be stored.
+///
+/// Lookups use multi-index hashing: the signature is split into
+/// `max_distance + 1` bands, and two signatures within `max_distance` bits agree
+/// exactly on at least one band, so only clusters sharing a band are compared.
+/// `WorkerPool` threads assign bodies concurrently, so every member takes a lock.
+class NearDuplicates {
+public:
+  /// Largest SimHash distance, in bits, between a body and its cluster's founder.
+  static constexpr int max_distance{6};
+
+  /// Where a body landed.
+  struct Assignment {
+    std::size_t cluster{};
+    bool is_exemplar{};
+  };
+
+  /// Keeps at most `exemplars_per_cluster` bodies per cluster and truncates the index file.
+  NearDuplicates(std::size_t exemplars_per_cluster, const std::string& index_path)
+      : exemplars{exemplars_per_cluster} {
+    index_file.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+    index_file.open(index_path, std::ofstream::out | std::ofstream::trunc);
+  }
+
+  /// Assigns a body signature to a cluster, reserving one of its exemplar slots if any is free.
+  Assignment assign(std::uint64_t signature) {
+    const std::scoped_lock lock{mutex};
+    Assignment assignment{find(signature), false};
+    if (assignment.cluster == founders.size()) {
+      add(signature);
+    }
+    assignment.is_exemplar = kept[assignment.cluster] < exemplars;
+    if (assignment.is_exemplar) {
+      kept[assignment.cluster]++;
+    }
+    return assignment;
+  }
+
+  /// Lists a stored exemplar or a dropped duplicate in the index.
+  void record(const Assignment& assignment, std::string_view candidate) {
+    const std::scoped_lock lock{mutex};
+    index_file << assignment.cluster << '\t' << (assignment.is_exemplar ? "kept" : "duplicate")
+               << '\t' << candidate << '\n';
+  }
+
+  /// Frees the slot reserved for an exemplar that could not be stored; it is not listed.
+  void release(const Assignment& assignment) {
+    if (!assignment.is_exemplar) {
+      return;
+    }
+    const std::scoped_lock lock{mutex};
+    kept[assignment.cluster]--;
+  }
+
+  /// Returns the number of clusters founded so far.
+  [[nodiscard]] std::size_t size() {
+    const std::scoped_lock lock{mutex};
+    return founders.size();
+  }
+
+  /// Flushes the index file.
+  void flush() {
+    const std::scoped_lock lock{mutex};
+    index_file.flush();
+  }
+
+private:
+  static constexpr std::size_t bands{max_distance + 1};
+
+  static std::uint64_t band_key(std::uint64_t signature, std::size_t band) noexcept {
+    const auto first = band * 64U / bands;
+    const auto last = (band + 1U) * 64U / bands;
+    const auto width = last - first;
+    return (signature >> first) & ((std::uint64_t{1} << width) - 1U);
+  }
+
+  std::size_t find(std::uint64_t signature) const {
+    auto best = founders.size();
+    for (std::size_t band{}; band < bands; ++band) {
+      const auto bucket = index[band].find(band_key(signature, band));
+      if (bucket == index[band].end()) {
+        continue;
+      }
+      for (const auto cluster : bucket->second) {
+        if (cluster < best && SimHash::distance(founders[cluster], signature) <= max_distance) {
+          best = cluster;
+        }
+      }
+    }
+    return best;
+  }
+
+  void add(std::uint64_t signature) {
+    for (std::size_t band{}; band < bands; ++band) {
+      index[band][band_key(signature, band)].push_back(founders.size());
+    }
+    founders.push_back(signature);
+    kept.push_back(0U);
+  }
+
+  const std::size_t exemplars;
+  std::mutex mutex;
+  std::array<std::unordered_map<std::uint64_t, std::vector<std::size_t>>, bands> index;
+  std::vector<std::uint64_t> founders;
+  std::vector<std::size_t> kept;
+  std::ofstream index_file;
+};
+} // namespace abrade
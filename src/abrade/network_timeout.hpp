@@ -1,6 +1,7 @@
 #pragma once
 
 #include <abrade/exception.hpp>
+#include <abrade/probes.hpp>
 #include <atomic>
 #include <boost/asio/spawn.hpp>
 #include <boost/asio/steady_timer.hpp>
@@ -59,13 +60,16 @@ inline std::chrono::milliseconds network_operation_timeout() {
   return timeout;
 }
 
-/// Awaits a void asynchronous operation and cancels it if the network timeout expires.
+/// Awaits a void asynchronous operation and returns its completion error instead of throwing.
 ///
-/// `cancel` must request cancellation for the outstanding async operation. The
-/// `start` callable must initiate the operation with the provided yield token.
+/// Timeouts still throw because a cancelled operation carries no useful error.
+/// Callers use this when some non-success codes are protocol signals rather than
+/// failures, such as Beast's `need_buffer` while streaming a response body.
 template <typename Executor, typename Cancel, typename Start>
-void await_void_with_timeout(Executor executor, Cancel&& cancel, std::string_view action,
-                             const boost::asio::yield_context& yield, Start&& start) {
+boost::system::error_code try_await_void_with_timeout(Executor executor, Cancel&& cancel,
+                                                      std::string_view action,
+                                                      const boost::asio::yield_context& yield,
+                                                      Start&& start) {
   auto active = std::make_shared<std::atomic_bool>(true);
   auto timed_out = std::make_shared<std::atomic_bool>(false);
   auto cancel_operation = std::make_shared<std::decay_t<Cancel>>(std::forward<Cancel>(cancel));
@@ -84,8 +88,22 @@ void await_void_with_timeout(Executor executor, Cancel&& cancel, std::string_vie
   timer.cancel();
 
   if (timed_out->load()) {
-    throw AbradeException{std::string{action} + " timeout"};
+    auto expired = AbradeException::timeout(std::string{action});
+    ABRADE_PROBE1(timeout, expired.action().c_str());
+    throw expired;
   }
+  return ec;
+}
+
+/// Awaits a void asynchronous operation and cancels it if the network timeout expires.
+///
+/// `cancel` must request cancellation for the outstanding async operation. The
+/// `start` callable must initiate the operation with the provided yield token.
+template <typename Executor, typename Cancel, typename Start>
+void await_void_with_timeout(Executor executor, Cancel&& cancel, std::string_view action,
+                             const boost::asio::yield_context& yield, Start&& start) {
+  const auto ec = try_await_void_with_timeout(executor, std::forward<Cancel>(cancel), action,
+                                              yield, std::forward<Start>(start));
   if (ec) {
     throw AbradeException{std::string{action}, ec};
   }
@@ -116,7 +134,9 @@ Result await_result_with_timeout(Executor executor, Cancel&& cancel, std::string
   timer.cancel();
 
   if (timed_out->load()) {
-    throw AbradeException{std::string{action} + " timeout"};
+    auto expired = AbradeException::timeout(std::string{action});
+    ABRADE_PROBE1(timeout, expired.action().c_str());
+    throw expired;
   }
   if (ec) {
     throw AbradeException{std::string{action}, ec};
@@ -142,6 +162,21 @@ void await_stream_with_timeout(Stream& stream, std::string_view action,
       action, yield, std::forward<Start>(start));
 }
 
+/// Stream counterpart of `try_await_void_with_timeout` for reads that expect protocol signals.
+template <typename Stream, typename Start>
+boost::system::error_code try_await_stream_with_timeout(Stream& stream, std::string_view action,
+                                                        const boost::asio::yield_context& yield,
+                                                        Start&& start) {
+  auto& lowest_layer = boost::beast::get_lowest_layer(stream);
+  return try_await_void_with_timeout(
+      lowest_layer.get_executor(),
+      [&lowest_layer] {
+        boost::system::error_code ignored;
+        lowest_layer.cancel(ignored);
+      },
+      action, yield, std::forward<Start>(start));
+}
+
 /// Applies the standard timeout wrapper to resolver asynchronous operations.
 template <typename Result, typename Resolver, typename Start>
 Result await_resolver_with_timeout(Resolver& resolver, std::string_view action,
@@ -1,7 +1,11 @@
+#include <abrade/endpoint.hpp>
 #include <abrade/options.hpp>
+#include <boost/asio/ip/address.hpp>
 #include <boost/program_options.hpp>
 #include <boost/regex.hpp>
+#include <cstdint>
 #include <exception>
+#include <limits>
 #include <sstream>
 #include <string>
 
@@ -21,6 +25,19 @@ void validate_regex_options(const vector<string>& patterns, const char* option_n
     }
   }
 }
+
+void validate_listen_address(const string& listen, const Options& options) {
+  try {
+    const auto endpoint = parse_host_endpoint(listen, "", 0);
+    boost::system::error_code ec;
+    boost::asio::ip::make_address(endpoint.host, ec);
+    if (endpoint.port == 0U || ec) {
+      throw runtime_error{"expected an IP address and a port"};
+    }
+  } catch (const runtime_error& e) {
+    throw OptionsException{"metrics-listen must be ADDRESS:PORT: " + string{e.what()}, options};
+  }
+}
 } // namespace
 
 void Options::add_parser_options(options_description& description) {
@@ -50,10 +67,44 @@ void Options::add_parser_options(options_description& description) {
       "require regex match in 2xx GET body before writing it. repeatable. requires --contents")(
       "reject-regex", value<vector<string>>(&rejected_regexes)->composing(),
       "reject 2xx GET body matching regex before writing it. repeatable. requires --contents")(
+      "content-type", value<vector<string>>(&content_types)->composing(),
+      "require 2xx Content-Type media type, or type/*, before reading the body. repeatable")(
+      "min-length", value<uint64_t>(&min_length),
+      "minimum 2xx Content-Length, or GET body size when undeclared (default: none)")(
+      "max-length", value<uint64_t>(&max_length),
+      "maximum 2xx Content-Length, or GET body size when undeclared (default: none)")(
+      "require-header", value<vector<string>>(&required_header_regexes)->composing(),
+      "require regex match in a 2xx \"Name: value\" header line. repeatable")(
+      "reject-header", value<vector<string>>(&rejected_header_regexes)->composing(),
+      "reject 2xx response with a \"Name: value\" header line matching regex. repeatable")(
+      "cluster", value<size_t>(&cluster_exemplars)->default_value(0),
+      "keep N GET bodies per near-duplicate cluster; list the rest in <out>.clusters.tsv. 0 = off")(
+      "soft404", bool_switch(&soft_not_found),
+      "learn 2xx answers to random nonexistent candidates and drop look-alikes (default: no)")(
       "follow-redirects", bool_switch(&follow_redirects),
       "follow same-scheme, same-authority redirects (default: no)")(
       "max-redirects", value<size_t>(&max_redirects),
       "maximum redirect hops when --follow-redirects is enabled (default: 5)")(
+      "error-bodies", value<string>(&error_bodies)->default_value("close"),
+      "non-2xx GET bodies: close (drop connection after header) or drain (read and discard)")(
+      "head-fallback", value<string>(&head_fallback)->default_value("auto"),
+      "HEAD scans: auto (switch to ranged GET when the server rejects HEAD) or off")(
+      "workers", value<size_t>(&workers)->default_value(2),
+      "threads that filter and spool GET bodies. 0 processes bodies on the network thread")(
+      "worker-queue", value<size_t>(&worker_queue)->default_value(64),
+      "maximum GET body jobs queued or running before requests wait for a worker")(
+      "progress", value<size_t>(&progress_interval)->default_value(1000),
+      "milliseconds between live progress updates. 0 disables them")(
+      "metrics-listen", value<string>(&metrics_listen)->default_value(""),
+      "serve OpenMetrics at http://ADDRESS:PORT/metrics during the run (default: none)")(
+      "report", value<string>(&report_path)->default_value(""),
+      "write a JSON report of the finished run to this file (default: none)")(
+      "trace", value<string>(&trace_path)->default_value(""),
+      "write sampled per-request spans to this file as Chrome trace-event JSON (default: none)")(
+      "trace-sample", value<size_t>(&trace_sample)->default_value(100),
+      "trace one candidate in this many when --trace is set")(
+      "shm-stats", bool_switch(&shm_stats),
+      "publish live stats in shared memory for abrade_top (default: no)")(
       "stdin,d", bool_switch(&from_stdin),
       "read from stdin (default: no)")("tls,t", bool_switch(&tls), "use tls/ssl (default: no)")(
       "sensitive,s", bool_switch(&sensitive_teardown),
@@ -66,10 +117,18 @@ void Options::add_parser_options(options_description& description) {
       "print when resource found (default: no). implied by verbose")(
       "verbose,v", bool_switch(&verbose), "prints gratuitous output to console (default: no)")(
       "contents,c", bool_switch(&contents), "read full contents (default: no)")(
+      "probe", bool_switch(&probe),
+      "HEAD every candidate and GET only 2xx hits. implies --contents (default: no)")(
       "test", bool_switch(&test),
       "no network requests, just write generated URIs to console (default: no)")(
       "optimize,p", bool_switch(&optimize),
-      "Optimize number of simultaneous requests (default: no)")(
+      "Optimize number of simultaneous requests (default: no). same as --controller adaptive")(
+      "controller", value<string>(&controller),
+      "concurrency controller: fixed, adaptive, aimd, or gradient (default: fixed)")(
+      "calibrate", bool_switch(&calibrate),
+      "sweep concurrency over the first candidates and start the controller at the knee "
+      "(default: no)")("calibrate-only", bool_switch(&calibrate_only),
+                       "print the concurrency sweep and exit. implies --calibrate")(
       "init,i", value<size_t>(&initial_coroutines)->default_value(1000),
       "Initial number of simultaneous requests")(
       "min", value<size_t>(&minimum_coroutines)->default_value(1),
@@ -78,7 +137,11 @@ void Options::add_parser_options(options_description& description) {
       "Maximum number of simultaneous requests")(
       "ssize", value<size_t>(&sample_size)->default_value(50), "Size of velocity sliding window")(
       "sint", value<size_t>(&sample_interval)->default_value(1000),
-      "Size of sampling interval")("help,h", "produce help message");
+      "Size of sampling interval when --swin is 0")(
+      "swin", value<size_t>(&sample_window)->default_value(1000),
+      "Milliseconds per controller sample; 0 samples every --sint completions")(
+      "smin", value<size_t>(&sample_minimum)->default_value(20),
+      "Fewest completions in a timed controller sample")("help,h", "produce help message");
 }
 
 void Options::validate_parsed_options(bool max_redirects_provided) {
@@ -103,6 +166,22 @@ void Options::validate_parsed_options(bool max_redirects_provided) {
   if (sample_interval < 1) {
     throw OptionsException{"ssize must be positive", *this};
   }
+  if (sample_minimum < 1) {
+    throw OptionsException{"smin must be positive", *this};
+  }
+  if (calibrate_only) {
+    calibrate = true;
+  }
+  if (optimize && !controller.empty() && controller != "adaptive") {
+    throw OptionsException{"optimize conflicts with --controller " + controller, *this};
+  }
+  if (controller.empty()) {
+    controller = optimize ? "adaptive" : "fixed";
+  }
+  if (controller != "fixed" && controller != "adaptive" && controller != "aimd" &&
+      controller != "gradient") {
+    throw OptionsException{"controller must be fixed, adaptive, aimd, or gradient", *this};
+  }
   if (!screen.empty()) {
     rejected_literals.push_back(screen);
   }
@@ -111,14 +190,42 @@ void Options::validate_parsed_options(bool max_redirects_provided) {
   if (has_filters && !contents) {
     throw OptionsException{"content filters require --contents", *this};
   }
+  if (cluster_exemplars != 0U && !contents) {
+    throw OptionsException{"cluster requires --contents", *this};
+  }
   validate_regex_options(required_regexes, "--require-regex", *this);
   validate_regex_options(rejected_regexes, "--reject-regex", *this);
+  validate_regex_options(required_header_regexes, "--require-header", *this);
+  validate_regex_options(rejected_header_regexes, "--reject-header", *this);
+  if (min_length > max_length) {
+    throw OptionsException{"min-length must not exceed max-length", *this};
+  }
   if (max_redirects < 1) {
     throw OptionsException{"max-redirects must be positive", *this};
   }
   if (max_redirects_provided && !follow_redirects) {
     throw OptionsException{"max-redirects requires --follow-redirects", *this};
   }
+  if (error_bodies != "drain" && error_bodies != "close") {
+    throw OptionsException{"error-bodies must be drain or close", *this};
+  }
+  if (head_fallback != "auto" && head_fallback != "off") {
+    throw OptionsException{"head-fallback must be auto or off", *this};
+  }
+  if (worker_queue < 1) {
+    throw OptionsException{"worker-queue must be positive", *this};
+  }
+  if (!metrics_listen.empty()) {
+    validate_listen_address(metrics_listen, *this);
+  }
+  if (trace_sample < 1) {
+    throw OptionsException{"trace-sample must be positive", *this};
+  }
+#if defined(_WIN32)
+  if (shm_stats) {
+    throw OptionsException{"shm-stats requires POSIX shared memory, which Windows lacks", *this};
+  }
+#endif
 }
 
 Options::Options(int argc, const char** argv) {
@@ -146,6 +253,7 @@ Options::Options(int argc, const char** argv) {
   if (help) {
     return;
   }
+  contents |= probe;
   validate_parsed_options(vm.contains("max-redirects"));
   tls |= verify;
   print_found |= verbose;
@@ -177,26 +285,56 @@ string Options::get_pretty_print() const noexcept {
      << "[ ] User Agent: " << get_user_agent() << "\n"
      << "[ ] Proxy: " << (is_proxy() ? get_proxy() : "No") << "\n"
      << "[ ] Contents: " << (is_contents() ? "Yes" : "No") << "\n"
+     << "[ ] Probe with HEAD: " << (is_probe() ? "Yes" : "No") << "\n"
      << "[ ] Body filters: "
      << (required_literals.empty() && rejected_literals.empty() && required_regexes.empty() &&
                  rejected_regexes.empty()
              ? "None"
              : "Configured")
      << "\n"
+     << "[ ] Header filters: "
+     << (content_types.empty() && min_length == 0U &&
+                 max_length == numeric_limits<uint64_t>::max() &&
+                 required_header_regexes.empty() && rejected_header_regexes.empty()
+             ? "None"
+             : "Configured")
+     << "\n"
+     << "[ ] Near-duplicate clusters: "
+     << (cluster_exemplars == 0U ? "Off" : "Keep " + to_string(cluster_exemplars) + " per cluster")
+     << "\n"
+     << "[ ] Soft-404 detection: " << (is_soft_not_found() ? "Yes" : "No") << "\n"
      << "[ ] Follow redirects: " << (is_follow_redirects() ? "Yes" : "No") << "\n"
      << "[ ] Max redirects: " << get_max_redirects() << "\n"
+     << "[ ] Error bodies: " << error_bodies << "\n"
+     << "[ ] HEAD fallback: " << head_fallback << "\n"
+     << "[ ] Body workers: " << get_workers() << " (queue " << get_worker_queue() << ")\n"
+     << "[ ] Progress updates: "
+     << (progress_interval == 0U ? "Off" : "Every " + to_string(progress_interval) + " ms") << "\n"
+     << "[ ] Metrics endpoint: "
+     << (metrics_listen.empty() ? "Off" : "http://" + metrics_listen + "/metrics") << "\n"
+     << "[ ] Run report: " << (report_path.empty() ? "None" : report_path) << "\n"
+     << "[ ] Trace: "
+     << (trace_path.empty() ? "Off"
+                            : trace_path + " (1 in " + to_string(trace_sample) + " candidates)")
+     << "\n"
+     << "[ ] Shared-memory stats: " << (is_shm_stats() ? "Yes" : "No") << "\n"
      << "[ ] Output: " << get_output_path() << "\n"
      << "[ ] Error Output: " << get_error_path() << "\n"
      << "[ ] Verbose: " << (is_verbose() ? "Yes" : "No") << "\n"
      << "[ ] Print found: " << (is_print_found() ? "Yes" : "No") << "\n"
      << "[ ] Initial connections: " << get_initial_coroutines() << "\n"
-     << "[ ] Optimize connections: " << (is_optimizer() ? "Yes" : "No");
+     << "[ ] Optimize connections: " << (is_optimizer() ? "Yes" : "No") << "\n"
+     << "[ ] Concurrency controller: " << controller << "\n"
+     << "[ ] Calibrate concurrency: "
+     << (is_calibrate_only() ? "Only" : (is_calibrate() ? "Yes" : "No"));
   if (!is_optimizer()) {
     ss << "\n"
        << "[ ] Connection range: [" << get_minimum_coroutines() << "," << get_maximum_coroutines()
        << "] " << "\n"
        << "[ ] Optimization sample size: " << get_sample_size() << "\n"
-       << "[ ] Optimization sample interval: " << get_sample_interval();
+       << "[ ] Optimization sample interval: " << get_sample_interval() << "\n"
+       << "[ ] Optimization sample window: " << get_sample_window() << " ms\n"
+       << "[ ] Optimization sample minimum: " << get_sample_minimum();
   }
   return ss.str();
 }
@@ -209,12 +347,20 @@ bool Options::is_test() const noexcept { return test; }
 
 bool Options::is_follow_redirects() const noexcept { return follow_redirects; }
 
+bool Options::is_close_error_bodies() const noexcept { return error_bodies == "close"; }
+
+bool Options::is_head_fallback() const noexcept { return head_fallback == "auto"; }
+
+bool Options::is_soft_not_found() const noexcept { return soft_not_found; }
+
 bool Options::is_help() const noexcept { return help; }
 
 bool Options::is_verbose() const noexcept { return verbose; }
 
 bool Options::is_contents() const noexcept { return contents; }
 
+bool Options::is_probe() const noexcept { return probe; }
+
 bool Options::is_print_found() const noexcept { return print_found; }
 
 bool Options::is_proxy() const noexcept { return !proxy.empty(); }
@@ -227,7 +373,9 @@ bool Options::is_verify() const noexcept { return verify; }
 
 bool Options::is_sensitive_teardown() const noexcept { return sensitive_teardown; }
 
-bool Options::is_optimizer() const noexcept { return optimize; }
+bool Options::is_optimizer() const noexcept { return controller != "fixed"; }
+
+const string& Options::get_controller() const noexcept { return controller; }
 
 const string& Options::get_help() const noexcept { return help_str; }
 
@@ -253,8 +401,42 @@ const vector<string>& Options::get_required_regexes() const noexcept { return re
 
 const vector<string>& Options::get_rejected_regexes() const noexcept { return rejected_regexes; }
 
+const vector<string>& Options::get_content_types() const noexcept { return content_types; }
+
+uint64_t Options::get_min_length() const noexcept { return min_length; }
+
+uint64_t Options::get_max_length() const noexcept { return max_length; }
+
+const vector<string>& Options::get_required_header_regexes() const noexcept {
+  return required_header_regexes;
+}
+
+const vector<string>& Options::get_rejected_header_regexes() const noexcept {
+  return rejected_header_regexes;
+}
+
 size_t Options::get_max_redirects() const noexcept { return max_redirects; }
 
+size_t Options::get_workers() const noexcept { return workers; }
+
+size_t Options::get_cluster_exemplars() const noexcept { return cluster_exemplars; }
+
+string Options::get_cluster_index_path() const { return output_path + ".clusters.tsv"; }
+
+size_t Options::get_worker_queue() const noexcept { return worker_queue; }
+
+size_t Options::get_progress_interval() const noexcept { return progress_interval; }
+
+const string& Options::get_metrics_listen() const noexcept { return metrics_listen; }
+
+const string& Options::get_report_path() const noexcept { return report_path; }
+
+const string& Options::get_trace_path() const noexcept { return trace_path; }
+
+size_t Options::get_trace_sample() const noexcept { return trace_sample; }
+
+bool Options::is_shm_stats() const noexcept { return shm_stats; }
+
 size_t Options::get_initial_coroutines() const noexcept { return initial_coroutines; }
 
 size_t Options::get_minimum_coroutines() const noexcept { return minimum_coroutines; }
@@ -264,4 +446,12 @@ size_t Options::get_maximum_coroutines() const noexcept { return maximum_corouti
 size_t Options::get_sample_size() const noexcept { return sample_size; }
 
 size_t Options::get_sample_interval() const noexcept { return sample_interval; }
+
+size_t Options::get_sample_window() const noexcept { return sample_window; }
+
+size_t Options::get_sample_minimum() const noexcept { return sample_minimum; }
+
+bool Options::is_calibrate() const noexcept { return calibrate; }
+
+bool Options::is_calibrate_only() const noexcept { return calibrate_only; }
 } // namespace abrade
@@ -1,5 +1,7 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -29,14 +31,18 @@ struct Options {
   bool is_verify() const noexcept;
   /// True when Abrade should fetch and save full response bodies.
   bool is_contents() const noexcept;
+  /// True when candidates are probed with HEAD and only 2xx hits are fetched with GET.
+  bool is_probe() const noexcept;
   /// True when a SOCKS5 proxy should be used.
   bool is_proxy() const noexcept;
   /// True when detailed progress and response output should be printed.
   bool is_verbose() const noexcept;
   /// True when successful candidates should be printed.
   bool is_print_found() const noexcept;
-  /// True when adaptive coroutine tuning is enabled.
+  /// True when a controller other than `fixed` tunes the number of coroutines.
   bool is_optimizer() const noexcept;
+  /// Returns the concurrency controller: `fixed`, `adaptive`, `aimd`, or `gradient`.
+  const std::string& get_controller() const noexcept;
   /// True when TCP shutdown errors should be surfaced.
   bool is_sensitive_teardown() const noexcept;
   /// True when implicit range output should preserve leading zeros.
@@ -47,6 +53,12 @@ struct Options {
   bool is_test() const noexcept;
   /// True when same-origin, same-scheme redirects should be followed.
   bool is_follow_redirects() const noexcept;
+  /// True when non-2xx GET bodies should be skipped by closing the connection instead of drained.
+  bool is_close_error_bodies() const noexcept;
+  /// True when HEAD scans may fall back to ranged GETs for servers that mishandle HEAD.
+  bool is_head_fallback() const noexcept;
+  /// True when 2xx responses resembling answers to random nonexistent candidates are dropped.
+  bool is_soft_not_found() const noexcept;
 
   /// Returns the human-readable startup summary.
   std::string get_pretty_print() const noexcept;
@@ -74,8 +86,38 @@ struct Options {
   const std::vector<std::string>& get_required_regexes() const noexcept;
   /// Returns regex body patterns that prevent a GET response from being persisted.
   const std::vector<std::string>& get_rejected_regexes() const noexcept;
+  /// Returns media types, optionally `type/*`, that a found 2xx response must declare.
+  const std::vector<std::string>& get_content_types() const noexcept;
+  /// Returns the smallest Content-Length or body size accepted for a found 2xx response.
+  std::uint64_t get_min_length() const noexcept;
+  /// Returns the largest Content-Length or body size accepted; the maximum value means unbounded.
+  std::uint64_t get_max_length() const noexcept;
+  /// Returns regexes that some `Name: value` header line of a found 2xx response must match.
+  const std::vector<std::string>& get_required_header_regexes() const noexcept;
+  /// Returns regexes that no `Name: value` header line of a found 2xx response may match.
+  const std::vector<std::string>& get_rejected_header_regexes() const noexcept;
   /// Returns the maximum redirect hops followed for one generated candidate.
   size_t get_max_redirects() const noexcept;
+  /// Returns the number of bodies kept per near-duplicate cluster; 0 disables clustering.
+  size_t get_cluster_exemplars() const noexcept;
+  /// Returns the cluster-membership index path written next to the GET output directory.
+  std::string get_cluster_index_path() const;
+  /// Returns the number of threads that filter and spool GET bodies; 0 means inline.
+  size_t get_workers() const noexcept;
+  /// Returns the maximum number of body jobs queued or running before requests wait.
+  size_t get_worker_queue() const noexcept;
+  /// Returns the milliseconds between live progress refreshes; 0 disables the progress line.
+  size_t get_progress_interval() const noexcept;
+  /// Returns the `ADDRESS:PORT` serving OpenMetrics, or an empty string when the endpoint is off.
+  const std::string& get_metrics_listen() const noexcept;
+  /// Returns the JSON run report path, or an empty string when no report is written.
+  const std::string& get_report_path() const noexcept;
+  /// Returns the Chrome trace-event output path, or an empty string when tracing is off.
+  const std::string& get_trace_path() const noexcept;
+  /// Returns how many candidates share one traced candidate; 1 traces every candidate.
+  size_t get_trace_sample() const noexcept;
+  /// Returns true when live stats are published in shared memory for `abrade_top`.
+  bool is_shm_stats() const noexcept;
   /// Returns the initial active coroutine recommendation.
   size_t get_initial_coroutines() const noexcept;
   /// Returns the lower bound for adaptive coroutine recommendations.
@@ -84,8 +126,16 @@ struct Options {
   size_t get_maximum_coroutines() const noexcept;
   /// Returns the number of velocity samples retained by the adaptive controller.
   size_t get_sample_size() const noexcept;
-  /// Returns the completion interval between adaptive controller samples.
+  /// Returns the completion interval between controller samples when `get_sample_window` is 0.
   size_t get_sample_interval() const noexcept;
+  /// Returns the milliseconds per controller sample; 0 samples every `get_sample_interval`.
+  size_t get_sample_window() const noexcept;
+  /// Returns the fewest completions a timed controller sample closes with.
+  size_t get_sample_minimum() const noexcept;
+  /// Returns true when a concurrency sweep over the first candidates seeds the controller.
+  bool is_calibrate() const noexcept;
+  /// Returns true when the scan stops after the concurrency sweep.
+  bool is_calibrate_only() const noexcept;
 
 private:
   void add_parser_options(boost::program_options::options_description& description);
@@ -96,6 +146,8 @@ private:
   size_t maximum_coroutines{};
   size_t sample_size{};
   size_t sample_interval{};
+  size_t sample_window{};
+  size_t sample_minimum{};
   bool help{};
   bool tls{};
   bool verify{};
@@ -110,12 +162,29 @@ private:
   bool telescoping{};
   bool from_stdin{};
   bool follow_redirects{};
+  bool probe{};
+  bool soft_not_found{};
+  bool shm_stats{};
+  bool calibrate{};
+  bool calibrate_only{};
   size_t max_redirects{5};
-  std::string host, pattern, output_path, error_path, help_str, proxy, user_agent, screen;
+  std::uint64_t min_length{};
+  std::uint64_t max_length{std::numeric_limits<std::uint64_t>::max()};
+  size_t workers{};
+  size_t cluster_exemplars{};
+  size_t worker_queue{};
+  size_t progress_interval{};
+  size_t trace_sample{};
+  std::string host, pattern, output_path, error_path, help_str, proxy, user_agent, screen,
+      error_bodies, head_fallback, metrics_listen, report_path,
+      trace_path, controller;
   std::vector<std::string> required_literals;
   std::vector<std::string> rejected_literals;
   std::vector<std::string> required_regexes;
   std::vector<std::string> rejected_regexes;
+  std::vector<std::string> content_types;
+  std::vector<std::string> required_header_regexes;
+  std::vector<std::string> rejected_header_regexes;
 };
 
 /// Command-line parsing failure that includes parser-generated help text.
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/error_code.hpp>
+#include <chrono>
+#include <functional>
+#include <utility>
+
+namespace abrade {
+
+/// Calls a function every `period` on the scraper's io_context until stopped.
+///
+/// The timer keeps the io_context busy, so call `stop` once the scan finishes.
+/// Like `RunStats`, this runs only on the networking thread.
+class PeriodicTimer {
+public:
+  PeriodicTimer(boost::asio::io_context& io_context, std::chrono::milliseconds period,
+                std::function<void()> on_tick)
+      : timer{io_context}, interval{period}, tick{std::move(on_tick)} {}
+  PeriodicTimer(const PeriodicTimer&) = delete;
+  PeriodicTimer(PeriodicTimer&&) = delete;
+  PeriodicTimer& operator=(const PeriodicTimer&) = delete;
+  PeriodicTimer& operator=(PeriodicTimer&&) = delete;
+  ~PeriodicTimer() = default;
+
+  /// Schedules the first tick.
+  void start() { schedule(); }
+
+  /// Cancels pending ticks.
+  void stop() {
+    is_stopped = true;
+    timer.cancel();
+  }
+
+private:
+  void schedule() {
+    timer.expires_after(interval);
+    timer.async_wait([this](const boost::system::error_code& ec) {
+      if (ec || is_stopped) {
+        return;
+      }
+      tick();
+      schedule();
+    });
+  }
+
+  boost::asio::steady_timer timer;
+  const std::chrono::milliseconds interval;
+  const std::function<void()> tick;
+  bool is_stopped{};
+};
+} // namespace abrade
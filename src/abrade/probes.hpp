@@ -0,0 +1,38 @@
+#pragma once
+
+/// USDT probes on the request hot path, in the `abrade` provider.
+///
+/// When `ABRADE_HAS_USDT` is defined, which the `ABRADE_ENABLE_USDT` CMake
+/// option does on Linux when `sys/sdt.h` is available, each probe compiles to a
+/// single `nop` and an ELF note that bpftrace, perf, or SystemTap can attach to
+/// in a running process. Otherwise the macros expand to nothing and their
+/// arguments are not evaluated, so probe arguments must be values the caller
+/// computes anyway.
+///
+/// | Probe | Arguments |
+/// | --- | --- |
+/// | `candidate_start` | candidate URI |
+/// | `candidate_finish` | candidate URI, 1 if it failed |
+/// | `connect_start` | candidate URI, request socket |
+/// | `connect_done` | candidate URI, request socket |
+/// | `phase` | request socket, phase name, duration in microseconds |
+/// | `response` | request socket, HTTP status |
+/// | `body_bytes` | request socket, bytes read |
+/// | `timeout` | action |
+/// | `controller` | active coroutines, recommended coroutines, velocity in milli-requests/s |
+///
+/// Strings are NUL-terminated `const char*`. The request socket is the
+/// address `TraceKey` also uses, so bpftrace can join `phase`, `response`, and
+/// `body_bytes` to a candidate through `connect_start`. A `phase` probe named
+/// `tls` marks a finished handshake; the other names are `phase_names`.
+
+#if defined(ABRADE_HAS_USDT)
+#include <sys/sdt.h>
+#define ABRADE_PROBE1(name, a) DTRACE_PROBE1(abrade, name, a)
+#define ABRADE_PROBE2(name, a, b) DTRACE_PROBE2(abrade, name, a, b)
+#define ABRADE_PROBE3(name, a, b, c) DTRACE_PROBE3(abrade, name, a, b, c)
+#else
+#define ABRADE_PROBE1(name, a) static_cast<void>(0)
+#define ABRADE_PROBE2(name, a, b) static_cast<void>(0)
+#define ABRADE_PROBE3(name, a, b, c) static_cast<void>(0)
+#endif
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <abrade/periodic_timer.hpp>
+#include <abrade/run_stats.hpp>
+#include <boost/asio/io_context.hpp>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace abrade {
+
+/// Live status line for a running scan, refreshed by a `PeriodicTimer`.
+///
+/// Every `interval` it prints the request rate and body throughput since the
+/// previous refresh, in-flight candidates with the states their coroutines are
+/// waiting in, hits, the error rate, and, when the candidate count is known, the
+/// share done and an ETA from the average rate.
+/// On a terminal the line is redrawn in place; otherwise each refresh is a new
+/// line, so logs get a periodic record instead of carriage returns. Call `stop`
+/// once the scan finishes.
+class ProgressLine {
+public:
+  ProgressLine(boost::asio::io_context& io_context, const RunStats& run_stats,
+               std::chrono::milliseconds refresh_interval, std::optional<std::size_t> candidates,
+               std::ostream& output, bool redraw_in_place)
+      : ticker{io_context, refresh_interval, [this] { draw(); }}, stats{run_stats},
+        total{candidates}, out{output}, in_place{redraw_in_place},
+        previous{std::chrono::steady_clock::now()} {}
+
+  /// Schedules the first refresh.
+  void start() { ticker.start(); }
+
+  /// Cancels pending refreshes and ends a line that was drawn in place.
+  void stop() {
+    ticker.stop();
+    if (in_place && is_drawn) {
+      out << '\n' << std::flush;
+      is_drawn = false;
+    }
+  }
+
+  /// Formats the status line at `now` and makes `now` the start of the next rate window.
+  [[nodiscard]] std::string render(std::chrono::steady_clock::time_point now) {
+    const auto window = std::chrono::duration<double>{now - previous}.count();
+    const auto attempted = stats.attempted();
+    const auto received = stats.bytes_received();
+    const auto finished = stats.candidates_finished();
+    const auto rate = [window](std::size_t current, std::size_t before) {
+      return window > 0.0 ? static_cast<double>(current - before) / window : 0.0;
+    };
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+    line << "[ ] Progress: " << stats.elapsed_seconds() << "s "
+         << rate(attempted, previous_attempted) << " req/s in-flight=" << stats.in_flight();
+    census(line);
+    line << " hits=" << stats.hits() << " errors="
+         << (finished != 0U
+                 ? 100.0 * static_cast<double>(stats.errors()) / static_cast<double>(finished)
+                 : 0.0)
+         << "% " << std::setprecision(2) << rate(received, previous_received) / (1024.0 * 1024.0)
+         << " MiB/s";
+    if (total && *total != 0U) {
+      const auto done = static_cast<double>(finished) / static_cast<double>(*total);
+      line << std::setprecision(1) << ' ' << 100.0 * done << "% ETA " << eta(done);
+    }
+
+    previous = now;
+    previous_attempted = attempted;
+    previous_received = received;
+    return line.str();
+  }
+
+private:
+  void draw() {
+    const auto line = render(std::chrono::steady_clock::now());
+    if (in_place) {
+      // Clear to the end of the row in case the previous line was longer.
+      out << '\r' << line << "\x1b[K" << std::flush;
+      is_drawn = true;
+    } else {
+      out << line << '\n';
+    }
+  }
+
+  /// Appends the nonzero `RunStats` census states, as in ` [connect=3 ttfb=12]`.
+  void census(std::ostream& line) const {
+    auto is_empty = true;
+    for (std::size_t state{}; state < state_names.size(); ++state) {
+      const auto waiting = stats.waiting(static_cast<CoroutineState>(state));
+      if (waiting != 0U) {
+        line << (is_empty ? " [" : " ") << state_names[state] << '=' << waiting;
+        is_empty = false;
+      }
+    }
+    if (!is_empty) {
+      line << ']';
+    }
+  }
+
+  [[nodiscard]] std::string eta(double done) const {
+    if (done <= 0.0) {
+      return "--:--:--";
+    }
+    const auto elapsed = stats.elapsed_seconds();
+    const auto remaining = static_cast<long long>(elapsed / done - elapsed);
+    const auto seconds = remaining > 0 ? remaining : 0LL;
+    std::ostringstream formatted;
+    formatted << std::setfill('0') << seconds / 3600 << ':' << std::setw(2) << seconds / 60 % 60
+              << ':' << std::setw(2) << seconds % 60;
+    return formatted.str();
+  }
+
+  PeriodicTimer ticker;
+  const RunStats& stats;
+  const std::optional<std::size_t> total;
+  std::ostream& out;
+  const bool in_place;
+  bool is_drawn{};
+  std::chrono::steady_clock::time_point previous;
+  std::size_t previous_attempted{};
+  std::size_t previous_received{};
+};
+} // namespace abrade
@@ -3,70 +3,238 @@
 #include <abrade/action.hpp>
 #include <abrade/candidate.hpp>
 #include <abrade/exception.hpp>
+#include <abrade/head_fallback.hpp>
 #include <abrade/http_status.hpp>
 #include <abrade/network_timeout.hpp>
+#include <abrade/probes.hpp>
 #include <abrade/redirect_policy.hpp>
 #include <abrade/run_stats.hpp>
+#include <abrade/scraper_runtime.hpp>
+#include <abrade/worker_pool.hpp>
+#include <abrade/writer.hpp>
 #include <boost/asio/spawn.hpp>
 #include <boost/beast/core.hpp>
-#include <boost/beast/core/buffers_to_string.hpp>
 #include <boost/beast/http.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <system_error>
 #include <utility>
+#include <vector>
 
 namespace abrade {
 
 // TODO: Add POST-style queries only after Candidate request bodies become product behavior.
 
-/// Executes GET requests and forwards response bodies to a `GetAction`.
+/// Size of the per-request buffer that GET response bodies are read through.
+inline constexpr std::size_t body_chunk_size{64U * 1024U};
+
+/// Turns a redirect target into a follow-up candidate whose method the query chooses.
+inline std::optional<Candidate> follow_redirect(std::optional<std::string> target) {
+  if (!target) {
+    return std::nullopt;
+  }
+  return make_candidate(std::move(*target));
+}
+
+/// Asks for a candidate to be requested again on a new connection, optionally with `method`.
+inline Candidate retry_candidate(std::string_view description,
+                                 std::optional<boost::beast::http::verb> method = std::nullopt) {
+  auto retry = make_candidate(std::string{description});
+  retry.method = method;
+  retry.retry = true;
+  return retry;
+}
+
+/// Executes GET requests and streams response bodies to a `GetAction`.
 ///
 /// Status printing is owned here because the query layer sees both the response
-/// status and the user-facing candidate description.
+/// status and the user-facing candidate description. Bodies are read through a
+/// fixed-size chunk buffer, so per-coroutine memory does not grow with body size
+/// and Beast's default in-memory body limit does not apply.
+///
+/// The header is read first so the body decision can be made from it: 2xx bodies
+/// whose header passes the action's header filters are streamed to the action,
+/// 2xx bodies rejected by those filters and bodies of followed redirects are never
+/// read, and other non-2xx bodies are abandoned by closing the connection or,
+/// without `close_error_bodies`, drained. A 2xx body is also abandoned
+/// mid-transfer as soon as a rejected content filter matches.
+///
+/// This query only moves bytes: filtering and spooling of each 2xx chunk, and
+/// the final commit, run on the `WorkerPool`. Drained bodies are discarded on
+/// the networking thread and never reach the pool. Verbose mode echoes body
+/// chunks from the networking thread as they are read, never from a worker, and
+/// deliberately does not change which bodies are written.
 struct GetQuery {
   GetQuery(GetAction response_action, bool should_print_found, bool verbose_output,
-           RedirectPolicy redirect_options, RunStats& run_stats)
+           RedirectPolicy redirect_options, bool close_error_bodies, WorkerPool& body_workers,
+           RunStats& run_stats)
       : print_found{should_print_found}, verbose{verbose_output},
-        redirect_policy{std::move(redirect_options)}, stats{run_stats},
-        action{std::move(response_action)} {}
+        close_errors{close_error_bodies}, redirect_policy{std::move(redirect_options)},
+        workers{body_workers}, stats{run_stats}, action{std::move(response_action)} {}
 
-  /// Reads the full response, processes it, prints status, and returns a follow-up redirect target.
+  /// Streams the response, processes it, prints status, and returns a follow-up redirect.
   template <typename Stream>
-  std::optional<std::string> execute(Stream& stream, const std::string_view& description,
-                                     const boost::asio::yield_context& yield) {
+  std::optional<Candidate> execute(Stream& stream, const std::string_view& description,
+                                   boost::beast::http::verb /*method*/,
+                                   const boost::asio::yield_context& yield) {
+    return fetch(stream, description, yield, [](unsigned int) {});
+  }
+
+  /// Like `execute`, but hands the status to `on_status` as soon as the header is read.
+  template <typename Stream, typename StatusObserver>
+  std::optional<Candidate> fetch(Stream& stream, const std::string_view& description,
+                                 const boost::asio::yield_context& yield,
+                                 StatusObserver&& on_status) {
     boost::beast::flat_buffer buffer;
-    boost::beast::http::response<boost::beast::http::dynamic_body> response;
-    await_stream_with_timeout(stream, "get query", yield,
-                              [&stream, &buffer, &response](auto token) {
-                                boost::beast::http::async_read(stream, buffer, response, token);
-                              });
-    const auto status_code = response.result_int();
+    boost::beast::http::response_parser<boost::beast::http::buffer_body> parser;
+    parser.body_limit(std::numeric_limits<std::uint64_t>::max());
+    const TraceKey request{&boost::beast::get_lowest_layer(stream)};
+    PhaseTimer phase{stats, Phase::first_byte, request};
+    await_stream_with_timeout(stream, "get query", yield, [&stream, &buffer, &parser](auto token) {
+      boost::beast::http::async_read_header(stream, buffer, parser, token);
+    });
+    phase.finish();
+    const auto status_code = parser.get().result_int();
+    on_status(status_code);
     stats.record_response(status_code);
-    const auto body = boost::beast::buffers_to_string(response.body().data());
-    action.process(status_code, body, description);
+    ABRADE_PROBE2(response, request, status_code);
+    auto redirect = redirect_policy.redirect_target(status_code, parser.get().base(), description);
+    const auto success = is_success_status(status_code);
+    const auto admitted = !success || action.admits(parser.get().base());
+    if (!admitted) {
+      stats.record_header_filtered();
+    }
+    auto found = success && admitted;
+    if (success && admitted) {
+      auto response = action.open(status_code, parser.get().base(), description);
+      read_body(stream, buffer, parser, description, yield, [&](std::string_view filled) {
+        const auto filtering = std::chrono::steady_clock::now();
+        const auto keep_reading = [&] {
+          const StateScope output{stats, CoroutineState::output};
+          return workers.run([&response, filled] { return response.write(filled); }, yield);
+        }();
+        stats.trace_span(request, "filter", filtering);
+        return keep_reading;
+      });
+      const auto finishing = std::chrono::steady_clock::now();
+      {
+        const StateScope output{stats, CoroutineState::output};
+        workers.run([&response] { response.finish(); }, yield);
+      }
+      stats.trace_span(request, "write-out", finishing);
+      response.report();
+      found = found && !response.soft_not_found() && !response.length_rejected();
+    } else if (!success && !redirect && !close_errors) {
+      read_body(stream, buffer, parser, description, yield, [](std::string_view) { return true; });
+    } else {
+      skip_body(stream, buffer, parser);
+    }
 
-    if (print_found && is_success_status(status_code)) {
+    if (found) {
+      stats.record_hit();
+    }
+    if (print_found && found) {
       std::cout << "[+] Status of " << description << ": " << status_code << '\n';
     } else if (verbose) {
       std::cout << "[-] Status of " << description << ": " << status_code << '\n';
     }
-    return redirect_policy.redirect_target(status_code, response.base(), description);
+    return follow_redirect(std::move(redirect));
   }
 
   /// Returns the configured maximum number of redirect hops.
   [[nodiscard]] std::size_t max_redirects() const noexcept { return redirect_policy.max_redirects; }
 
+  /// Returns true when a 2xx response header passes the action's header filters.
+  template <typename Fields> [[nodiscard]] bool admits(const Fields& header) const {
+    return action.admits(header);
+  }
+
   /// Applies the HTTP method expected by this query type.
   template <typename Request> static void set_method(Request& request) {
     request.method(boost::beast::http::verb::get);
   }
 
 private:
-  bool print_found, verbose;
+  /// Streams the body to `on_chunk`, abandoning the transfer once it returns false.
+  ///
+  /// Verbose mode echoes each chunk here, before it is handed to a worker.
+  /// Only time spent waiting on the socket counts toward `Phase::body`; worker
+  /// time is reported by the `WorkerPool` metrics instead. A traced request
+  /// gets a `body` span per chunk read.
+  template <typename Stream, typename Parser, typename ChunkHandler>
+  void read_body(Stream& stream, boost::beast::flat_buffer& buffer, Parser& parser,
+                 std::string_view description, const boost::asio::yield_context& yield,
+                 ChunkHandler&& on_chunk) {
+    const TraceKey request{&boost::beast::get_lowest_layer(stream)};
+    std::vector<char> chunk(body_chunk_size);
+    std::uint64_t received{};
+    std::chrono::steady_clock::duration reading{};
+    if (verbose) {
+      std::cout << "[ ] Response body from " << description << ":\n";
+    }
+    while (!parser.is_done()) {
+      parser.get().body().data = chunk.data();
+      parser.get().body().size = chunk.size();
+      const auto started = std::chrono::steady_clock::now();
+      const auto ec = [&] {
+        const StateScope body{stats, CoroutineState::body};
+        return try_await_stream_with_timeout(
+            stream, "get query", yield, [&stream, &buffer, &parser](auto token) {
+              boost::beast::http::async_read(stream, buffer, parser, token);
+            });
+      }();
+      reading += std::chrono::steady_clock::now() - started;
+      stats.trace_span(request, phase_names[static_cast<std::size_t>(Phase::body)], started);
+      if (ec && ec != boost::beast::http::error::need_buffer) {
+        throw AbradeException{"get query", ec};
+      }
+      const std::string_view filled{chunk.data(), chunk.size() - parser.get().body().size};
+      received += filled.size();
+      stats.record_bytes_received(filled.size());
+      ABRADE_PROBE2(body_bytes, request, filled.size());
+      if (verbose) {
+        std::cout << filled;
+      }
+      if (!on_chunk(filled) && !parser.is_done()) {
+        stats.record_body_aborted(drop_connection(stream, buffer, parser, received));
+        break;
+      }
+    }
+    if (verbose) {
+      std::cout << '\n';
+    }
+    stats.record_phase(Phase::body, reading, request);
+  }
+
+  /// Closes the connection rather than transferring a body nobody will look at.
+  template <typename Stream, typename Parser>
+  void skip_body(Stream& stream, const boost::beast::flat_buffer& buffer, const Parser& parser) {
+    if (parser.is_done()) {
+      return;
+    }
+    stats.record_body_skipped(drop_connection(stream, buffer, parser, 0U));
+  }
+
+  /// Closes the transport and returns how many declared body bytes were never transferred.
+  template <typename Stream, typename Parser>
+  static std::size_t drop_connection(Stream& stream, const boost::beast::flat_buffer& buffer,
+                                     const Parser& parser, std::uint64_t received) {
+    const auto declared = parser.content_length().value_or(0U);
+    const auto transferred = received + static_cast<std::uint64_t>(buffer.size());
+    boost::system::error_code ignored;
+    boost::beast::get_lowest_layer(stream).close(ignored);
+    return static_cast<std::size_t>(declared > transferred ? declared - transferred : 0U);
+  }
+
+  bool print_found, verbose, close_errors;
   RedirectPolicy redirect_policy;
+  WorkerPool& workers;
   RunStats& stats;
   GetAction action;
 };
@@ -74,49 +242,225 @@ private:
 /// Executes HEAD requests and forwards candidate status to a `HeadAction`.
 ///
 /// Only response headers are read. This is the default probe mode because it
-/// avoids response-body transfer when existence is the only question.
+/// avoids response-body transfer when existence is the only question; header
+/// filters let it also tell real content from soft error pages by type or size.
+///
+/// Servers that refuse HEAD with 405 or 501, or that answer HEAD with a miss
+/// where GET succeeds, are detected by `HeadFallback` from rechecks of the first
+/// such answers. A recheck writes a `RangedGet` on the same connection; when the
+/// server closed it, the candidate is returned as its own follow-up target. Once
+/// the fallback is active, every request is a ranged GET whose body is never read;
+/// the method `RequestWriter` reports having written tells the two apart.
 struct HeadQuery {
   HeadQuery(HeadAction response_action, bool should_print_found, bool verbose_output,
-            RedirectPolicy redirect_options, RunStats& run_stats)
+            RedirectPolicy redirect_options, RequestWriter request_writer, bool head_fallback,
+            RunStats& run_stats)
       : print_found{should_print_found}, verbose{verbose_output},
-        redirect_policy{std::move(redirect_options)}, stats{run_stats},
-        action{std::move(response_action)} {}
+        redirect_policy{std::move(redirect_options)}, writer{std::move(request_writer)},
+        fallback{head_fallback}, stats{run_stats}, action{std::move(response_action)} {}
 
   /// Reads response headers, processes status, prints status, and returns a follow-up redirect
-  /// target.
+  /// or retry.
   template <typename Stream>
-  std::optional<std::string> execute(Stream& stream, const std::string_view& description,
-                                     const boost::asio::yield_context& yield) {
+  std::optional<Candidate> execute(Stream& stream, const std::string_view& description,
+                                   boost::beast::http::verb method,
+                                   const boost::asio::yield_context& yield) {
+    const auto sent_get = method != boost::beast::http::verb::head;
     boost::beast::flat_buffer buffer;
     boost::beast::http::response_parser<boost::beast::http::empty_body> parser;
-    await_stream_with_timeout(stream, "head query", yield, [&stream, &buffer, &parser](auto token) {
-      boost::beast::http::async_read_header(stream, buffer, parser, token);
-    });
-    const auto& response = parser.release();
+    // HEAD responses carry the GET Content-Length but never a body; a ranged GET body is unread.
+    parser.skip(true);
+    read_header(stream, buffer, parser, yield);
+    std::optional<boost::beast::http::response_parser<boost::beast::http::empty_body>> recheck;
+    if (!sent_get && fallback.should_recheck(parser.get().result_int())) {
+      const auto head_status = parser.get().result_int();
+      if (!parser.keep_alive()) {
+        if (HeadFallback::rejects_head(head_status)) {
+          if (fallback.activate()) {
+            announce_fallback(head_status, description);
+          }
+          return retry_candidate(description);
+        }
+      } else {
+        stats.record_head_fallback(true);
+        writer.make_request(stream, RangedGet{}, make_candidate(std::string{description}), yield);
+        boost::beast::flat_buffer recheck_buffer;
+        recheck.emplace().skip(true);
+        read_header(stream, recheck_buffer, *recheck, yield);
+        if (fallback.observe(head_status, recheck->get().result_int())) {
+          announce_fallback(head_status, description);
+        }
+      }
+    }
+
+    const auto& response = recheck ? recheck->get() : parser.get();
     const auto status_code = response.result_int();
     stats.record_response(status_code);
-    action.process(response.result_int(), description);
+    ABRADE_PROBE2(response, &boost::beast::get_lowest_layer(stream), status_code);
+    const auto discovery = action.process(status_code, response.base(), description);
+    if (discovery == Discovery::header_filtered) {
+      stats.record_header_filtered();
+    } else if (discovery == Discovery::soft_not_found) {
+      stats.record_soft_not_found();
+    }
 
-    if (print_found && is_success_status(status_code)) {
+    if (discovery == Discovery::found) {
+      stats.record_hit();
+    }
+    if (print_found && discovery == Discovery::found) {
       std::cout << "[+] Status of " << description << ": " << status_code << '\n';
     } else if (verbose) {
       std::cout << "[-] Status of " << description << ": " << status_code << '\n';
     }
-    return redirect_policy.redirect_target(status_code, response.base(), description);
+    return follow_redirect(
+        redirect_policy.redirect_target(status_code, response.base(), description));
   }
 
   /// Returns the configured maximum number of redirect hops.
   [[nodiscard]] std::size_t max_redirects() const noexcept { return redirect_policy.max_redirects; }
 
-  /// Applies the HTTP method expected by this query type.
-  template <typename Request> static void set_method(Request& request) {
-    request.method(boost::beast::http::verb::head);
+  /// Applies HEAD, or a `RangedGet` once the fallback is active.
+  template <typename Request> void set_method(Request& request) {
+    if (!fallback.active()) {
+      request.method(boost::beast::http::verb::head);
+      return;
+    }
+    RangedGet::set_method(request);
+    stats.record_head_fallback(false);
   }
 
 private:
+  template <typename Stream, typename Parser>
+  void read_header(Stream& stream, boost::beast::flat_buffer& buffer, Parser& parser,
+                   const boost::asio::yield_context& yield) {
+    PhaseTimer phase{stats, Phase::first_byte, &boost::beast::get_lowest_layer(stream)};
+    await_stream_with_timeout(stream, "head query", yield, [&stream, &buffer, &parser](auto token) {
+      boost::beast::http::async_read_header(stream, buffer, parser, token);
+    });
+    phase.finish();
+  }
+
+  static void announce_fallback(unsigned int head_status, std::string_view description) {
+    std::cout << "[!] HEAD " << description << " answered " << head_status
+              << "; falling back to GET with Range: bytes=0-0\n";
+  }
+
   bool print_found, verbose;
   RedirectPolicy redirect_policy;
+  RequestWriter writer;
+  HeadFallback fallback;
   RunStats& stats;
   HeadAction action;
 };
+
+/// Probes candidates with HEAD and promotes only 2xx hits to a `GetQuery`.
+///
+/// The HEAD response is read first; a 2xx whose header passes the GET action's
+/// header filters is followed by a GET for the same target on the same
+/// connection, and that response is handled exactly as in contents mode. Misses
+/// cost one header exchange, so sparse spaces transfer almost no body bytes.
+///
+/// Promotion reuses the connection. When the server closes it after the HEAD
+/// response, the candidate is returned as its own follow-up with a GET method,
+/// so the hit is fetched on a fresh connection. Only promoted GET responses are
+/// counted under their final status; misses and header-filtered hits are
+/// counted from the HEAD response.
+///
+/// HEAD answers are rechecked by `HeadFallback` as in `HeadQuery`, except that
+/// the recheck is the full GET the candidate would be promoted to. Once the
+/// fallback is active, candidates are sent straight as GET and handled by the
+/// `GetQuery`.
+struct ProbeQuery {
+  ProbeQuery(GetQuery get_query, RequestWriter request_writer, bool verbose_output,
+             RedirectPolicy redirect_options, bool head_fallback, RunStats& run_stats)
+      : verbose{verbose_output}, redirect_policy{std::move(redirect_options)},
+        fallback{head_fallback}, stats{run_stats}, get{std::move(get_query)},
+        writer{std::move(request_writer)} {}
+
+  /// Probes the candidate, promotes a hit to GET, and returns a follow-up redirect or retry.
+  template <typename Stream>
+  std::optional<Candidate> execute(Stream& stream, const std::string_view& description,
+                                   boost::beast::http::verb method,
+                                   const boost::asio::yield_context& yield) {
+    if (method != boost::beast::http::verb::head) {
+      return get.execute(stream, description, method, yield);
+    }
+    boost::beast::flat_buffer buffer;
+    boost::beast::http::response_parser<boost::beast::http::empty_body> parser;
+    parser.skip(true);
+    PhaseTimer phase{stats, Phase::first_byte, &boost::beast::get_lowest_layer(stream)};
+    await_stream_with_timeout(
+        stream, "probe query", yield, [&stream, &buffer, &parser](auto token) {
+          boost::beast::http::async_read_header(stream, buffer, parser, token);
+        });
+    phase.finish();
+    stats.record_probe();
+    const auto status_code = parser.get().result_int();
+    const auto success = is_success_status(status_code);
+    if (success && get.admits(parser.get().base())) {
+      stats.record_promotion();
+      if (!parser.keep_alive()) {
+        return retry_candidate(description, boost::beast::http::verb::get);
+      }
+      const auto promoted =
+          writer.make_request(stream, get, make_candidate(std::string{description}), yield);
+      return get.execute(stream, description, promoted, yield);
+    }
+    if (fallback.should_recheck(status_code)) {
+      if (!parser.keep_alive()) {
+        if (HeadFallback::rejects_head(status_code)) {
+          if (fallback.activate()) {
+            announce_fallback(status_code, description);
+          }
+          return retry_candidate(description);
+        }
+      } else {
+        stats.record_head_fallback(true);
+        writer.make_request(stream, get, make_candidate(std::string{description}), yield);
+        return get.fetch(stream, description, yield, [&](unsigned int get_status) {
+          if (fallback.observe(status_code, get_status)) {
+            announce_fallback(status_code, description);
+          }
+        });
+      }
+    }
+
+    stats.record_response(status_code);
+    if (success) {
+      stats.record_header_filtered();
+    }
+    if (verbose) {
+      std::cout << "[-] Status of " << description << ": " << status_code << '\n';
+    }
+    return follow_redirect(
+        redirect_policy.redirect_target(status_code, parser.get().base(), description));
+  }
+
+  /// Returns the configured maximum number of redirect hops.
+  [[nodiscard]] std::size_t max_redirects() const noexcept { return redirect_policy.max_redirects; }
+
+  /// Applies HEAD, or GET once the fallback is active; promoted requests use
+  /// `GetQuery::set_method`.
+  template <typename Request> void set_method(Request& request) {
+    if (!fallback.active()) {
+      request.method(boost::beast::http::verb::head);
+      return;
+    }
+    GetQuery::set_method(request);
+    stats.record_head_fallback(false);
+  }
+
+private:
+  static void announce_fallback(unsigned int head_status, std::string_view description) {
+    std::cout << "[!] HEAD " << description << " answered " << head_status
+              << "; falling back to GET for every candidate\n";
+  }
+
+  bool verbose;
+  RedirectPolicy redirect_policy;
+  HeadFallback fallback;
+  RunStats& stats;
+  GetQuery get;
+  RequestWriter writer;
+};
 } // namespace abrade
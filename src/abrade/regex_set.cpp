@@ -0,0 +1,536 @@
+#include <abrade/regex_set.hpp>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace abrade {
+
+using namespace std;
+
+namespace {
+constexpr size_t max_nodes{1U << 16U};
+constexpr size_t max_repeat{1000};
+constexpr auto unbounded = numeric_limits<size_t>::max();
+
+/// Thrown while compiling a pattern that uses syntax the DFA does not implement.
+struct UnsupportedSyntax {};
+
+struct Ast {
+  enum class Kind : uint8_t { bytes, concat, alternate, repeat };
+
+  Kind kind{Kind::concat};
+  bitset<256> set;
+  vector<Ast> children;
+  size_t min{};
+  size_t max{};
+};
+
+Ast make_bytes(const bitset<256>& set) {
+  Ast result;
+  result.kind = Ast::Kind::bytes;
+  result.set = set;
+  return result;
+}
+
+bitset<256> byte_range(unsigned int low, unsigned int high) {
+  bitset<256> result;
+  for (auto value = low; value <= high; ++value) {
+    result.set(value);
+  }
+  return result;
+}
+
+bitset<256> word_bytes() {
+  auto result = byte_range('a', 'z') | byte_range('A', 'Z') | byte_range('0', '9');
+  result.set('_');
+  return result;
+}
+
+bitset<256> space_bytes() { return byte_range('\t', '\r') | byte_range(' ', ' '); }
+
+bool is_alnum(unsigned char value) {
+  return (value >= 'a' && value <= 'z') || (value >= 'A' && value <= 'Z') ||
+         (value >= '0' && value <= '9');
+}
+
+/// Returns true for the punctuation Boost reads as an anchor when escaped, not as a literal.
+bool is_escaped_anchor(unsigned char value) {
+  return value == '<' || value == '>' || value == '`' || value == '\'';
+}
+
+int hex_value(unsigned char value) {
+  if (value >= '0' && value <= '9') {
+    return value - '0';
+  }
+  if (value >= 'a' && value <= 'f') {
+    return value - 'a' + 10;
+  }
+  if (value >= 'A' && value <= 'F') {
+    return value - 'A' + 10;
+  }
+  throw UnsupportedSyntax{};
+}
+
+unsigned int only_byte(const bitset<256>& set) {
+  for (unsigned int value{}; value < 256U; ++value) {
+    if (set.test(value)) {
+      return value;
+    }
+  }
+  throw UnsupportedSyntax{};
+}
+
+/// Recursive-descent parser for the DFA-compatible subset of Boost's Perl syntax.
+///
+/// Anything outside the subset throws `UnsupportedSyntax`, including spellings
+/// that Boost accepts with a special meaning (a lone `{` or `]` is a literal in
+/// Boost) so that a supported pattern never diverges from `boost::regex`.
+class Parser {
+public:
+  explicit Parser(string_view text) : pattern{text} {}
+
+  Ast parse() {
+    auto result = alternation();
+    if (!at_end()) {
+      throw UnsupportedSyntax{};
+    }
+    return result;
+  }
+
+private:
+  [[nodiscard]] bool at_end() const noexcept { return position == pattern.size(); }
+
+  [[nodiscard]] unsigned char peek() const {
+    if (at_end()) {
+      throw UnsupportedSyntax{};
+    }
+    return static_cast<unsigned char>(pattern[position]);
+  }
+
+  unsigned char take() {
+    const auto value = peek();
+    ++position;
+    return value;
+  }
+
+  Ast alternation() {
+    Ast result;
+    result.kind = Ast::Kind::alternate;
+    result.children.push_back(concatenation());
+    while (!at_end() && peek() == '|') {
+      ++position;
+      result.children.push_back(concatenation());
+    }
+    if (result.children.size() == 1U) {
+      return std::move(result.children.front());
+    }
+    return result;
+  }
+
+  Ast concatenation() {
+    Ast result;
+    while (!at_end() && peek() != '|' && peek() != ')') {
+      result.children.push_back(repetition());
+    }
+    return result;
+  }
+
+  Ast repetition() {
+    auto operand = atom();
+    if (at_end()) {
+      return operand;
+    }
+    Ast result;
+    result.kind = Ast::Kind::repeat;
+    switch (peek()) {
+    case '*':
+      result.max = unbounded;
+      break;
+    case '+':
+      result.min = 1;
+      result.max = unbounded;
+      break;
+    case '?':
+      result.max = 1;
+      break;
+    case '{':
+      break;
+    default:
+      return operand;
+    }
+    if (take() == '{') {
+      bounds(result);
+    }
+    // Lazy quantifiers accept the same bodies; possessive and stacked ones do not.
+    if (!at_end() && peek() == '?') {
+      ++position;
+    }
+    if (!at_end() && (peek() == '*' || peek() == '+' || peek() == '?' || peek() == '{')) {
+      throw UnsupportedSyntax{};
+    }
+    result.children.push_back(std::move(operand));
+    return result;
+  }
+
+  void bounds(Ast& repeat) {
+    repeat.min = number();
+    repeat.max = repeat.min;
+    if (peek() == ',') {
+      ++position;
+      repeat.max = peek() == '}' ? unbounded : number();
+    }
+    if (take() != '}' || repeat.max < repeat.min) {
+      throw UnsupportedSyntax{};
+    }
+  }
+
+  size_t number() {
+    size_t result{};
+    size_t digits{};
+    while (peek() >= '0' && peek() <= '9') {
+      result = (result * 10U) + static_cast<size_t>(take() - '0');
+      if (++digits > 4U || result > max_repeat) {
+        throw UnsupportedSyntax{};
+      }
+    }
+    if (digits == 0U) {
+      throw UnsupportedSyntax{};
+    }
+    return result;
+  }
+
+  Ast atom() {
+    const auto value = take();
+    switch (value) {
+    case '(': {
+      if (peek() == '?') {
+        ++position;
+        if (take() != ':') {
+          throw UnsupportedSyntax{};
+        }
+      }
+      auto inner = alternation();
+      if (take() != ')') {
+        throw UnsupportedSyntax{};
+      }
+      return inner;
+    }
+    case '[':
+      return make_bytes(byte_class());
+    case '.':
+      return make_bytes(bitset<256>{}.set());
+    case '\\':
+      return make_bytes(escape());
+    case '^':
+    case '$':
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+    case '}':
+    case ']':
+    case ')':
+    case '|':
+      throw UnsupportedSyntax{};
+    default:
+      return make_bytes(byte_range(value, value));
+    }
+  }
+
+  bitset<256> escape() {
+    const auto value = take();
+    switch (value) {
+    case 'd':
+      return byte_range('0', '9');
+    case 'D':
+      return ~byte_range('0', '9');
+    case 'w':
+      return word_bytes();
+    case 'W':
+      return ~word_bytes();
+    case 's':
+      return space_bytes();
+    case 'S':
+      return ~space_bytes();
+    case 'n':
+      return byte_range('\n', '\n');
+    case 't':
+      return byte_range('\t', '\t');
+    case 'r':
+      return byte_range('\r', '\r');
+    case 'f':
+      return byte_range('\f', '\f');
+    case 'a':
+      return byte_range('\a', '\a');
+    case 'e':
+      return byte_range(0x1BU, 0x1BU);
+    case 'x': {
+      const auto high = hex_value(take());
+      const auto code = static_cast<unsigned int>((high * 16) + hex_value(take()));
+      return byte_range(code, code);
+    }
+    default:
+      if (is_alnum(value) || is_escaped_anchor(value)) {
+        throw UnsupportedSyntax{};
+      }
+      return byte_range(value, value);
+    }
+  }
+
+  bitset<256> byte_class() {
+    const auto negated = peek() == '^';
+    if (negated) {
+      ++position;
+    }
+    if (peek() == ']') {
+      throw UnsupportedSyntax{};
+    }
+    bitset<256> result;
+    for (auto value = take(); value != ']'; value = take()) {
+      if (value == '[') {
+        throw UnsupportedSyntax{};
+      }
+      const auto element = value == '\\' ? escape() : byte_range(value, value);
+      if (peek() != '-' || pattern.substr(position + 1U, 1U) == "]") {
+        result |= element;
+        continue;
+      }
+      ++position;
+      const auto low = only_byte(element.count() == 1U ? element : bitset<256>{});
+      const auto end = take();
+      if (end == '[') {
+        throw UnsupportedSyntax{};
+      }
+      const auto high_set = end == '\\' ? escape() : byte_range(end, end);
+      const auto high = only_byte(high_set.count() == 1U ? high_set : bitset<256>{});
+      if (high < low) {
+        throw UnsupportedSyntax{};
+      }
+      result |= byte_range(low, high);
+    }
+    return negated ? ~result : result;
+  }
+
+  string_view pattern;
+  size_t position{};
+};
+} // namespace
+
+/// Lowers parsed patterns into the shared Thompson NFA of a `RegexSet`.
+class RegexCompiler {
+public:
+  explicit RegexCompiler(RegexSet& regex_set) : set{regex_set} {}
+
+  uint32_t accept(size_t pattern) {
+    return add({RegexSet::Node::Kind::match, static_cast<uint32_t>(pattern), RegexSet::missing,
+                RegexSet::missing});
+  }
+
+  /// Emits `ast` so that a successful match continues at `out`; returns the entry node.
+  uint32_t compile(const Ast& ast, uint32_t out) {
+    switch (ast.kind) {
+    case Ast::Kind::bytes:
+      return add({RegexSet::Node::Kind::byte_set, byte_set(ast.set), out, RegexSet::missing});
+    case Ast::Kind::concat:
+      for (auto child = ast.children.rbegin(); child != ast.children.rend(); ++child) {
+        out = compile(*child, out);
+      }
+      return out;
+    case Ast::Kind::alternate: {
+      auto entry = compile(ast.children.back(), out);
+      for (auto index = ast.children.size() - 1U; index-- > 0U;) {
+        const auto first = compile(ast.children[index], out);
+        entry = add({RegexSet::Node::Kind::split, 0U, first, entry});
+      }
+      return entry;
+    }
+    case Ast::Kind::repeat:
+      break;
+    }
+    const auto& operand = ast.children.front();
+    auto tail = out;
+    if (ast.max == unbounded) {
+      tail = add({RegexSet::Node::Kind::split, 0U, RegexSet::missing, out});
+      const auto body = compile(operand, tail);
+      set.nodes[tail].next = body;
+    } else {
+      for (auto count = ast.min; count < ast.max; ++count) {
+        const auto body = compile(operand, tail);
+        tail = add({RegexSet::Node::Kind::split, 0U, body, out});
+      }
+    }
+    for (size_t count{}; count < ast.min; ++count) {
+      tail = compile(operand, tail);
+    }
+    return tail;
+  }
+
+private:
+  uint32_t add(RegexSet::Node node) {
+    if (set.nodes.size() >= max_nodes) {
+      throw UnsupportedSyntax{};
+    }
+    set.nodes.push_back(node);
+    return static_cast<uint32_t>(set.nodes.size() - 1U);
+  }
+
+  uint32_t byte_set(const bitset<256>& bytes) {
+    const auto [entry, inserted] =
+        set_ids.emplace(bytes.to_string(), static_cast<uint32_t>(set.byte_sets.size()));
+    if (inserted) {
+      set.byte_sets.push_back(bytes);
+    }
+    return entry->second;
+  }
+
+  RegexSet& set;
+  map<string, uint32_t> set_ids;
+};
+
+RegexSet::RegexSet(const vector<string>& patterns) : pattern_starts(patterns.size(), missing) {
+  RegexCompiler compiler{*this};
+  for (size_t index{}; index < patterns.size(); ++index) {
+    const auto rollback = nodes.size();
+    try {
+      const auto ast = Parser{patterns[index]}.parse();
+      pattern_starts[index] = compiler.compile(ast, compiler.accept(index));
+      start_nodes.push_back(pattern_starts[index]);
+      ++supported_count;
+    } catch (const UnsupportedSyntax&) {
+      nodes.resize(rollback);
+    }
+  }
+  if (supported_count == 0U) {
+    return;
+  }
+
+  // Bytes that fall in exactly the same byte sets are interchangeable to the DFA.
+  map<vector<bool>, uint16_t> classes;
+  for (unsigned int value{}; value < 256U; ++value) {
+    vector<bool> signature;
+    signature.reserve(byte_sets.size());
+    for (const auto& bytes : byte_sets) {
+      signature.push_back(bytes.test(value));
+    }
+    const auto [entry, inserted] =
+        classes.emplace(std::move(signature), static_cast<uint16_t>(classes.size()));
+    if (inserted) {
+      class_representatives.push_back(static_cast<unsigned char>(value));
+    }
+    byte_classes.at(value) = entry->second;
+  }
+
+  vector<uint32_t> marks(nodes.size());
+  close_over(start_nodes, marks, 1U);
+}
+
+void RegexSet::close_over(vector<uint32_t>& sources, vector<uint32_t>& marks,
+                          uint32_t generation) const {
+  vector<uint32_t> pending;
+  pending.swap(sources);
+  while (!pending.empty()) {
+    const auto id = pending.back();
+    pending.pop_back();
+    if (marks[id] == generation) {
+      continue;
+    }
+    marks[id] = generation;
+    const auto& node = nodes[id];
+    if (node.kind == Node::Kind::split) {
+      pending.push_back(node.alternative);
+      pending.push_back(node.next);
+    } else {
+      sources.push_back(id);
+    }
+  }
+  ranges::sort(sources);
+}
+
+RegexSet::Scanner::Scanner(const RegexSet& regex_set)
+    : set{&regex_set}, marks(regex_set.nodes.size()), found(regex_set.pattern_starts.size()),
+      remaining{regex_set.supported_count} {
+  if (set->empty()) {
+    return;
+  }
+  current = intern(set->start_nodes);
+  record(current);
+}
+
+void RegexSet::Scanner::feed(string_view chunk) {
+  if (remaining == 0U) {
+    return;
+  }
+  const auto class_count = set->class_representatives.size();
+  auto state = current;
+  for (const auto element : chunk) {
+    const auto byte_class = set->byte_classes[static_cast<unsigned char>(element)];
+    auto next = transitions[(static_cast<size_t>(state) * class_count) + byte_class];
+    if (next == missing) {
+      next = advance(state, byte_class);
+    }
+    state = next;
+    if (!state_matches[state].empty()) {
+      record(state);
+      if (remaining == 0U) {
+        break;
+      }
+    }
+  }
+  current = state;
+}
+
+RegexSet::Scanner::State RegexSet::Scanner::intern(vector<uint32_t> nodes) {
+  const auto [entry, inserted] = state_ids.emplace(nodes, static_cast<State>(state_nodes.size()));
+  if (!inserted) {
+    return entry->second;
+  }
+  vector<uint32_t> matches;
+  for (const auto id : nodes) {
+    if (set->nodes[id].kind == Node::Kind::match) {
+      matches.push_back(set->nodes[id].value);
+    }
+  }
+  state_matches.push_back(std::move(matches));
+  state_nodes.push_back(std::move(nodes));
+  transitions.resize(transitions.size() + set->class_representatives.size(), missing);
+  return entry->second;
+}
+
+RegexSet::Scanner::State RegexSet::Scanner::advance(State from, size_t byte_class) {
+  const auto representative = set->class_representatives[byte_class];
+  vector<uint32_t> targets;
+  for (const auto id : state_nodes[from]) {
+    const auto& node = set->nodes[id];
+    if (node.kind == Node::Kind::byte_set && set->byte_sets[node.value].test(representative)) {
+      targets.push_back(node.next);
+    }
+  }
+  // Every position may start a new match, which makes the search unanchored.
+  targets.insert(targets.end(), set->start_nodes.begin(), set->start_nodes.end());
+  if (++generation == 0U) {
+    ranges::fill(marks, 0U);
+    generation = 1U;
+  }
+  set->close_over(targets, marks, generation);
+
+  if (state_nodes.size() >= max_cached_states) {
+    state_ids.clear();
+    state_nodes.clear();
+    state_matches.clear();
+    transitions.clear();
+    return intern(std::move(targets));
+  }
+  const auto next = intern(std::move(targets));
+  transitions[(static_cast<size_t>(from) * set->class_representatives.size()) + byte_class] = next;
+  return next;
+}
+
+void RegexSet::Scanner::record(State state) {
+  for (const auto pattern : state_matches[state]) {
+    if (!found[pattern]) {
+      found[pattern] = true;
+      --remaining;
+    }
+  }
+}
+} // namespace abrade
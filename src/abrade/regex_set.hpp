@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace abrade {
+
+/// Set of regular expressions searched together by one lazily built DFA.
+///
+/// Each pattern is parsed into a Thompson NFA and the NFAs share one start
+/// state, so a body is scanned once for every pattern and each input byte does
+/// a bounded amount of work. Patterns that use constructs a DFA cannot express
+/// (anchors, word boundaries, backreferences, lookaround, possessive or inline
+/// modifiers, POSIX classes, and ambiguous literal braces) are left out;
+/// `supports` reports them so callers can fall back to `boost::regex`.
+///
+/// The supported syntax follows Boost's Perl defaults over bytes: `.` matches
+/// any byte including newline, and `\d`, `\w`, and `\s` use the C locale.
+class RegexSet {
+public:
+  RegexSet() = default;
+
+  /// Compiles every supported pattern; indexes follow `patterns`.
+  explicit RegexSet(const std::vector<std::string>& patterns);
+
+  /// Returns true when the pattern at `index` is searched by the DFA.
+  [[nodiscard]] bool supports(std::size_t index) const noexcept {
+    return index < pattern_starts.size() && pattern_starts[index] != missing;
+  }
+
+  /// Returns true when no pattern was compiled into the DFA.
+  [[nodiscard]] bool empty() const noexcept { return start_nodes.empty(); }
+
+  /// Resumable search over one body.
+  ///
+  /// DFA states are built on first use and cached per scanner, so scanners
+  /// share nothing mutable and may run on different threads. The cache is
+  /// flushed when it reaches `max_cached_states`; each input byte then costs at
+  /// most one state construction, which keeps a scan linear in the body size.
+  class Scanner {
+  public:
+    static constexpr std::size_t max_cached_states{2048};
+
+    explicit Scanner(const RegexSet& regex_set);
+
+    /// Advances the search over the next chunk of the body.
+    void feed(std::string_view chunk);
+
+    /// Returns true once the pattern at `index` has matched somewhere in the body.
+    [[nodiscard]] bool matched(std::size_t index) const {
+      return index < found.size() && found[index];
+    }
+
+  private:
+    using State = std::uint32_t;
+
+    [[nodiscard]] State intern(std::vector<std::uint32_t> nodes);
+    [[nodiscard]] State advance(State from, std::size_t byte_class);
+    void record(State state);
+
+    const RegexSet* set;
+    std::map<std::vector<std::uint32_t>, State> state_ids;
+    std::vector<std::vector<std::uint32_t>> state_nodes;
+    std::vector<std::vector<std::uint32_t>> state_matches;
+    std::vector<State> transitions;
+    std::vector<std::uint32_t> marks;
+    std::uint32_t generation{};
+    State current{};
+    std::vector<bool> found;
+    std::size_t remaining{};
+  };
+
+private:
+  struct Node {
+    enum class Kind : std::uint8_t { byte_set, split, match };
+
+    Kind kind;
+    std::uint32_t value;
+    std::uint32_t next;
+    std::uint32_t alternative;
+  };
+
+  static constexpr auto missing = std::uint32_t{0xFFFFFFFFU};
+
+  friend class RegexCompiler;
+
+  /// Returns the epsilon closure of `sources`, keeping only byte-consuming and match nodes.
+  void close_over(std::vector<std::uint32_t>& sources, std::vector<std::uint32_t>& marks,
+                  std::uint32_t generation) const;
+
+  std::vector<Node> nodes;
+  std::vector<std::bitset<256>> byte_sets;
+  std::vector<std::uint32_t> pattern_starts;
+  std::vector<std::uint32_t> start_nodes;
+  std::array<std::uint16_t, 256> byte_classes{};
+  std::vector<unsigned char> class_representatives;
+  std::size_t supported_count{};
+};
+} // namespace abrade
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <abrade/exception.hpp>
+#include <abrade/json_writer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace abrade {
+
+/// Identifies the request a span belongs to: the address of the socket the scraper opened for it.
+using TraceKey = const void*;
+
+/// Sampled per-candidate request spans, exported in Chrome trace-event format.
+///
+/// One candidate in every `sample_every` is traced. A traced candidate gets a
+/// lane, shown as a thread track in Perfetto or `chrome://tracing`, that is
+/// reused once the candidate finishes, so lanes roughly follow the scraper's
+/// coroutines. The scraper binds each request socket of a traced candidate to
+/// its lane; spans reported for any other socket cost one emptiness check, or
+/// one hash lookup while traced candidates are in flight.
+///
+/// Events stay in memory until `write` and are capped at `max_events`; later
+/// ones are counted as dropped. Span names must be string literals or other
+/// static strings. Like `RunStats`, this runs only on the networking thread.
+class RequestTracer {
+public:
+  /// Events kept before further ones are dropped, roughly 128 MiB.
+  static constexpr std::size_t max_events{std::size_t{1} << 20U};
+
+  explicit RequestTracer(std::size_t sample_every)
+      : every{std::max<std::size_t>(sample_every, 1U)} {}
+
+  /// Decides whether the next candidate is traced and returns its lane if so.
+  std::optional<std::size_t> begin_candidate() {
+    if (candidates++ % every != 0U) {
+      return std::nullopt;
+    }
+    sampled++;
+    if (free_lanes.empty()) {
+      return ++lane_count;
+    }
+    const auto lane = free_lanes.back();
+    free_lanes.pop_back();
+    return lane;
+  }
+
+  /// Records a traced candidate's span, labelled with its description and failure, if any.
+  void end_candidate(std::size_t lane, std::string_view description,
+                     std::chrono::steady_clock::time_point started, std::string_view error) {
+    add(Event{"candidate", micros(started), elapsed_micros(started), lane, std::string{description},
+              std::string{error}});
+    free_lanes.push_back(lane);
+  }
+
+  /// Attributes spans reported for `request` to `lane` until `unbind`.
+  void bind(TraceKey request, std::size_t lane) { bound[request] = lane; }
+
+  /// Stops attributing spans reported for `request`.
+  void unbind(TraceKey request) noexcept { bound.erase(request); }
+
+  /// Records a span of `request` that started at `started` and just finished, if it is traced.
+  void span(TraceKey request, std::string_view name,
+            std::chrono::steady_clock::time_point started) {
+    if (bound.empty()) {
+      return;
+    }
+    const auto found = bound.find(request);
+    if (found == bound.end()) {
+      return;
+    }
+    add(Event{name, micros(started), elapsed_micros(started), found->second, {}, {}});
+  }
+
+  /// Records the scraper's active and recommended coroutines as a counter track.
+  void concurrency(std::size_t active, std::size_t recommended) {
+    add(Event{"coroutines", micros(std::chrono::steady_clock::now()), {}, {}, {}, {}, true, active,
+              recommended});
+  }
+
+  /// Returns the number of traced candidates.
+  [[nodiscard]] std::size_t sampled_candidates() const noexcept { return sampled; }
+
+  /// Returns the number of events kept.
+  [[nodiscard]] std::size_t events() const noexcept { return trace.size(); }
+
+  /// Returns the number of events dropped after `max_events`.
+  [[nodiscard]] std::size_t dropped() const noexcept { return dropped_count; }
+
+  /// Writes the trace as Chrome trace-event JSON to `path`; throws `std::ios_base::failure`.
+  void write(const std::string& path) const {
+    std::ofstream file;
+    file.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+    file.open(path, std::ofstream::out | std::ofstream::trunc);
+    write(file);
+  }
+
+  /// Writes the trace as Chrome trace-event JSON to `out`.
+  void write(std::ostream& out) const {
+    detail::JsonWriter json{out};
+    json.begin_object();
+    json.member("displayTimeUnit", "ms");
+    json.begin_object("otherData");
+    json.member("sample_every", every);
+    json.member("sampled_candidates", sampled);
+    json.member("dropped_events", dropped_count);
+    json.end_object();
+    json.begin_array("traceEvents");
+    json.begin_object();
+    json.member("name", "process_name");
+    json.member("ph", "M");
+    json.member("pid", 1);
+    json.member("tid", 0);
+    json.begin_object("args");
+    json.member("name", "abrade");
+    json.end_object();
+    json.end_object();
+    for (const auto& event : trace) {
+      json.begin_object();
+      json.member("name", event.name);
+      json.member("cat", "abrade");
+      json.member("ph", event.is_counter ? "C" : "X");
+      json.member("ts", event.start);
+      json.member("pid", 1);
+      json.member("tid", event.lane);
+      if (event.is_counter) {
+        json.begin_object("args");
+        json.member("active", event.active);
+        json.member("recommended", event.recommended);
+        json.end_object();
+      } else {
+        json.member("dur", event.duration);
+      }
+      if (!event.candidate.empty()) {
+        json.begin_object("args");
+        json.member("candidate", event.candidate);
+        if (!event.error.empty()) {
+          json.member("error", event.error);
+        }
+        json.end_object();
+      }
+      json.end_object();
+    }
+    json.end_array();
+    json.end_object();
+    out << '\n';
+  }
+
+private:
+  struct Event {
+    std::string_view name;
+    std::uint64_t start{};
+    std::uint64_t duration{};
+    std::size_t lane{};
+    std::string candidate;
+    std::string error;
+    bool is_counter{};
+    std::size_t active{};
+    std::size_t recommended{};
+  };
+
+  void add(Event event) {
+    if (trace.size() == max_events) {
+      dropped_count++;
+      return;
+    }
+    trace.push_back(std::move(event));
+  }
+
+  [[nodiscard]] std::uint64_t micros(std::chrono::steady_clock::time_point at) const noexcept {
+    const auto since = std::chrono::duration_cast<std::chrono::microseconds>(at - origin).count();
+    return since > 0 ? static_cast<std::uint64_t>(since) : 0U;
+  }
+
+  /// Measures from the truncated start so spans that nest in time also nest after rounding.
+  [[nodiscard]] std::uint64_t
+  elapsed_micros(std::chrono::steady_clock::time_point started) const noexcept {
+    return micros(std::chrono::steady_clock::now()) - micros(started);
+  }
+
+  const std::size_t every;
+  const std::chrono::steady_clock::time_point origin{std::chrono::steady_clock::now()};
+  std::size_t candidates{};
+  std::size_t sampled{};
+  std::size_t lane_count{};
+  std::size_t dropped_count{};
+  std::vector<std::size_t> free_lanes;
+  std::unordered_map<TraceKey, std::size_t> bound;
+  std::vector<Event> trace;
+};
+
+/// One candidate's view of an optional `RequestTracer`; inert when the candidate is not sampled.
+class CandidateTrace {
+public:
+  /// Unbinds a request socket from its candidate when the request ends.
+  class Binding {
+  public:
+    Binding(RequestTracer* request_tracer, TraceKey request_key) noexcept
+        : tracer{request_tracer}, request{request_key} {}
+    Binding(const Binding&) = delete;
+    Binding(Binding&&) = delete;
+    Binding& operator=(const Binding&) = delete;
+    Binding& operator=(Binding&&) = delete;
+    ~Binding() {
+      if (tracer != nullptr) {
+        tracer->unbind(request);
+      }
+    }
+
+  private:
+    RequestTracer* tracer;
+    TraceKey request;
+  };
+
+  /// Starts tracing `description` if `request_tracer` is set and samples it.
+  CandidateTrace(RequestTracer* request_tracer, std::string_view description)
+      : tracer{request_tracer}, lane{tracer != nullptr ? tracer->begin_candidate() : std::nullopt},
+        candidate{lane ? std::string{description} : std::string{}},
+        started{std::chrono::steady_clock::now()} {}
+
+  /// Attributes the spans of `request` to this candidate until the returned binding is destroyed.
+  [[nodiscard]] Binding bind(TraceKey request) {
+    if (!lane) {
+      return Binding{nullptr, request};
+    }
+    tracer->bind(request, *lane);
+    return Binding{tracer, request};
+  }
+
+  /// Labels the candidate span with the cause of its failure.
+  void fail(const ErrorCause& cause) {
+    if (lane) {
+      error = cause.label();
+    }
+  }
+
+  /// Records the candidate span and the concurrency at the time it finished.
+  void finish(std::size_t active_coroutines, std::size_t recommended_coroutines) {
+    if (!lane) {
+      return;
+    }
+    tracer->end_candidate(*lane, candidate, started, error);
+    tracer->concurrency(active_coroutines, recommended_coroutines);
+    lane.reset();
+  }
+
+private:
+  RequestTracer* tracer;
+  std::optional<std::size_t> lane;
+  std::string candidate;
+  std::string error;
+  std::chrono::steady_clock::time_point started;
+};
+} // namespace abrade
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#if defined(__linux__)
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <unistd.h>
+#endif
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+namespace abrade {
+
+/// Process resource usage at one point in time.
+///
+/// Peak RSS and CPU times come from `getrusage`; current RSS and open file
+/// descriptors come from `/proc/self` and are only known on Linux. Values a
+/// platform cannot report stay empty.
+struct ResourceUsage {
+  /// Samples the calling process.
+  [[nodiscard]] static ResourceUsage sample() {
+    ResourceUsage usage;
+#if !defined(_WIN32)
+    rusage self{};
+    if (getrusage(RUSAGE_SELF, &self) == 0) {
+      usage.user_cpu_seconds = seconds(self.ru_utime);
+      usage.system_cpu_seconds = seconds(self.ru_stime);
+#if defined(__APPLE__)
+      usage.peak_rss_bytes = static_cast<std::uint64_t>(self.ru_maxrss);
+#else
+      usage.peak_rss_bytes = static_cast<std::uint64_t>(self.ru_maxrss) * 1024U;
+#endif
+    }
+#endif
+#if defined(__linux__)
+    std::ifstream statm{"/proc/self/statm"};
+    std::uint64_t size_pages{};
+    std::uint64_t resident_pages{};
+    if (statm >> size_pages >> resident_pages) {
+      usage.rss_bytes = resident_pages * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+    }
+    std::error_code ec;
+    std::size_t descriptors{};
+    for (std::filesystem::directory_iterator entry{"/proc/self/fd", ec}, end; !ec && entry != end;
+         entry.increment(ec)) {
+      descriptors++;
+    }
+    if (!ec && descriptors != 0U) {
+      // The iterator holds one descriptor of its own while counting.
+      usage.open_fds = descriptors - 1U;
+    }
+#endif
+    return usage;
+  }
+
+  std::optional<std::uint64_t> peak_rss_bytes;
+  std::optional<std::uint64_t> rss_bytes;
+  std::optional<double> user_cpu_seconds;
+  std::optional<double> system_cpu_seconds;
+  std::optional<std::size_t> open_fds;
+
+private:
+#if !defined(_WIN32)
+  static double seconds(const timeval& time) noexcept {
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) / 1e6;
+  }
+#endif
+};
+} // namespace abrade
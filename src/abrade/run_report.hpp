@@ -0,0 +1,194 @@
+#pragma once
+
+#include <abrade/controller.hpp>
+#include <abrade/json_writer.hpp>
+#include <abrade/options.hpp>
+#include <abrade/resource_usage.hpp>
+#include <abrade/run_stats.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace abrade {
+
+/// Everything a run report describes; the referenced objects must outlive it.
+struct RunReport {
+  const Options& options;
+  const RunStats& stats;
+  const Controller& controller;
+  /// Candidate count when the pattern's cardinality fits in `size_t`.
+  std::optional<std::size_t> cardinality;
+  /// Natural log of the candidate count when it does not.
+  std::optional<double> log_cardinality;
+  /// Process resources, normally sampled when the run ends.
+  ResourceUsage resources;
+};
+
+/// Formats a finished run as one JSON object.
+///
+/// The report carries the effective configuration, every `RunStats` counter
+/// under the names the metrics endpoint uses, status-code and error-cause
+/// breakdowns, per-phase latency percentiles in milliseconds, the controller's
+/// velocity and concurrency samples, and process resource usage. Values a run
+/// or platform cannot provide are `null` rather than omitted, so consumers can
+/// rely on every key being present. `report_version` changes when keys are
+/// renamed or removed.
+[[nodiscard]] inline std::string run_report_json(const RunReport& report) {
+  const auto& options = report.options;
+  const auto& stats = report.stats;
+  const auto optional_string = [](const std::string& value) {
+    return value.empty() ? std::nullopt : std::optional<std::string>{value};
+  };
+  std::ostringstream out;
+  detail::JsonWriter json{out};
+  json.begin_object();
+  json.member("report_version", 1);
+  json.member("elapsed_seconds", stats.elapsed_seconds());
+  json.member("cardinality", report.cardinality);
+  json.member("log_cardinality", report.log_cardinality);
+
+  json.begin_object("config");
+  json.member("host", options.get_host());
+  json.member("pattern", options.is_stdin() ? std::nullopt
+                                            : std::optional<std::string>{options.get_pattern()});
+  json.member("stdin", options.is_stdin());
+  json.member("contents", options.is_contents());
+  json.member("probe", options.is_probe());
+  json.member("tls", options.is_tls());
+  json.member("verify", options.is_verify());
+  json.member("proxy", optional_string(options.get_proxy()));
+  json.member("user_agent", options.get_user_agent());
+  json.member("follow_redirects", options.is_follow_redirects());
+  json.member("max_redirects", options.get_max_redirects());
+  json.member("error_bodies", options.is_close_error_bodies() ? "close" : "drain");
+  json.member("head_fallback", options.is_head_fallback());
+  json.member("soft_not_found", options.is_soft_not_found());
+  json.member("cluster_exemplars", options.get_cluster_exemplars());
+  json.member("required_literals", options.get_required_literals());
+  json.member("rejected_literals", options.get_rejected_literals());
+  json.member("required_regexes", options.get_required_regexes());
+  json.member("rejected_regexes", options.get_rejected_regexes());
+  json.member("content_types", options.get_content_types());
+  json.member("min_length", options.get_min_length());
+  json.member("max_length", options.get_max_length() == std::numeric_limits<std::uint64_t>::max()
+                                ? std::nullopt
+                                : std::optional<std::uint64_t>{options.get_max_length()});
+  json.member("required_header_regexes", options.get_required_header_regexes());
+  json.member("rejected_header_regexes", options.get_rejected_header_regexes());
+  json.member("workers", options.get_workers());
+  json.member("worker_queue", options.get_worker_queue());
+  json.member("optimize", options.is_optimizer());
+  json.member("controller", options.get_controller());
+  json.member("initial_coroutines", options.get_initial_coroutines());
+  json.member("minimum_coroutines", options.get_minimum_coroutines());
+  json.member("maximum_coroutines", options.get_maximum_coroutines());
+  json.member("sample_size", options.get_sample_size());
+  json.member("sample_interval", options.get_sample_interval());
+  json.member("sample_window_ms", options.get_sample_window());
+  json.member("sample_minimum", options.get_sample_minimum());
+  json.member("output", options.get_output_path());
+  json.member("error_output", options.get_error_path());
+  json.end_object();
+
+  json.begin_object("counters");
+  json.member("requests", stats.attempted());
+  json.member("candidates_finished", stats.candidates_finished());
+  json.member("responses_2xx", stats.success_2xx());
+  json.member("responses_other", stats.non_2xx());
+  json.member("hits", stats.hits());
+  json.member("filtered_bodies", stats.filtered());
+  json.member("header_filtered", stats.header_filtered());
+  json.member("soft_not_found", stats.soft_not_found());
+  json.member("near_duplicates", stats.near_duplicates());
+  json.member("probes", stats.probes());
+  json.member("promotions", stats.promotions());
+  json.member("head_fallbacks", stats.head_fallbacks());
+  json.member("head_rechecks", stats.head_rechecks());
+  json.member("errors", stats.errors());
+  json.member("bytes_received", stats.bytes_received());
+  json.member("bytes_written", stats.bytes_written());
+  json.member("bodies_skipped", stats.bodies_skipped());
+  json.member("bodies_aborted", stats.bodies_aborted());
+  json.member("bytes_avoided", stats.bytes_avoided());
+  json.member("worker_threads", stats.worker_threads());
+  json.member("worker_jobs", stats.worker_jobs());
+  json.member("worker_waits", stats.worker_waits());
+  json.member("worker_queue_peak", stats.worker_queue_peak());
+  json.member("worker_busy_seconds", std::chrono::duration<double>{stats.worker_busy()}.count());
+  json.end_object();
+
+  json.begin_object("status_codes");
+  for (const auto& [status_code, count] : stats.status_codes()) {
+    json.member(std::to_string(status_code), count);
+  }
+  json.end_object();
+
+  json.begin_array("errors_by_cause");
+  for (const auto& [cause, count] : stats.error_causes()) {
+    json.begin_object();
+    json.member("action", cause.action);
+    json.member("category", cause.category);
+    json.member("reason", cause.reason);
+    json.member("count", count);
+    json.end_object();
+  }
+  json.end_array();
+
+  json.begin_object("latency_ms");
+  for (std::size_t phase{}; phase < phase_names.size(); ++phase) {
+    const auto& histogram = stats.latency(static_cast<Phase>(phase));
+    const auto milliseconds = [](std::uint64_t micros) {
+      return static_cast<double>(micros) / 1000.0;
+    };
+    json.begin_object(phase_names[phase]);
+    json.member("count", histogram.count());
+    json.member("p50", milliseconds(histogram.percentile(0.5)));
+    json.member("p90", milliseconds(histogram.percentile(0.9)));
+    json.member("p99", milliseconds(histogram.percentile(0.99)));
+    json.member("p99_9", milliseconds(histogram.percentile(0.999)));
+    json.member("max", milliseconds(histogram.max()));
+    json.end_object();
+  }
+  json.end_object();
+
+  json.begin_object("controller");
+  json.member("recommended_coroutines", report.controller.recommended_coroutines());
+  json.begin_array("samples");
+  for (const auto& sample : report.controller.samples()) {
+    json.begin_object();
+    json.member("seconds", sample.seconds);
+    json.member("velocity", sample.velocity);
+    json.member("coroutines", sample.coroutines);
+    json.member("recommended", sample.recommended);
+    json.end_object();
+  }
+  json.end_array();
+  json.end_object();
+
+  json.begin_object("resources");
+  json.member("peak_rss_bytes", report.resources.peak_rss_bytes);
+  json.member("rss_bytes", report.resources.rss_bytes);
+  json.member("user_cpu_seconds", report.resources.user_cpu_seconds);
+  json.member("system_cpu_seconds", report.resources.system_cpu_seconds);
+  json.member("open_fds", report.resources.open_fds);
+  json.end_object();
+  json.end_object();
+  out << '\n';
+  return out.str();
+}
+
+/// Writes `run_report_json` to `path`, replacing the file; throws `std::ios_base::failure`.
+inline void write_run_report(const std::string& path, const RunReport& report) {
+  std::ofstream file;
+  file.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+  file.open(path, std::ofstream::out | std::ofstream::trunc);
+  file << run_report_json(report);
+}
+} // namespace abrade
@@ -1,46 +1,249 @@
 #pragma once
 
+#include <abrade/exception.hpp>
+#include <abrade/latency_histogram.hpp>
+#include <abrade/probes.hpp>
+#include <abrade/request_trace.hpp>
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstddef>
+#include <functional>
 #include <iomanip>
+#include <map>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace abrade {
 
+/// Network phases of one request whose latency `RunStats` records.
+///
+/// `connect` is the TCP connect to the target or to the SOCKS proxy, `proxy` is
+/// the SOCKS negotiation after it, `first_byte` is the wait for the response
+/// header after the request was written, and `body` sums the body reads.
+enum class Phase { resolve, connect, proxy, tls, write, first_byte, body };
+
+/// Summary labels for each `Phase`, in declaration order.
+inline constexpr std::array<std::string_view, 7> phase_names{"dns",   "connect", "socks", "tls",
+                                                             "write", "ttfb",    "body"};
+
+/// What an in-flight coroutine is waiting on, for the live census in `RunStats`.
+///
+/// The first states mirror `Phase`; `output` is a body chunk or response
+/// finish handed to the `WorkerPool`, including any wait for a free slot.
+enum class CoroutineState { resolve, connect, proxy, tls, write, first_byte, body, output };
+
+/// Census labels for each `CoroutineState`, in declaration order.
+inline constexpr std::array<std::string_view, 8> state_names{
+    "dns", "connect", "socks", "tls", "write", "ttfb", "body", "output"};
+
+/// Returns the census state of a coroutine waiting in `phase`.
+[[nodiscard]] constexpr CoroutineState state_of(Phase phase) noexcept {
+  return static_cast<CoroutineState>(phase);
+}
+
 /// Aggregates one scraper invocation's observable runtime outcomes.
 ///
-/// The scraper records request attempts and transport errors. Query objects record
-/// HTTP status classes. Actions record filtered bodies and bytes persisted.
+/// The scraper records request attempts, candidates started and finished, and
+/// transport errors grouped by `ErrorCause`. Query objects record HTTP status
+/// codes, hits, body bytes received, header-filtered responses, HEAD fallbacks,
+/// probes and promotions, and skipped or aborted bodies. Actions record filtered bodies, soft
+/// 404s, near duplicates, and bytes persisted. `WorkerPool` records body-processing
+/// jobs, queue depth, and waits. Connection policies, `RequestWriter`, and the
+/// queries record per-phase latency histograms around their network awaits,
+/// and keep a census of how many coroutines wait in each `CoroutineState`.
 struct RunStats {
   /// Records one HTTP request attempt, including redirect follow-up requests.
   void record_attempt() noexcept { attempted_count++; }
 
+  /// Records a candidate entering the scraper; it is in flight until `record_candidate_finished`.
+  void record_candidate_started() noexcept { candidates_started_count++; }
+
+  /// Records a candidate whose requests, including redirects, completed or failed.
+  void record_candidate_finished() noexcept { candidates_finished_count++; }
+
+  /// Records a candidate reported as found.
+  void record_hit() noexcept { hit_count++; }
+
+  /// Records response-body bytes read from the network, whether or not they are written.
+  void record_bytes_received(std::size_t bytes) noexcept { bytes_received_count += bytes; }
+
   /// Records one completed HTTP response status.
-  void record_response(unsigned int status_code) noexcept {
+  void record_response(unsigned int status_code) {
     if (status_code >= 200U && status_code < 300U) {
       success_count++;
     } else {
       non_success_count++;
     }
+    status_counts[status_code]++;
   }
 
   /// Records a successful response body omitted by configured content filters.
   void record_filtered() noexcept { filtered_count++; }
 
-  /// Records a transport or runtime error for a candidate.
-  void record_error() noexcept { error_count++; }
+  /// Records one HEAD probe answered in probe mode.
+  void record_probe() noexcept { probe_count++; }
+
+  /// Records a probe hit promoted to a GET on the same connection.
+  void record_promotion() noexcept { promotion_count++; }
+
+  /// Records a ranged GET sent in place of HEAD; a recheck is an extra request on the connection.
+  void record_head_fallback(bool recheck) noexcept {
+    head_fallback_count++;
+    if (recheck) {
+      head_recheck_count++;
+    }
+  }
+
+  /// Records a successful response rejected by configured header filters.
+  void record_header_filtered() noexcept { header_filtered_count++; }
+
+  /// Records a successful response dropped because it matched a learned soft 404.
+  void record_soft_not_found() noexcept { soft_not_found_count++; }
+
+  /// Records an accepted body left unwritten because its near-duplicate cluster was full.
+  void record_near_duplicate() noexcept { near_duplicate_count++; }
+
+  /// Records a transport or runtime error for a candidate under its cause.
+  void record_error(const ErrorCause& cause) {
+    error_count++;
+    if (cause.category == "timeout") {
+      timeout_count++;
+    }
+    error_counts[cause]++;
+  }
 
   /// Records response-body bytes actually written to disk.
   void record_bytes_written(std::size_t bytes) noexcept { bytes_written_count += bytes; }
 
+  /// Records a response body abandoned after its header, with its declared length when known.
+  void record_body_skipped(std::size_t avoided_bytes) noexcept {
+    skipped_body_count++;
+    bytes_avoided_count += avoided_bytes;
+  }
+
+  /// Records a response body abandoned mid-transfer once content filters rejected it.
+  void record_body_aborted(std::size_t avoided_bytes) noexcept {
+    aborted_body_count++;
+    bytes_avoided_count += avoided_bytes;
+  }
+
+  /// Records the number of body worker threads; worker metrics are reported only when nonzero.
+  void record_worker_threads(std::size_t threads) noexcept { worker_thread_count = threads; }
+
+  /// Records one finished worker job and the time a worker spent on it.
+  void record_worker_job(std::chrono::steady_clock::duration busy) noexcept {
+    worker_job_count++;
+    worker_busy_time += busy;
+  }
+
+  /// Records the number of worker jobs queued or running after a submission.
+  void record_worker_queue_depth(std::size_t depth) noexcept {
+    worker_queue_max = std::max(worker_queue_max, depth);
+  }
+
+  /// Records a coroutine that had to wait for a free worker slot.
+  void record_worker_wait() noexcept { worker_wait_count++; }
+
+  /// Records the latency of one network phase that started at `started` and just finished.
+  void record_phase(Phase phase, std::chrono::steady_clock::time_point started) noexcept {
+    record_phase(phase, std::chrono::steady_clock::now() - started);
+  }
+
+  /// Records one network phase latency.
+  void record_phase(Phase phase, std::chrono::steady_clock::duration elapsed) noexcept {
+    latencies[static_cast<std::size_t>(phase)].record(elapsed);
+  }
+
+  /// Records a phase of the request on `request`'s socket and traces it when a tracer is attached.
+  void record_phase(Phase phase, std::chrono::steady_clock::time_point started, TraceKey request) {
+    record_phase(phase, std::chrono::steady_clock::now() - started, request);
+    trace_span(request, phase_names[static_cast<std::size_t>(phase)], started);
+  }
+
+  /// Records a phase latency of the request on `request`'s socket and fires the `phase` probe.
+  void record_phase(Phase phase, std::chrono::steady_clock::duration elapsed,
+                    [[maybe_unused]] TraceKey request) noexcept {
+    record_phase(phase, elapsed);
+    ABRADE_PROBE3(phase, request, phase_names[static_cast<std::size_t>(phase)].data(),
+                  std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+  }
+
+  /// Traces a span of the request on `request`'s socket without recording a latency sample.
+  void trace_span(TraceKey request, std::string_view name,
+                  std::chrono::steady_clock::time_point started) {
+    if (request_tracer != nullptr) {
+      request_tracer->span(request, name, started);
+    }
+  }
+
+  /// Attaches the tracer that sampled candidates report their spans to.
+  void attach_tracer(RequestTracer& tracer) noexcept { request_tracer = &tracer; }
+
+  /// Returns the attached tracer, or null when the run is not traced.
+  [[nodiscard]] RequestTracer* tracer() const noexcept { return request_tracer; }
+
+  /// Counts one more coroutine waiting in `state`; pair with `leave`, usually through `StateScope`.
+  void enter(CoroutineState state) noexcept { census[static_cast<std::size_t>(state)]++; }
+
+  /// Counts one coroutine fewer waiting in `state`.
+  void leave(CoroutineState state) noexcept { census[static_cast<std::size_t>(state)]--; }
+
+  /// Returns how many coroutines are waiting in `state` right now.
+  [[nodiscard]] std::size_t waiting(CoroutineState state) const noexcept {
+    return census[static_cast<std::size_t>(state)];
+  }
+
+  /// Returns the latency histogram of one network phase.
+  [[nodiscard]] const LatencyHistogram& latency(Phase phase) const noexcept {
+    return latencies[static_cast<std::size_t>(phase)];
+  }
+
   [[nodiscard]] std::size_t attempted() const noexcept { return attempted_count; }
   [[nodiscard]] std::size_t success_2xx() const noexcept { return success_count; }
+  [[nodiscard]] std::size_t candidates_finished() const noexcept {
+    return candidates_finished_count;
+  }
+  [[nodiscard]] std::size_t in_flight() const noexcept {
+    return candidates_started_count - candidates_finished_count;
+  }
+  [[nodiscard]] std::size_t hits() const noexcept { return hit_count; }
+  [[nodiscard]] std::size_t bytes_received() const noexcept { return bytes_received_count; }
   [[nodiscard]] std::size_t non_2xx() const noexcept { return non_success_count; }
   [[nodiscard]] std::size_t filtered() const noexcept { return filtered_count; }
+  [[nodiscard]] std::size_t header_filtered() const noexcept { return header_filtered_count; }
+  [[nodiscard]] std::size_t soft_not_found() const noexcept { return soft_not_found_count; }
+  [[nodiscard]] std::size_t near_duplicates() const noexcept { return near_duplicate_count; }
+  [[nodiscard]] std::size_t probes() const noexcept { return probe_count; }
+  [[nodiscard]] std::size_t promotions() const noexcept { return promotion_count; }
+  [[nodiscard]] std::size_t head_fallbacks() const noexcept { return head_fallback_count; }
+  [[nodiscard]] std::size_t head_rechecks() const noexcept { return head_recheck_count; }
   [[nodiscard]] std::size_t errors() const noexcept { return error_count; }
+  /// Returns the errors whose cause is the network timeout firing.
+  [[nodiscard]] std::size_t timeouts() const noexcept { return timeout_count; }
   [[nodiscard]] std::size_t bytes_written() const noexcept { return bytes_written_count; }
+  [[nodiscard]] std::size_t bodies_skipped() const noexcept { return skipped_body_count; }
+  [[nodiscard]] std::size_t bodies_aborted() const noexcept { return aborted_body_count; }
+  [[nodiscard]] std::size_t bytes_avoided() const noexcept { return bytes_avoided_count; }
+  [[nodiscard]] std::size_t worker_threads() const noexcept { return worker_thread_count; }
+  [[nodiscard]] std::size_t worker_jobs() const noexcept { return worker_job_count; }
+  [[nodiscard]] std::chrono::steady_clock::duration worker_busy() const noexcept {
+    return worker_busy_time;
+  }
+  [[nodiscard]] std::size_t worker_queue_peak() const noexcept { return worker_queue_max; }
+  [[nodiscard]] std::size_t worker_waits() const noexcept { return worker_wait_count; }
   [[nodiscard]] bool has_errors() const noexcept { return error_count != 0U; }
+  /// Returns the number of responses seen for each HTTP status code.
+  [[nodiscard]] const std::map<unsigned int, std::size_t>& status_codes() const noexcept {
+    return status_counts;
+  }
+  /// Returns the number of errors recorded for each cause.
+  [[nodiscard]] const std::map<ErrorCause, std::size_t>& error_causes() const noexcept {
+    return error_counts;
+  }
 
   /// Returns elapsed wall-clock seconds since this collector was constructed.
   [[nodiscard]] double elapsed_seconds() const {
@@ -61,19 +264,161 @@ struct RunStats {
     out << std::fixed << std::setprecision(2);
     out << "[ ] Summary: attempted=" << attempted_count << " 2xx=" << success_count
         << " non-2xx=" << non_success_count << " filtered=" << filtered_count
+        << " header-filtered=" << header_filtered_count << " soft-404=" << soft_not_found_count
         << " errors=" << error_count << " bytes-written=" << bytes_written_count
-        << " elapsed=" << elapsed << "s"
+        << " bodies-skipped=" << skipped_body_count << " bodies-aborted=" << aborted_body_count
+        << " bytes-avoided=" << bytes_avoided_count << " elapsed=" << elapsed << "s"
         << " requests/sec=" << requests_per_second << " MiB/sec=" << mib_per_second;
+    if (head_fallback_count != 0U) {
+      const auto requests = static_cast<double>(attempted_count + head_recheck_count);
+      out << " head-fallbacks=" << head_fallback_count << " head-fallback-rate="
+          << 100.0 * static_cast<double>(head_fallback_count) / requests << "%";
+    }
+    if (near_duplicate_count != 0U) {
+      out << " near-duplicates=" << near_duplicate_count;
+    }
+    if (probe_count != 0U) {
+      out << " probes=" << probe_count << " promoted=" << promotion_count;
+    }
+    if (worker_thread_count != 0U) {
+      const auto capacity = elapsed * static_cast<double>(worker_thread_count);
+      const auto busy = std::chrono::duration<double>{worker_busy_time}.count();
+      out << " workers=" << worker_thread_count << " worker-jobs=" << worker_job_count
+          << " worker-utilization=" << (capacity > 0.0 ? 100.0 * busy / capacity : 0.0) << "%"
+          << " worker-queue-max=" << worker_queue_max << " worker-waits=" << worker_wait_count;
+    }
+    if (!status_counts.empty()) {
+      out << "\n[ ] Status codes:";
+      for (const auto& [status_code, count] : status_counts) {
+        out << ' ' << status_code << '=' << count;
+      }
+    }
+    if (!error_counts.empty()) {
+      std::vector<std::pair<const ErrorCause*, std::size_t>> causes;
+      for (const auto& [cause, count] : error_counts) {
+        causes.emplace_back(&cause, count);
+      }
+      std::ranges::stable_sort(causes, std::ranges::greater{},
+                               &std::pair<const ErrorCause*, std::size_t>::second);
+      out << "\n[ ] Error causes:";
+      auto separator = " ";
+      for (const auto& [cause, count] : causes) {
+        out << separator << cause->label() << '=' << count;
+        separator = "; ";
+      }
+    }
+    for (std::size_t phase{}; phase < latencies.size(); ++phase) {
+      const auto& histogram = latencies[phase];
+      if (histogram.count() == 0U) {
+        continue;
+      }
+      const auto millis = [&histogram](double quantile) {
+        return static_cast<double>(histogram.percentile(quantile)) / 1000.0;
+      };
+      out << "\n[ ] Latency " << phase_names[phase] << ": n=" << histogram.count()
+          << " p50=" << millis(0.5) << "ms p90=" << millis(0.9) << "ms p99=" << millis(0.99)
+          << "ms p99.9=" << millis(0.999)
+          << "ms max=" << static_cast<double>(histogram.max()) / 1000.0 << "ms";
+    }
     return out.str();
   }
 
 private:
   std::chrono::steady_clock::time_point started_at{std::chrono::steady_clock::now()};
+  std::array<LatencyHistogram, phase_names.size()> latencies{};
+  std::array<std::size_t, state_names.size()> census{};
+  std::map<unsigned int, std::size_t> status_counts;
+  std::map<ErrorCause, std::size_t> error_counts;
+  RequestTracer* request_tracer{};
   std::size_t attempted_count{};
+  std::size_t candidates_started_count{};
+  std::size_t candidates_finished_count{};
+  std::size_t hit_count{};
+  std::size_t bytes_received_count{};
   std::size_t success_count{};
   std::size_t non_success_count{};
   std::size_t filtered_count{};
+  std::size_t header_filtered_count{};
+  std::size_t soft_not_found_count{};
+  std::size_t near_duplicate_count{};
+  std::size_t probe_count{};
+  std::size_t head_fallback_count{};
+  std::size_t head_recheck_count{};
+  std::size_t promotion_count{};
   std::size_t error_count{};
+  std::size_t timeout_count{};
   std::size_t bytes_written_count{};
+  std::size_t skipped_body_count{};
+  std::size_t aborted_body_count{};
+  std::size_t bytes_avoided_count{};
+  std::size_t worker_thread_count{};
+  std::size_t worker_job_count{};
+  std::size_t worker_queue_max{};
+  std::size_t worker_wait_count{};
+  std::chrono::steady_clock::duration worker_busy_time{};
+};
+
+/// Counts a coroutine in one `RunStats` census state for the scope's lifetime.
+class StateScope {
+public:
+  StateScope(RunStats& run_stats, CoroutineState waiting_state) noexcept
+      : stats{run_stats}, state{waiting_state} {
+    stats.enter(state);
+  }
+  StateScope(const StateScope&) = delete;
+  StateScope(StateScope&&) = delete;
+  StateScope& operator=(const StateScope&) = delete;
+  StateScope& operator=(StateScope&&) = delete;
+  ~StateScope() { stats.leave(state); }
+
+private:
+  RunStats& stats;
+  CoroutineState state;
+};
+
+/// Times consecutive network phases of one request and counts the coroutine in each.
+///
+/// `next` records the current phase through `RunStats::record_phase` and starts
+/// another; `finish` records the last one. A timer destroyed unfinished, as when
+/// an await throws, leaves the census without recording a latency sample.
+class PhaseTimer {
+public:
+  PhaseTimer(RunStats& run_stats, Phase first_phase, TraceKey request_key) noexcept
+      : stats{run_stats}, phase{first_phase}, request{request_key},
+        started{std::chrono::steady_clock::now()} {
+    stats.enter(state_of(phase));
+  }
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer(PhaseTimer&&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(PhaseTimer&&) = delete;
+  ~PhaseTimer() {
+    if (!is_finished) {
+      stats.leave(state_of(phase));
+    }
+  }
+
+  /// Records the current phase and starts timing `next_phase`.
+  void next(Phase next_phase) {
+    finish();
+    phase = next_phase;
+    started = std::chrono::steady_clock::now();
+    stats.enter(state_of(phase));
+    is_finished = false;
+  }
+
+  /// Records the current phase.
+  void finish() {
+    stats.leave(state_of(phase));
+    is_finished = true;
+    stats.record_phase(phase, started, request);
+  }
+
+private:
+  RunStats& stats;
+  Phase phase;
+  TraceKey request;
+  std::chrono::steady_clock::time_point started;
+  bool is_finished{};
 };
 } // namespace abrade
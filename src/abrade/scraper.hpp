@@ -1,16 +1,22 @@
 #pragma once
 #include <abrade/candidate.hpp>
 #include <abrade/controller.hpp>
+#include <abrade/exception.hpp>
+#include <abrade/probes.hpp>
+#include <abrade/request_trace.hpp>
 #include <abrade/run_stats.hpp>
 #include <abrade/scraper_runtime.hpp>
 #include <boost/asio.hpp>
 #include <boost/asio/spawn.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http/parser.hpp>
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <ostream>
 #include <string>
+#include <utility>
 
 namespace abrade {
 
@@ -30,7 +36,11 @@ struct Scraper {
         writer{std::forward<RequestWriter>(writer_in)}, stats{run_stats}, active_coroutines{} {}
 
   /// Starts the coroutine pool and runs the associated io_context to completion.
-  void run(Generator& generator) {
+  ///
+  /// `on_finished` runs on the io_context once the last coroutine exits, so
+  /// periodic work such as a progress timer can be stopped and `run` can return.
+  void run(Generator& generator, std::function<void()> on_finished = {}) {
+    finished = std::move(on_finished);
     spawn_coroutine(generator);
     ios.run();
   }
@@ -53,42 +63,83 @@ private:
     spawn(
         ios,
         [this, &generator](const boost::asio::yield_context& yield) {
-          LifetimeCounter ctr{active_coroutines};
-          while (const auto uri = generator.next()) {
-            if (active_coroutines < controller.recommended_coroutines()) {
-              spawn_coroutine(generator);
-            }
-            // Candidate enrichment belongs in make_candidate so Scraper stays an orchestrator.
-            auto candidate = make_candidate(*uri);
-            try {
-              coroutine(yield, candidate);
-            } catch (const std::exception& e) {
-              stats.record_error();
-              error_log.record(*uri, e);
-            }
-            controller.register_completion(active_coroutines);
-            if (active_coroutines > controller.recommended_coroutines()) {
-              return;
-            }
+          {
+            LifetimeCounter ctr{active_coroutines};
+            drain(generator, yield);
+          }
+          if (active_coroutines == 0U && finished) {
+            finished();
           }
         },
         boost::asio::detached);
   }
 
-  void coroutine(const boost::asio::yield_context& yield, const Candidate& candidate) {
+  void drain(Generator& generator, const boost::asio::yield_context& yield) {
+    while (const auto uri = generator.next()) {
+      if (active_coroutines < controller.recommended_coroutines()) {
+        spawn_coroutine(generator);
+      }
+      // Candidate enrichment belongs in make_candidate so Scraper stays an orchestrator.
+      auto candidate = make_candidate(*uri);
+      stats.record_candidate_started();
+      ABRADE_PROBE1(candidate_start, candidate.uri.c_str());
+      CandidateTrace trace{stats.tracer(), candidate.description()};
+      [[maybe_unused]] auto failed = false;
+      const auto started = std::chrono::steady_clock::now();
+      try {
+        coroutine(yield, candidate, trace);
+        controller.register_latency(std::chrono::steady_clock::now() - started);
+      } catch (const std::exception& e) {
+        failed = true;
+        const auto cause = ErrorCause::of(e);
+        trace.fail(cause);
+        stats.record_error(cause);
+        error_log.record(*uri, e);
+      }
+      stats.record_candidate_finished();
+      ABRADE_PROBE2(candidate_finish, candidate.uri.c_str(), failed ? 1 : 0);
+      controller.register_completion(active_coroutines);
+      trace.finish(active_coroutines, controller.recommended_coroutines());
+      if (active_coroutines > controller.recommended_coroutines()) {
+        return;
+      }
+    }
+  }
+
+  void coroutine(const boost::asio::yield_context& yield, const Candidate& candidate,
+                 CandidateTrace& trace) {
     auto current = candidate;
     std::size_t redirects_followed{};
+    auto retried = false;
     while (true) {
       boost::asio::ip::tcp::socket sock{ios};
+      // Policies report phases under the socket's address; the binding routes them to the trace.
+      const auto binding = trace.bind(&sock);
       stats.record_attempt();
+      ABRADE_PROBE2(connect_start, current.uri.c_str(), &sock);
       auto instance = connection.connect(sock, yield);
-      writer.make_request(instance->get(), query, current, yield);
-      const auto redirect = query.execute(instance->get(), current.description(), yield);
-      if (!redirect || redirects_followed == query.max_redirects()) {
+      ABRADE_PROBE2(connect_done, current.uri.c_str(), &sock);
+      const auto method = writer.make_request(instance->get(), query, current, yield);
+      const auto follow_up =
+          query.execute(instance->get(), current.description(), method, yield);
+      if (!follow_up) {
         return;
       }
-      current.uri = *redirect;
-      redirects_followed++;
+      // A retry repeats the hop on a new connection, so only redirects spend the budget.
+      if (follow_up->retry) {
+        if (retried) {
+          throw AbradeException{"retry after connection close"};
+        }
+        retried = true;
+      } else {
+        if (redirects_followed == query.max_redirects()) {
+          return;
+        }
+        redirects_followed++;
+        retried = false;
+      }
+      current.uri = follow_up->uri;
+      current.method = follow_up->method;
     }
   }
 
@@ -99,6 +150,7 @@ private:
   Connection connection;
   RequestWriter writer;
   RunStats& stats;
+  std::function<void()> finished;
   size_t active_coroutines;
 };
 } // namespace abrade
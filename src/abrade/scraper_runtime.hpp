@@ -13,7 +13,7 @@ namespace abrade {
 ///
 /// This adapter is the narrow point between generators and request candidates.
 /// It should absorb future candidate enrichment before `Scraper` does.
-inline Candidate make_candidate(std::string uri) { return Candidate{std::move(uri), {}, {}}; }
+inline Candidate make_candidate(std::string uri) { return Candidate{std::move(uri), {}, {}, {}}; }
 
 /// Append-only scraper error log used to retain candidate context for failures.
 ///
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace abrade {
+
+/// Streaming 64-bit SimHash of a response body.
+///
+/// Features are case-folded ASCII alphanumeric words, hashed incrementally with
+/// FNV-1a so a word may straddle chunk boundaries. Each feature votes on every
+/// signature bit; bodies that differ only in a few words, such as an echoed ID
+/// or timestamp, end up a few bits apart. Words `ignore`d beforehand, such as
+/// those of the requested path that error pages echo back, cast no vote; on a
+/// short page one echoed word would otherwise flip many bits. Only the first
+/// `max_bytes` bytes are hashed, which bounds the cost on large bodies.
+class SimHash {
+public:
+  /// Number of leading body bytes that contribute to the signature.
+  static constexpr std::size_t max_bytes{1024U * 1024U};
+
+  /// Excludes every word of `text` from the signature; call before the first `feed`.
+  void ignore(std::string_view text) {
+    std::uint64_t ignored_word{fnv_offset};
+    auto in_ignored_word = false;
+    for (const auto element : text) {
+      if (const auto byte = fold(element); is_word(byte)) {
+        ignored_word = (ignored_word ^ byte) * fnv_prime;
+        in_ignored_word = true;
+      } else if (in_ignored_word) {
+        ignored.push_back(ignored_word);
+        ignored_word = fnv_offset;
+        in_ignored_word = false;
+      }
+    }
+    if (in_ignored_word) {
+      ignored.push_back(ignored_word);
+    }
+  }
+
+  /// Hashes the next body chunk.
+  void feed(std::string_view chunk) noexcept {
+    const auto usable = chunk.substr(0, max_bytes - std::min(fed, max_bytes));
+    fed += usable.size();
+    for (const auto element : usable) {
+      if (const auto byte = fold(element); is_word(byte)) {
+        word = (word ^ byte) * fnv_prime;
+        in_word = true;
+      } else if (in_word) {
+        end_word();
+      }
+    }
+  }
+
+  /// Flushes a trailing word and returns the signature; an empty body hashes to zero.
+  [[nodiscard]] std::uint64_t finish() noexcept {
+    if (in_word) {
+      end_word();
+    }
+    std::uint64_t signature{};
+    for (std::size_t bit{}; bit < weights.size(); ++bit) {
+      if (weights[bit] > 0) {
+        signature |= std::uint64_t{1} << bit;
+      }
+    }
+    return signature;
+  }
+
+  /// Returns the number of differing bits between two signatures.
+  [[nodiscard]] static int distance(std::uint64_t left, std::uint64_t right) noexcept {
+    return std::popcount(left ^ right);
+  }
+
+  /// Returns the signature of a complete body.
+  [[nodiscard]] static std::uint64_t of(std::string_view body) noexcept {
+    SimHash hash;
+    hash.feed(body);
+    return hash.finish();
+  }
+
+private:
+  static constexpr std::uint64_t fnv_offset{14695981039346656037ULL};
+  static constexpr std::uint64_t fnv_prime{1099511628211ULL};
+
+  static unsigned char fold(char element) noexcept {
+    const auto byte = static_cast<unsigned char>(element);
+    return byte >= 'A' && byte <= 'Z' ? static_cast<unsigned char>(byte - 'A' + 'a') : byte;
+  }
+
+  static bool is_word(unsigned char byte) noexcept {
+    return (byte >= 'a' && byte <= 'z') || (byte >= '0' && byte <= '9');
+  }
+
+  void end_word() noexcept {
+    if (std::ranges::find(ignored, word) == ignored.end()) {
+      add_feature();
+    }
+    word = fnv_offset;
+    in_word = false;
+  }
+
+  void add_feature() noexcept {
+    // FNV-1a diffuses poorly into the high bits; a splitmix64 finalizer spreads every word.
+    auto mixed = word;
+    mixed = (mixed ^ (mixed >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    mixed = (mixed ^ (mixed >> 27U)) * 0x94D049BB133111EBULL;
+    mixed ^= mixed >> 31U;
+    for (std::size_t bit{}; bit < weights.size(); ++bit) {
+      weights[bit] += ((mixed >> bit) & 1U) != 0U ? 1 : -1;
+    }
+  }
+
+  std::array<std::int32_t, 64> weights{};
+  std::vector<std::uint64_t> ignored;
+  std::uint64_t word{fnv_offset};
+  bool in_word{};
+  std::size_t fed{};
+};
+} // namespace abrade
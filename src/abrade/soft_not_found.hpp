@@ -0,0 +1,125 @@
+#pragma once
+
+#include <abrade/header_filter.hpp>
+#include <abrade/simhash.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace abrade {
+
+/// What a response looks like, reduced to the parts soft-404 pages keep constant.
+struct ResponseFingerprint {
+  /// Fingerprints a response header; GET adds the body hash and size later.
+  template <typename Fields>
+  [[nodiscard]] static ResponseFingerprint of(unsigned int status_code, const Fields& header) {
+    ResponseFingerprint fingerprint{status_code, HeaderFilters::declared_length(header), {}, {}};
+    for (const auto& field : header) {
+      fingerprint.header_names.push_back(detail::lowercase(
+          std::string_view{field.name_string().data(), field.name_string().size()}));
+    }
+    std::ranges::sort(fingerprint.header_names);
+    const auto duplicates = std::ranges::unique(fingerprint.header_names);
+    fingerprint.header_names.erase(duplicates.begin(), duplicates.end());
+    return fingerprint;
+  }
+
+  unsigned int status{};
+  std::optional<std::uint64_t> length;
+  std::vector<std::string> header_names;
+  std::optional<std::uint64_t> body_hash;
+};
+
+/// Recognises "not found" pages that a server returns with a 2xx status.
+///
+/// A calibration pass requests a few random candidates that cannot exist and
+/// `learn`s the fingerprint of every 2xx answer. Afterwards a 2xx response is a
+/// soft 404 when it `matches` a learned fingerprint: same status and header
+/// names, a length within `length_slack` bytes or 10%, and, when both sides
+/// carry a body, SimHash signatures at most `max_body_distance` bits apart.
+/// Servers that answer the calibration candidates with a real 404 teach
+/// nothing, so no responses are suppressed.
+///
+/// `learn` runs only during calibration and `matches` only afterwards, so the
+/// GET worker threads may match concurrently without locking.
+class SoftNotFound {
+public:
+  /// Number of random candidates requested during calibration.
+  static constexpr std::size_t calibration_probes{3};
+  /// Largest length difference, in bytes, that still matches a small page.
+  static constexpr std::uint64_t length_slack{64};
+  /// Largest SimHash distance, in bits, between a body and a learned soft 404.
+  static constexpr int max_body_distance{6};
+
+  /// Returns true until `finish_calibration` is called.
+  [[nodiscard]] bool calibrating() const noexcept { return is_calibrating; }
+
+  /// Ends calibration; later responses are matched against what was learned.
+  void finish_calibration() noexcept { is_calibrating = false; }
+
+  /// Returns the number of learned soft-404 fingerprints.
+  [[nodiscard]] std::size_t size() const noexcept { return fingerprints.size(); }
+
+  /// Learns the fingerprint of a response to a calibration candidate; non-2xx answers are ignored.
+  void learn(ResponseFingerprint fingerprint) {
+    if (fingerprint.status >= 200U && fingerprint.status < 300U) {
+      fingerprints.push_back(std::move(fingerprint));
+    }
+  }
+
+  /// Returns true when a response looks like a learned soft 404.
+  [[nodiscard]] bool matches(const ResponseFingerprint& response) const {
+    return std::ranges::any_of(fingerprints, [&response](const auto& learned) {
+      return learned.status == response.status && learned.header_names == response.header_names &&
+             lengths_close(learned.length, response.length) &&
+             bodies_close(learned.body_hash, response.body_hash);
+    });
+  }
+
+  /// Derives `count` calibration targets from `sample` by appending a random word.
+  ///
+  /// The word goes at the end of the query string when there is one and of the
+  /// path otherwise, so the targets exercise the same route as real candidates.
+  [[nodiscard]] static std::vector<std::string>
+  calibration_targets(std::string_view sample, std::size_t count, std::uint64_t seed) {
+    static constexpr std::string_view alphabet{"abcdefghijklmnopqrstuvwxyz0123456789"};
+    std::mt19937_64 random{seed};
+    std::uniform_int_distribution<std::size_t> pick{0, alphabet.size() - 1U};
+    const auto fragment = sample.find('#');
+    const auto base = sample.substr(0, fragment);
+    std::vector<std::string> targets;
+    for (std::size_t index{}; index < count; ++index) {
+      std::string target{base.empty() ? std::string_view{"/"} : base};
+      for (std::size_t length{}; length < 16U; ++length) {
+        target.push_back(alphabet[pick(random)]);
+      }
+      targets.push_back(std::move(target));
+    }
+    return targets;
+  }
+
+private:
+  static bool lengths_close(std::optional<std::uint64_t> learned,
+                            std::optional<std::uint64_t> response) noexcept {
+    if (!learned || !response) {
+      return true;
+    }
+    const auto difference = *learned > *response ? *learned - *response : *response - *learned;
+    return difference <= std::max(length_slack, std::max(*learned, *response) / 10U);
+  }
+
+  static bool bodies_close(std::optional<std::uint64_t> learned,
+                           std::optional<std::uint64_t> response) noexcept {
+    return !learned || !response || SimHash::distance(*learned, *response) <= max_body_distance;
+  }
+
+  std::vector<ResponseFingerprint> fingerprints;
+  bool is_calibrating{true};
+};
+} // namespace abrade
@@ -0,0 +1,323 @@
+#pragma once
+
+// POSIX shared memory only; the CLI rejects --shm-stats on Windows.
+#if !defined(_WIN32)
+
+#include <abrade/controller.hpp>
+#include <abrade/exception.hpp>
+#include <abrade/periodic_timer.hpp>
+#include <abrade/run_stats.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <boost/asio/io_context.hpp>
+#include <boost/system/error_code.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <filesystem>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace abrade {
+
+/// Shared-memory layout of one scan's published stats.
+///
+/// The identity fields are written before `magic`, which is stored with
+/// release ordering, so a reader that sees `magic` sees them too. Every other
+/// field is an independent relaxed atomic: a snapshot is not a consistent cut
+/// across fields, which is fine for a live display. Fields are only appended;
+/// `version` changes when one is renamed or removed.
+struct StatsSegmentLayout {
+  /// "ABRADESG" in little-endian byte order.
+  static constexpr std::uint64_t magic_value{0x4753454441524241U};
+  static constexpr std::uint64_t current_version{1};
+
+  std::atomic<std::uint64_t> magic;
+  std::uint64_t version;
+  std::int64_t pid;
+  std::array<char, 256> host;
+  std::array<char, 256> pattern;
+  /// Candidate count, or 0 when it is unknown or overflows.
+  std::uint64_t cardinality;
+  std::atomic<std::uint64_t> finished;
+  std::atomic<std::uint64_t> elapsed_millis;
+  std::atomic<std::uint64_t> requests;
+  std::atomic<std::uint64_t> candidates_finished;
+  std::atomic<std::uint64_t> in_flight;
+  std::atomic<std::uint64_t> hits;
+  std::atomic<std::uint64_t> responses_2xx;
+  std::atomic<std::uint64_t> responses_other;
+  std::atomic<std::uint64_t> errors;
+  std::atomic<std::uint64_t> bytes_received;
+  std::atomic<std::uint64_t> bytes_written;
+  std::array<std::atomic<std::uint64_t>, state_names.size()> waiting;
+  std::atomic<std::uint64_t> recommended_coroutines;
+  /// Latest controller velocity in completions per thousand seconds.
+  std::atomic<std::uint64_t> velocity_millis;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "the stats segment needs lock-free 64-bit atomics to be shared across processes");
+
+/// One reading of a `StatsSegmentLayout`, as plain values.
+struct StatsSnapshot {
+  std::int64_t pid{};
+  std::string host;
+  std::string pattern;
+  std::optional<std::uint64_t> cardinality;
+  bool finished{};
+  double elapsed_seconds{};
+  std::uint64_t requests{};
+  std::uint64_t candidates_finished{};
+  std::uint64_t in_flight{};
+  std::uint64_t hits{};
+  std::uint64_t responses_2xx{};
+  std::uint64_t responses_other{};
+  std::uint64_t errors{};
+  std::uint64_t bytes_received{};
+  std::uint64_t bytes_written{};
+  std::array<std::uint64_t, state_names.size()> waiting{};
+  std::uint64_t recommended_coroutines{};
+  double velocity{};
+};
+
+namespace detail {
+/// Copies `text` into a NUL-terminated fixed field, truncating it if needed.
+inline void copy_field(std::array<char, 256>& field, std::string_view text) noexcept {
+  const auto size = std::min(text.size(), field.size() - 1U);
+  std::copy_n(text.data(), size, field.data());
+  field[size] = '\0';
+}
+
+/// Owns one mapping of a stats segment.
+class SegmentMapping {
+public:
+  SegmentMapping(void* mapped_address, std::size_t mapped_size) noexcept
+      : address{mapped_address}, size{mapped_size} {}
+  SegmentMapping(const SegmentMapping&) = delete;
+  SegmentMapping(SegmentMapping&& other) noexcept
+      : address{std::exchange(other.address, nullptr)}, size{other.size} {}
+  SegmentMapping& operator=(const SegmentMapping&) = delete;
+  SegmentMapping& operator=(SegmentMapping&&) = delete;
+  ~SegmentMapping() {
+    if (address != nullptr) {
+      munmap(address, size);
+    }
+  }
+
+  [[nodiscard]] void* get() const noexcept { return address; }
+
+private:
+  void* address;
+  std::size_t size;
+};
+} // namespace detail
+
+/// Publishes a running scan's stats into POSIX shared memory for `abrade_top`.
+///
+/// The segment is named `name_for(getpid())`, which Linux exposes as
+/// `/dev/shm/abrade.<pid>`, and is removed when the publisher is destroyed. A
+/// `PeriodicTimer` copies `RunStats`, the coroutine census, and the
+/// controller's recommendation and velocity into it every `publish_interval`
+/// with relaxed stores, so readers cost the scan nothing. Call `stop` once the
+/// scan finishes.
+class StatsSegment {
+public:
+  /// Time between publications.
+  static constexpr std::chrono::milliseconds publish_interval{100};
+
+  /// Returns the shared-memory name a scan running as `pid` publishes under.
+  [[nodiscard]] static std::string name_for(std::int64_t pid) {
+    return "/abrade." + std::to_string(pid);
+  }
+
+  /// Creates and maps the segment, replacing one a dead process with the same pid left behind.
+  StatsSegment(boost::asio::io_context& io_context, const RunStats& run_stats,
+               const Controller& run_controller, std::string_view host, std::string_view pattern,
+               std::optional<std::size_t> cardinality)
+      : ticker{io_context, publish_interval, [this] { publish(); }}, stats{run_stats},
+        controller{run_controller},
+        segment_name{name_for(getpid())}, mapping{create(segment_name)},
+        layout{new(mapping.get()) StatsSegmentLayout{}} {
+    layout->version = StatsSegmentLayout::current_version;
+    layout->pid = getpid();
+    detail::copy_field(layout->host, host);
+    detail::copy_field(layout->pattern, pattern);
+    layout->cardinality = cardinality.value_or(0U);
+    publish();
+    layout->magic.store(StatsSegmentLayout::magic_value, std::memory_order_release);
+  }
+  StatsSegment(const StatsSegment&) = delete;
+  StatsSegment(StatsSegment&&) = delete;
+  StatsSegment& operator=(const StatsSegment&) = delete;
+  StatsSegment& operator=(StatsSegment&&) = delete;
+  ~StatsSegment() { shm_unlink(segment_name.c_str()); }
+
+  /// Schedules the first publication.
+  void start() { ticker.start(); }
+
+  /// Cancels pending publications, then publishes the final values and marks the scan finished.
+  void stop() {
+    ticker.stop();
+    publish();
+    layout->finished.store(1U, std::memory_order_relaxed);
+  }
+
+  /// Copies the current stats into the segment.
+  void publish() noexcept {
+    const auto store = [](std::atomic<std::uint64_t>& field, std::uint64_t value) {
+      field.store(value, std::memory_order_relaxed);
+    };
+    store(layout->elapsed_millis, static_cast<std::uint64_t>(stats.elapsed_seconds() * 1000.0));
+    store(layout->requests, stats.attempted());
+    store(layout->candidates_finished, stats.candidates_finished());
+    store(layout->in_flight, stats.in_flight());
+    store(layout->hits, stats.hits());
+    store(layout->responses_2xx, stats.success_2xx());
+    store(layout->responses_other, stats.non_2xx());
+    store(layout->errors, stats.errors());
+    store(layout->bytes_received, stats.bytes_received());
+    store(layout->bytes_written, stats.bytes_written());
+    for (std::size_t state{}; state < state_names.size(); ++state) {
+      store(layout->waiting[state], stats.waiting(static_cast<CoroutineState>(state)));
+    }
+    store(layout->recommended_coroutines, controller.recommended_coroutines());
+    const auto velocity = std::llround(controller.measured_velocity() * 1000.0);
+    store(layout->velocity_millis, velocity > 0 ? static_cast<std::uint64_t>(velocity) : 0U);
+  }
+
+  /// Returns the shared-memory name of the segment.
+  [[nodiscard]] const std::string& name() const noexcept { return segment_name; }
+
+private:
+  static detail::SegmentMapping create(const std::string& name) {
+    const auto fail = [&name](std::string_view action) {
+      return AbradeException{std::string{action} + ' ' + name,
+                             boost::system::error_code{errno, boost::system::system_category()}};
+    };
+    shm_unlink(name.c_str());
+    const auto descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (descriptor < 0) {
+      throw fail("shm_open");
+    }
+    if (ftruncate(descriptor, static_cast<off_t>(sizeof(StatsSegmentLayout))) != 0) {
+      const auto error = fail("ftruncate");
+      close(descriptor);
+      shm_unlink(name.c_str());
+      throw error;
+    }
+    auto* const address = mmap(nullptr, sizeof(StatsSegmentLayout), PROT_READ | PROT_WRITE,
+                               MAP_SHARED, descriptor, 0);
+    const auto mapping_error = fail("mmap");
+    close(descriptor);
+    if (address == MAP_FAILED) {
+      shm_unlink(name.c_str());
+      throw mapping_error;
+    }
+    return detail::SegmentMapping{address, sizeof(StatsSegmentLayout)};
+  }
+
+  PeriodicTimer ticker;
+  const RunStats& stats;
+  const Controller& controller;
+  const std::string segment_name;
+  detail::SegmentMapping mapping;
+  StatsSegmentLayout* layout;
+};
+
+/// A read-only view of another process's `StatsSegment`.
+class StatsSegmentView {
+public:
+  /// Maps the segment called `name`, or returns nothing if it is missing or not a stats segment.
+  [[nodiscard]] static std::optional<StatsSegmentView> attach(const std::string& name) {
+    const auto descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+    if (descriptor < 0) {
+      return std::nullopt;
+    }
+    struct stat status {};
+    if (fstat(descriptor, &status) != 0 ||
+        static_cast<std::size_t>(status.st_size) < sizeof(StatsSegmentLayout)) {
+      close(descriptor);
+      return std::nullopt;
+    }
+    auto* const address =
+        mmap(nullptr, sizeof(StatsSegmentLayout), PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (address == MAP_FAILED) {
+      return std::nullopt;
+    }
+    StatsSegmentView view{detail::SegmentMapping{address, sizeof(StatsSegmentLayout)}};
+    if (view.layout->magic.load(std::memory_order_acquire) != StatsSegmentLayout::magic_value ||
+        view.layout->version != StatsSegmentLayout::current_version) {
+      return std::nullopt;
+    }
+    return view;
+  }
+
+  /// Lists the stats segment names in `/dev/shm`, where Linux keeps POSIX shared memory.
+  [[nodiscard]] static std::vector<std::string> discover() {
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator entry{"/dev/shm", ec}, end; !ec && entry != end;
+         entry.increment(ec)) {
+      const auto file_name = entry->path().filename().string();
+      if (file_name.starts_with("abrade.")) {
+        names.push_back('/' + file_name);
+      }
+    }
+    std::ranges::sort(names);
+    return names;
+  }
+
+  /// Reads the current values.
+  [[nodiscard]] StatsSnapshot snapshot() const {
+    const auto load = [](const std::atomic<std::uint64_t>& field) {
+      return field.load(std::memory_order_relaxed);
+    };
+    StatsSnapshot snapshot;
+    snapshot.pid = layout->pid;
+    snapshot.host = std::string{layout->host.data()};
+    snapshot.pattern = std::string{layout->pattern.data()};
+    if (layout->cardinality != 0U) {
+      snapshot.cardinality = layout->cardinality;
+    }
+    snapshot.finished = load(layout->finished) != 0U;
+    snapshot.elapsed_seconds = static_cast<double>(load(layout->elapsed_millis)) / 1000.0;
+    snapshot.requests = load(layout->requests);
+    snapshot.candidates_finished = load(layout->candidates_finished);
+    snapshot.in_flight = load(layout->in_flight);
+    snapshot.hits = load(layout->hits);
+    snapshot.responses_2xx = load(layout->responses_2xx);
+    snapshot.responses_other = load(layout->responses_other);
+    snapshot.errors = load(layout->errors);
+    snapshot.bytes_received = load(layout->bytes_received);
+    snapshot.bytes_written = load(layout->bytes_written);
+    for (std::size_t state{}; state < state_names.size(); ++state) {
+      snapshot.waiting[state] = load(layout->waiting[state]);
+    }
+    snapshot.recommended_coroutines = load(layout->recommended_coroutines);
+    snapshot.velocity = static_cast<double>(load(layout->velocity_millis)) / 1000.0;
+    return snapshot;
+  }
+
+private:
+  explicit StatsSegmentView(detail::SegmentMapping segment_mapping) noexcept
+      : mapping{std::move(segment_mapping)},
+        layout{static_cast<const StatsSegmentLayout*>(mapping.get())} {}
+
+  detail::SegmentMapping mapping;
+  const StatsSegmentLayout* layout;
+};
+} // namespace abrade
+#endif
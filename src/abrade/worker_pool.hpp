@@ -0,0 +1,128 @@
+#pragma once
+
+#include <abrade/run_stats.hpp>
+#include <algorithm>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace abrade {
+
+/// Bounded pool of threads for CPU-heavy response-body processing.
+///
+/// A coroutine on the networking thread hands a job to `run` and is suspended
+/// until a worker finishes it, so the io_context keeps servicing other sockets
+/// while bodies are scanned and spooled. At most `queue_limit` jobs are queued
+/// or running; further callers wait for a slot. A waiting coroutine stops
+/// reading its socket, which slows the scraper to what the workers can absorb.
+///
+/// Jobs may touch state owned by the calling coroutine and shared objects that
+/// are thread-safe, such as `NearDuplicates`, or read-only while the scan runs,
+/// such as `SoftNotFound` after `finish_calibration`. Pool bookkeeping,
+/// `RunStats`, and all other shared state stay on the networking thread. With
+/// zero threads, jobs run inline on the calling coroutine.
+class WorkerPool {
+public:
+  WorkerPool(boost::asio::io_context& io_context, std::size_t threads, std::size_t queue_limit,
+             RunStats& run_stats)
+      : ios{io_context}, limit{std::max<std::size_t>(queue_limit, 1U)},
+        slot_released{io_context, boost::asio::steady_timer::time_point::max()},
+        stats{run_stats} {
+    if (threads != 0U) {
+      pool.emplace(threads);
+      stats.record_worker_threads(threads);
+    }
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool(WorkerPool&&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  WorkerPool& operator=(WorkerPool&&) = delete;
+
+  ~WorkerPool() {
+    if (pool) {
+      pool->join();
+    }
+  }
+
+  /// Runs `job` on a worker and returns its result, rethrowing anything it threw.
+  template <typename Job> auto run(Job&& job, const boost::asio::yield_context& yield) {
+    using Result = std::invoke_result_t<Job&>;
+    if (!pool) {
+      return job();
+    }
+    while (in_flight >= limit) {
+      stats.record_worker_wait();
+      boost::system::error_code ignored;
+      slot_released.async_wait(yield[ignored]);
+    }
+    in_flight++;
+    stats.record_worker_queue_depth(in_flight);
+
+    Completion<Result> completion{ios};
+    boost::asio::post(*pool, [this, &completion, &job] {
+      const auto started = std::chrono::steady_clock::now();
+      completion.invoke(job);
+      completion.busy = std::chrono::steady_clock::now() - started;
+      boost::asio::post(ios, [&completion] { completion.done.cancel(); });
+    });
+    // The worker cancels `done`; the wait cannot miss it because both run on this thread.
+    boost::system::error_code ignored;
+    completion.done.async_wait(yield[ignored]);
+
+    in_flight--;
+    slot_released.cancel_one();
+    stats.record_worker_job(completion.busy);
+    return completion.take();
+  }
+
+private:
+  template <typename Result> struct Completion {
+    explicit Completion(boost::asio::io_context& io_context)
+        : done{io_context, boost::asio::steady_timer::time_point::max()} {}
+
+    template <typename Job> void invoke(Job& job) noexcept {
+      try {
+        if constexpr (std::is_void_v<Result>) {
+          job();
+          value.emplace();
+        } else {
+          value.emplace(job());
+        }
+      } catch (...) {
+        failure = std::current_exception();
+      }
+    }
+
+    Result take() {
+      if (failure) {
+        std::rethrow_exception(failure);
+      }
+      if constexpr (!std::is_void_v<Result>) {
+        return std::move(*value);
+      }
+    }
+
+    boost::asio::steady_timer done;
+    std::chrono::steady_clock::duration busy{};
+    std::exception_ptr failure;
+    std::optional<std::conditional_t<std::is_void_v<Result>, std::monostate, Result>> value;
+  };
+
+  boost::asio::io_context& ios;
+  std::optional<boost::asio::thread_pool> pool;
+  std::size_t limit;
+  std::size_t in_flight{};
+  boost::asio::steady_timer slot_released;
+  RunStats& stats;
+};
+} // namespace abrade
@@ -2,8 +2,10 @@
 #include <abrade/candidate.hpp>
 #include <abrade/exception.hpp>
 #include <abrade/network_timeout.hpp>
+#include <abrade/run_stats.hpp>
 #include <boost/asio.hpp>
 #include <boost/beast/core.hpp>
+#include <chrono>
 #include <string>
 
 namespace abrade {
@@ -27,31 +29,45 @@ inline RequestType build_request_template(const std::string& host_name,
 /// Writes an HTTP request for a generated candidate to an established stream.
 ///
 /// `RequestWriter` intentionally knows only about request construction. It does
-/// not own connection setup, response parsing, or output side effects.
+/// not own connection setup, response parsing, or output side effects. Write
+/// latency is recorded as `Phase::write`.
 struct RequestWriter {
-  RequestWriter(const std::string& host_name, bool verbose_output, const std::string& user_agent)
+  RequestWriter(const std::string& host_name, bool verbose_output, const std::string& user_agent,
+                RunStats& run_stats)
       : is_verbose{verbose_output},
-        request_template{build_request_template(host_name, user_agent)} {}
+        request_template{build_request_template(host_name, user_agent)}, stats{run_stats} {}
 
-  /// Applies the query method and candidate URI, then writes the request asynchronously.
+  /// Applies the candidate URI and query method, writes the request asynchronously, and returns
+  /// the method written.
+  ///
+  /// A candidate that carries its own method overrides the query's. The
+  /// returned method tells the query which response to expect.
   template <typename Stream, typename Query>
-  void make_request(Stream&& stream, const Query& query, const Candidate& candidate,
-                    const boost::asio::yield_context& yield) {
+  boost::beast::http::verb make_request(Stream&& stream, Query&& query, const Candidate& candidate,
+                                        const boost::asio::yield_context& yield) {
     auto request{request_template};
-    query.set_method(request);
     request.target(candidate.uri);
+    if (candidate.method) {
+      request.method(*candidate.method);
+    } else {
+      query.set_method(request);
+    }
     // TODO: Content, headers.
     request.prepare_payload();
     if (is_verbose) {
       std::cout << "[ ] Payload for " << candidate.uri << ": " << request;
     }
+    PhaseTimer phase{stats, Phase::write, &boost::beast::get_lowest_layer(stream)};
     await_stream_with_timeout(stream, "make request", yield, [&stream, &request](auto token) {
       boost::beast::http::async_write(stream, request, token);
     });
+    phase.finish();
+    return request.method();
   }
 
 private:
   const bool is_verbose;
   const RequestType request_template;
+  RunStats& stats;
 };
 } // namespace abrade
@@ -1,17 +1,42 @@
 #include <abrade/action.hpp>
+#include <abrade/calibration.hpp>
 #include <abrade/connection.hpp>
 #include <abrade/controller.hpp>
+#include <abrade/controller_timer.hpp>
+#include <abrade/endpoint.hpp>
 #include <abrade/generator.hpp>
+#include <abrade/metrics.hpp>
+#include <abrade/near_duplicates.hpp>
 #include <abrade/options.hpp>
+#include <abrade/progress.hpp>
 #include <abrade/query.hpp>
 #include <abrade/redirect_policy.hpp>
+#include <abrade/request_trace.hpp>
+#include <abrade/resource_usage.hpp>
+#include <abrade/run_report.hpp>
 #include <abrade/run_stats.hpp>
 #include <abrade/scraper.hpp>
 #include <abrade/scraper_runtime.hpp>
+#include <abrade/soft_not_found.hpp>
+#include <abrade/worker_pool.hpp>
 #include <abrade/writer.hpp>
+#include <chrono>
+#include <cstddef>
+#include <functional>
 #include <iostream>
+#include <optional>
+#include <random>
+#include <string>
 #include <utility>
 
+#if defined(_WIN32)
+#include <cstdio>
+#include <io.h>
+#else
+#include <abrade/stats_segment.hpp>
+#include <unistd.h>
+#endif
+
 using namespace std;
 using namespace abrade;
 
@@ -19,7 +44,8 @@ namespace {
 template <typename Generator, typename Query, typename Connection, typename RequestWriter>
 void run_scraper(Generator&& generator, Query&& query, Connection&& connection,
                  Controller& controller, RequestWriter& writer, boost::asio::io_context& ios,
-                 const Options& options, RunStats& stats) {
+                 const Options& options, RunStats& stats,
+                 const std::function<void()>& on_finished) {
   Scraper<Generator, Query, Connection, RequestWriter, FileErrorLog> scraper{
       std::forward<Query>(query),
       std::forward<Connection>(connection),
@@ -28,7 +54,7 @@ void run_scraper(Generator&& generator, Query&& query, Connection&& connection,
       controller,
       ios,
       stats};
-  scraper.run(std::forward<Generator>(generator));
+  scraper.run(std::forward<Generator>(generator), on_finished);
 }
 
 Generator& make_generator(const Options& options) {
@@ -53,18 +79,162 @@ ContentFilters make_content_filters(const Options& options) {
                         options.get_required_regexes(), options.get_rejected_regexes()};
 }
 
-GetQuery make_get(const Options& options, RunStats& stats) {
-  return GetQuery{GetAction{options.get_output_path(), make_content_filters(options),
-                            options.is_verbose(), stats},
+HeaderFilters make_header_filters(const Options& options) {
+  return HeaderFilters{options.get_content_types(), options.get_min_length(),
+                       options.get_max_length(), options.get_required_header_regexes(),
+                       options.get_rejected_header_regexes()};
+}
+
+/// Run-wide state that actions consult to drop 2xx bodies; null members are disabled.
+struct BodyTriage {
+  SoftNotFound* soft_not_found{};
+  NearDuplicates* near_duplicates{};
+};
+
+GetQuery make_get(const Options& options, WorkerPool& workers, RunStats& stats, BodyTriage triage) {
+  return GetQuery{GetAction{options.get_output_path(), make_content_filters(options), stats,
+                            make_header_filters(options), triage.soft_not_found,
+                            triage.near_duplicates},
                   options.is_print_found(), options.is_verbose(), make_redirect_policy(options),
-                  stats};
+                  options.is_close_error_bodies(), workers, stats};
 }
 
-HeadQuery make_head(const Options& options, RunStats& stats) {
-  return HeadQuery{HeadAction{options.get_output_path(), options.is_verbose()},
-                   options.is_print_found(), options.is_verbose(), make_redirect_policy(options),
+HeadQuery make_head(const Options& options, const RequestWriter& writer, RunStats& stats,
+                    BodyTriage triage) {
+  return HeadQuery{HeadAction{options.get_output_path(), options.is_verbose(),
+                              make_header_filters(options), triage.soft_not_found},
+                   options.is_print_found(),
+                   options.is_verbose(),
+                   make_redirect_policy(options),
+                   writer,
+                   options.is_head_fallback(),
                    stats};
 }
+
+ProbeQuery make_probe(const Options& options, const RequestWriter& writer, WorkerPool& workers,
+                      RunStats& stats, BodyTriage triage) {
+  return ProbeQuery{make_get(options, workers, stats, triage),
+                    writer,
+                    options.is_verbose(),
+                    make_redirect_policy(options),
+                    options.is_head_fallback(),
+                    stats};
+}
+
+template <typename Connection>
+void run_mode(Generator& generator, Connection&& connection, Controller& controller,
+              RequestWriter& writer, boost::asio::io_context& ios, const Options& options,
+              WorkerPool& workers, RunStats& stats, BodyTriage triage,
+              const std::function<void()>& on_finished) {
+  if (options.is_probe()) {
+    run_scraper(generator, make_probe(options, writer, workers, stats, triage),
+                std::forward<Connection>(connection), controller, writer, ios, options, stats,
+                on_finished);
+  } else if (options.is_contents()) {
+    run_scraper(generator, make_get(options, workers, stats, triage),
+                std::forward<Connection>(connection), controller, writer, ios, options, stats,
+                on_finished);
+  } else {
+    run_scraper(generator, make_head(options, writer, stats, triage),
+                std::forward<Connection>(connection), controller, writer, ios, options, stats,
+                on_finished);
+  }
+}
+
+void run_scan(Generator& generator, Controller& controller, boost::asio::io_context& ios,
+              const Options& options, WorkerPool& workers, RunStats& stats, BodyTriage triage,
+              const std::function<void()>& on_finished = {}) {
+  RequestWriter writer{options.get_host(), options.is_verbose(), options.get_user_agent(), stats};
+  if (options.is_tls()) {
+    if (options.is_proxy()) {
+      run_mode(generator,
+               ProxiedTlsConnection{options.get_proxy(), options.get_host(), options.is_verify(),
+                                    options.is_sensitive_teardown(), ios, stats},
+               controller, writer, ios, options, workers, stats, triage, on_finished);
+    } else {
+      run_mode(generator,
+               TlsConnection{options.get_host(), options.is_verify(),
+                             options.is_sensitive_teardown(), ios, stats},
+               controller, writer, ios, options, workers, stats, triage, on_finished);
+    }
+  } else {
+    if (options.is_proxy()) {
+      run_mode(generator,
+               ProxiedConnection{options.get_proxy(), options.get_host(),
+                                 options.is_sensitive_teardown(), ios, stats},
+               controller, writer, ios, options, workers, stats, triage, on_finished);
+    } else {
+      run_mode(generator,
+               PlaintextConnection{options.get_host(), options.is_sensitive_teardown(), ios, stats},
+               controller, writer, ios, options, workers, stats, triage, on_finished);
+    }
+  }
+}
+
+/// True when stdout is a terminal, where the progress line can be redrawn in place.
+bool is_stdout_terminal() {
+#if defined(_WIN32)
+  return _isatty(_fileno(stdout)) != 0;
+#else
+  return isatty(STDOUT_FILENO) != 0;
+#endif
+}
+
+/// Resolves a validated `--metrics-listen` value into the endpoint to bind.
+boost::asio::ip::tcp::endpoint make_listen_endpoint(const std::string& listen) {
+  const auto endpoint = parse_host_endpoint(listen, "", 0);
+  return boost::asio::ip::tcp::endpoint{boost::asio::ip::make_address(endpoint.host),
+                                        endpoint.port};
+}
+
+/// Requests random nonexistent candidates shaped like the first real one and learns their 2xx
+/// answers. Runs on the caller's io_context, which is restarted for the main scan afterwards.
+void calibrate(SoftNotFound& soft_not_found, boost::asio::io_context& ios, const Options& options) {
+  std::string sample{"/"};
+  if (!options.is_stdin()) {
+    UriGenerator uri_generator{options.get_pattern(), options.is_leading_zeros(),
+                               options.is_telescoping()};
+    if (auto first = uri_generator.next()) {
+      sample = std::move(*first);
+    }
+  }
+  ListGenerator targets{SoftNotFound::calibration_targets(
+      sample, SoftNotFound::calibration_probes, std::random_device{}())};
+  RunStats calibration_stats;
+  WorkerPool inline_workers{ios, 0U, options.get_worker_queue(), calibration_stats};
+  FixedController controller{SoftNotFound::calibration_probes, options.get_sample_interval()};
+  run_scan(targets, controller, ios, options, inline_workers, calibration_stats,
+           BodyTriage{.soft_not_found = &soft_not_found});
+  soft_not_found.finish_calibration();
+  ios.restart();
+  cout << "[ ] Soft-404 calibration: " << soft_not_found.size() << " of "
+       << SoftNotFound::calibration_probes << " random candidates answered 2xx";
+  if (calibration_stats.has_errors()) {
+    cout << " (" << calibration_stats.errors() << " failed)";
+  }
+  cout << '\n';
+}
+
+/// Sweeps concurrency levels over the scan's first candidates and prints the curve.
+///
+/// The sweep's candidates are requested like the scan's own, into the same
+/// stats, so hits count toward the scan and the scan resumes after them.
+CalibrationSweep sweep_concurrency(Generator& generator, boost::asio::io_context& ios,
+                                   const Options& options, WorkerPool& workers, RunStats& stats,
+                                   BodyTriage triage) {
+  CalibrationSweep sweep{options.get_minimum_coroutines(), options.get_maximum_coroutines()};
+  while (const auto level = sweep.next_level()) {
+    LimitedGenerator candidates{generator, CalibrationSweep::candidates(*level)};
+    CalibrationController controller{*level};
+    run_scan(candidates, controller, ios, options, workers, stats, triage);
+    ios.restart();
+    sweep.record(controller.step());
+    cout << sweep.curve().back().describe() << '\n';
+  }
+  cout << "[ ] Calibrated concurrency: --init " << sweep.initial() << " --min " << sweep.minimum()
+       << " --max " << sweep.maximum() << '\n';
+  return sweep;
+}
 } // namespace
 
 int main(int argc, const char** argv) {
@@ -77,23 +247,19 @@ int main(int argc, const char** argv) {
     cout << options.get_pretty_print() << '\n';
     RunStats stats;
     boost::asio::io_context ios;
-    RequestWriter writer{options.get_host(), options.is_verbose(), options.get_user_agent()};
-    FixedController fixed_controller{options.get_initial_coroutines(),
-                                     options.get_sample_interval()};
-    AdaptiveController adaptive_controller{
-        options.get_initial_coroutines(), options.get_sample_size(), options.get_sample_interval(),
-        options.get_minimum_coroutines(), options.get_maximum_coroutines()};
-    auto& controller = options.is_optimizer() ? static_cast<Controller&>(adaptive_controller)
-                                              : static_cast<Controller&>(fixed_controller);
+    WorkerPool workers{ios, options.is_contents() ? options.get_workers() : 0U,
+                       options.get_worker_queue(), stats};
+    std::optional<std::size_t> cardinality;
+    std::optional<double> log_cardinality;
     if (!options.is_stdin()) {
       const UriGenerator uri_generator{options.get_pattern(), options.is_leading_zeros(),
                                        options.is_telescoping()};
       try {
-        const auto cardinality = uri_generator.get_range_size();
-        cout << "[ ] URL generation set cardinality is " << cardinality << '\n';
+        cardinality = uri_generator.get_range_size();
+        cout << "[ ] URL generation set cardinality is " << *cardinality << '\n';
       } catch (const overflow_error&) {
-        cout << "[!] URL generation set log cardinality is " << uri_generator.get_log_range_size()
-             << '\n';
+        log_cardinality = uri_generator.get_log_range_size();
+        cout << "[!] URL generation set log cardinality is " << *log_cardinality << '\n';
       }
     }
     auto& generator = make_generator(options);
@@ -105,53 +271,125 @@ int main(int argc, const char** argv) {
       }
       return EXIT_SUCCESS;
     }
-    if (options.is_tls()) {
-      if (options.is_proxy()) {
-        auto connection =
-            ProxiedTlsConnection{options.get_proxy(), options.get_host(), options.is_verify(),
-                                 options.is_sensitive_teardown(), ios};
-        if (options.is_contents()) {
-          run_scraper(generator, make_get(options, stats), std::move(connection), controller,
-                      writer, ios, options, stats);
-        } else {
-          run_scraper(generator, make_head(options, stats), std::move(connection), controller,
-                      writer, ios, options, stats);
-        }
-      } else {
-        auto connection = TlsConnection{options.get_host(), options.is_verify(),
-                                        options.is_sensitive_teardown(), ios};
-        if (options.is_contents()) {
-          run_scraper(generator, make_get(options, stats), std::move(connection), controller,
-                      writer, ios, options, stats);
-        } else {
-          run_scraper(generator, make_head(options, stats), std::move(connection), controller,
-                      writer, ios, options, stats);
-        }
-      }
-    } else {
-      if (options.is_proxy()) {
-        auto connection = ProxiedConnection{options.get_proxy(), options.get_host(),
-                                            options.is_sensitive_teardown(), ios};
-        if (options.is_contents()) {
-          run_scraper(generator, make_get(options, stats), std::move(connection), controller,
-                      writer, ios, options, stats);
-        } else {
-          run_scraper(generator, make_head(options, stats), std::move(connection), controller,
-                      writer, ios, options, stats);
-        }
-      } else {
-        auto connection =
-            PlaintextConnection{options.get_host(), options.is_sensitive_teardown(), ios};
-        if (options.is_contents()) {
-          run_scraper(generator, make_get(options, stats), std::move(connection), controller,
-                      writer, ios, options, stats);
-        } else {
-          run_scraper(generator, make_head(options, stats), std::move(connection), controller,
-                      writer, ios, options, stats);
-        }
+    BodyTriage triage;
+    SoftNotFound soft_not_found;
+    if (options.is_soft_not_found()) {
+      calibrate(soft_not_found, ios, options);
+      triage.soft_not_found = &soft_not_found;
+    }
+    std::optional<NearDuplicates> near_duplicates;
+    if (options.get_cluster_exemplars() != 0U) {
+      triage.near_duplicates = &near_duplicates.emplace(options.get_cluster_exemplars(),
+                                                        options.get_cluster_index_path());
+    }
+    auto initial_coroutines = options.get_initial_coroutines();
+    auto minimum_coroutines = options.get_minimum_coroutines();
+    auto maximum_coroutines = options.get_maximum_coroutines();
+    if (options.is_calibrate()) {
+      const auto sweep = sweep_concurrency(generator, ios, options, workers, stats, triage);
+      if (options.is_calibrate_only()) {
+        return EXIT_SUCCESS;
       }
+      initial_coroutines = sweep.initial();
+      minimum_coroutines = sweep.minimum();
+      maximum_coroutines = sweep.maximum();
+    }
+    FixedController fixed_controller{initial_coroutines, options.get_sample_interval()};
+    AdaptiveController adaptive_controller{initial_coroutines, options.get_sample_size(),
+                                           options.get_sample_interval(), minimum_coroutines,
+                                           maximum_coroutines};
+    AimdController aimd_controller{stats,
+                                   initial_coroutines,
+                                   options.get_sample_size(),
+                                   options.get_sample_interval(),
+                                   minimum_coroutines,
+                                   maximum_coroutines};
+    GradientController gradient_controller{initial_coroutines, options.get_sample_size(),
+                                           options.get_sample_interval(), minimum_coroutines,
+                                           maximum_coroutines};
+    auto& controller = options.get_controller() == "gradient"
+                           ? static_cast<Controller&>(gradient_controller)
+                       : options.get_controller() == "aimd"
+                           ? static_cast<Controller&>(aimd_controller)
+                       : options.get_controller() == "adaptive"
+                           ? static_cast<Controller&>(adaptive_controller)
+                           : static_cast<Controller&>(fixed_controller);
+    std::optional<ProgressLine> progress;
+    if (options.get_progress_interval() != 0U) {
+      // Found and verbose lines would break a line redrawn in place, so they get periodic lines.
+      const auto in_place = is_stdout_terminal() && !options.is_print_found();
+      // The progress line reports the run instead of the controller's per-sample lines.
+      controller.mute();
+      const std::chrono::milliseconds interval{
+          static_cast<std::chrono::milliseconds::rep>(options.get_progress_interval())};
+      progress.emplace(ios, stats, interval, cardinality, cout, in_place);
+      progress->start();
+    }
+    std::optional<RequestTracer> tracer;
+    if (!options.get_trace_path().empty()) {
+      stats.attach_tracer(tracer.emplace(options.get_trace_sample()));
+    }
+    std::optional<MetricsServer> metrics;
+    if (!options.get_metrics_listen().empty()) {
+      metrics.emplace(ios, make_listen_endpoint(options.get_metrics_listen()), stats, controller);
+      metrics->start();
+      cout << "[ ] Serving metrics at http://" << metrics->local_endpoint() << "/metrics\n";
+    }
+    std::optional<ControllerTimer> controller_timer;
+    if (options.get_sample_window() != 0U) {
+      const std::chrono::milliseconds window{
+          static_cast<std::chrono::milliseconds::rep>(options.get_sample_window())};
+      controller_timer.emplace(ios, controller, window, options.get_sample_minimum());
+      controller_timer->start();
+    }
+    // Options reject --shm-stats where there is no POSIX shared memory.
+    std::function<void()> stop_segment;
+#if !defined(_WIN32)
+    std::optional<StatsSegment> segment;
+    if (options.is_shm_stats()) {
+      segment.emplace(ios, stats, controller, options.get_host(),
+                      options.is_stdin() ? "<stdin>" : options.get_pattern(), cardinality);
+      segment->start();
+      stop_segment = [&segment] { segment->stop(); };
+      cout << "[ ] Publishing stats to shared memory " << segment->name() << '\n';
+    }
+#endif
+    run_scan(generator, controller, ios, options, workers, stats, triage,
+             [&progress, &controller_timer, &metrics, &stop_segment] {
+               if (progress) {
+                 progress->stop();
+               }
+               if (controller_timer) {
+                 controller_timer->stop();
+               }
+               if (metrics) {
+                 metrics->stop();
+               }
+               if (stop_segment) {
+                 stop_segment();
+               }
+             });
+    if (near_duplicates) {
+      near_duplicates->flush();
+      cout << "[ ] Near-duplicate clusters: " << near_duplicates->size() << " (index "
+           << options.get_cluster_index_path() << ")\n";
     }
     cout << stats.summary() << '\n';
+    if (tracer) {
+      tracer->write(options.get_trace_path());
+      cout << "[ ] Trace written to " << options.get_trace_path() << ": "
+           << tracer->sampled_candidates() << " candidates, " << tracer->events() << " events";
+      if (tracer->dropped() != 0U) {
+        cout << " (" << tracer->dropped() << " dropped)";
+      }
+      cout << '\n';
+    }
+    if (!options.get_report_path().empty()) {
+      write_run_report(options.get_report_path(),
+                       RunReport{options, stats, controller, cardinality, log_cardinality,
+                                 ResourceUsage::sample()});
+      cout << "[ ] Run report written to " << options.get_report_path() << '\n';
+    }
     return stats.has_errors() ? EXIT_FAILURE : EXIT_SUCCESS;
   } catch (const OptionsException& e) {
     cerr << "[-] " << e.what() << '\n';
@@ -0,0 +1,159 @@
+#include <abrade/controller.hpp>
+#include <abrade/controller_sim.hpp>
+#include <abrade/run_stats.hpp>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace abrade;
+
+/// Benchmarks concurrency controllers against simulated targets in virtual time.
+///
+/// Every selected controller runs against every selected scenario with the
+/// same seed, so a table is reproducible and two builds can be compared row by
+/// row. Controller diagnostics are muted; only the summary table is printed.
+namespace {
+/// Swallows the per-sample lines controllers print during a simulated run.
+struct NullBuffer : streambuf {
+  int overflow(int character) override { return character; }
+};
+
+struct ControllerSettings {
+  size_t initial, minimum, maximum, sample_size, sample_interval;
+};
+
+unique_ptr<Controller> make_controller(const string& name, const RunStats& stats,
+                                       const ControllerSettings& settings) {
+  if (name == "fixed") {
+    return make_unique<FixedController>(settings.initial, settings.sample_interval);
+  }
+  if (name == "adaptive") {
+    return make_unique<AdaptiveController>(settings.initial, settings.sample_size,
+                                           settings.sample_interval, settings.minimum,
+                                           settings.maximum);
+  }
+  if (name == "aimd") {
+    return make_unique<AimdController>(stats, settings.initial, settings.sample_size,
+                                       settings.sample_interval, settings.minimum,
+                                       settings.maximum);
+  }
+  return make_unique<GradientController>(settings.initial, settings.sample_size,
+                                         settings.sample_interval, settings.minimum,
+                                         settings.maximum);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  namespace po = boost::program_options;
+  vector<string> controllers, scenario_names;
+  ControllerSettings controller_settings{};
+  size_t duration{}, window{}, timeout{};
+  SimulationSettings settings;
+  po::options_description description{"Usage: abrade_controller_sim [options]"};
+  description.add_options()("help,h", "produce help message")(
+      "controller", po::value<vector<string>>(&controllers)->composing(),
+      "fixed, adaptive, aimd, or gradient. repeatable; default: all")(
+      "scenario", po::value<vector<string>>(&scenario_names)->composing(),
+      "scenario to run. repeatable; default: all")("list", po::bool_switch(),
+                                                   "list the scenarios and exit")(
+      "duration", po::value<size_t>(&duration)->default_value(120),
+      "virtual seconds per run")("seed", po::value<uint64_t>(&settings.seed)->default_value(1),
+                                 "seed of the simulated noise")(
+      "timeout", po::value<size_t>(&timeout)->default_value(30000),
+      "milliseconds before a request times out")(
+      "init,i", po::value<size_t>(&controller_settings.initial)->default_value(1000),
+      "initial number of simultaneous requests")(
+      "min", po::value<size_t>(&controller_settings.minimum)->default_value(1),
+      "minimum number of simultaneous requests")(
+      "max", po::value<size_t>(&controller_settings.maximum)->default_value(25000),
+      "maximum number of simultaneous requests")(
+      "ssize", po::value<size_t>(&controller_settings.sample_size)->default_value(50),
+      "size of velocity sliding window")(
+      "sint", po::value<size_t>(&controller_settings.sample_interval)->default_value(1000),
+      "size of sampling interval when --swin is 0")(
+      "swin", po::value<size_t>(&window)->default_value(1000),
+      "milliseconds per controller sample; 0 samples every --sint completions")(
+      "smin", po::value<size_t>(&settings.minimum_completions)->default_value(20),
+      "fewest completions in a timed controller sample");
+  po::variables_map variables;
+  try {
+    po::store(po::parse_command_line(argc, argv, description), variables);
+    po::notify(variables);
+  } catch (const po::error& e) {
+    cerr << "[-] " << e.what() << '\n' << description << '\n';
+    return 2;
+  }
+  if (variables.contains("help")) {
+    cout << description << '\n';
+    return EXIT_SUCCESS;
+  }
+  if (variables["list"].as<bool>()) {
+    for (const auto& scenario : scenarios) {
+      cout << left << setw(8) << scenario.name << scenario.description << '\n';
+    }
+    return EXIT_SUCCESS;
+  }
+  if (duration == 0U || timeout == 0U || controller_settings.sample_size == 0U ||
+      controller_settings.sample_interval == 0U || settings.minimum_completions == 0U ||
+      controller_settings.minimum == 0U) {
+    cerr << "[-] duration, timeout, min, ssize, sint, and smin must be positive\n";
+    return 2;
+  }
+  if (controllers.empty()) {
+    controllers = {"fixed", "adaptive", "aimd", "gradient"};
+  }
+  for (const auto& name : controllers) {
+    if (name != "fixed" && name != "adaptive" && name != "aimd" && name != "gradient") {
+      cerr << "[-] controller must be fixed, adaptive, aimd, or gradient\n";
+      return 2;
+    }
+  }
+  vector<Scenario> selected;
+  for (const auto& name : scenario_names) {
+    const auto found = ranges::find(scenarios, name, &Scenario::name);
+    if (found == scenarios.end()) {
+      cerr << "[-] Unknown scenario " << name << "; --list shows them\n";
+      return 2;
+    }
+    selected.push_back(*found);
+  }
+  if (selected.empty()) {
+    selected.assign(scenarios.begin(), scenarios.end());
+  }
+  settings.duration = chrono::seconds{static_cast<chrono::seconds::rep>(duration)};
+  settings.sample_window = chrono::milliseconds{static_cast<chrono::milliseconds::rep>(window)};
+  settings.timeout = chrono::milliseconds{static_cast<chrono::milliseconds::rep>(timeout)};
+
+  cout << left << setw(11) << "CONTROLLER" << setw(8) << "SCENARIO" << right << setw(10)
+       << "CONVERGE" << setw(10) << "REQ/S" << setw(8) << "EFF%" << setw(10) << "LAT-MS"
+       << setw(10) << "CONC" << setw(10) << "OSC" << setw(10) << "OVERLOADS" << setw(7) << "ERR%"
+       << '\n';
+  NullBuffer muted;
+  for (const auto& name : controllers) {
+    for (const auto& scenario : selected) {
+      RunStats stats;
+      const auto controller = make_controller(name, stats, controller_settings);
+      auto* const output = cout.rdbuf(&muted);
+      ControllerSimulation simulation{scenario.server, settings};
+      const auto result = simulation.run(*controller, stats);
+      cout.rdbuf(output);
+      cout << left << setw(11) << name << setw(8) << scenario.name << right << fixed
+           << setprecision(0) << setw(9) << result.convergence_seconds << 's' << setw(10)
+           << result.throughput << setprecision(1) << setw(8)
+           << 100.0 * result.throughput / result.ideal_throughput << setw(10) << result.latency_ms
+           << setprecision(0) << setw(10) << result.concurrency << setw(10) << result.oscillation
+           << setw(10) << result.overload_episodes << setprecision(1) << setw(7)
+           << 100.0 * result.error_rate << '\n';
+    }
+  }
+  return EXIT_SUCCESS;
+}
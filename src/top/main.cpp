@@ -0,0 +1,169 @@
+#include <abrade/run_stats.hpp>
+#include <abrade/stats_segment.hpp>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <signal.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace abrade;
+
+/// Live table of the scans on this machine that publish `--shm-stats` segments.
+///
+/// Each refresh maps every segment read-only, so watching a scan costs it
+/// nothing. Rates cover the scan time since the previous refresh.
+namespace {
+using Readings = map<int64_t, StatsSnapshot>;
+
+bool is_running(int64_t pid) {
+  return kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+}
+
+string clip(const string& text, size_t width) {
+  return text.size() <= width ? text : text.substr(0, width - 1U) + "~";
+}
+
+/// Returns the change of a counter per second of scan time since `previous`, or the run average.
+double per_second(uint64_t current, uint64_t before, double seconds) {
+  return seconds > 0.0 ? static_cast<double>(current - before) / seconds : 0.0;
+}
+
+string render(const vector<StatsSnapshot>& scans, const Readings& previous) {
+  ostringstream table;
+  table << left << setw(8) << "PID" << setw(22) << "HOST" << setw(24) << "PATTERN" << right
+        << setw(9) << "ELAPSED" << setw(9) << "REQ/S" << setw(9) << "MIB/S" << setw(9)
+        << "IN-FLT";
+  for (const auto& name : state_names) {
+    string heading{name};
+    ranges::transform(heading, heading.begin(), [](char letter) {
+      return static_cast<char>(toupper(static_cast<unsigned char>(letter)));
+    });
+    table << setw(8) << heading;
+  }
+  table << setw(8) << "HITS" << setw(7) << "ERR%" << setw(8) << "DONE" << setw(8) << "CONC"
+        << '\n';
+  for (const auto& scan : scans) {
+    const auto found = previous.find(scan.pid);
+    const auto& before = found == previous.end() ? StatsSnapshot{} : found->second;
+    const auto window = scan.elapsed_seconds - before.elapsed_seconds;
+    table << left << setw(8) << scan.pid << setw(22) << clip(scan.host, 21) << setw(24)
+          << clip(scan.pattern, 23) << right << fixed << setprecision(1) << setw(8)
+          << scan.elapsed_seconds << 's' << setw(9)
+          << per_second(scan.requests, before.requests, window) << setprecision(2) << setw(9)
+          << per_second(scan.bytes_received, before.bytes_received, window) / (1024.0 * 1024.0)
+          << setw(9) << scan.in_flight;
+    for (const auto waiting : scan.waiting) {
+      table << setw(8) << waiting;
+    }
+    table << setw(8) << scan.hits << setprecision(1) << setw(6)
+          << (scan.candidates_finished != 0U ? 100.0 * static_cast<double>(scan.errors) /
+                                                   static_cast<double>(scan.candidates_finished)
+                                             : 0.0)
+          << '%';
+    if (scan.finished) {
+      table << setw(8) << "done";
+    } else if (scan.cardinality) {
+      table << setw(7)
+            << 100.0 * static_cast<double>(scan.candidates_finished) /
+                   static_cast<double>(*scan.cardinality)
+            << '%';
+    } else {
+      table << setw(8) << "-";
+    }
+    table << setw(8) << scan.recommended_coroutines << '\n';
+  }
+  return table.str();
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  namespace po = boost::program_options;
+  vector<int64_t> pids;
+  size_t interval_ms{};
+  po::options_description description{"Usage: abrade_top [PID...]"};
+  description.add_options()("help,h", "produce help message")(
+      "interval", po::value<size_t>(&interval_ms)->default_value(1000),
+      "milliseconds between refreshes")("once", po::bool_switch(),
+                                        "print one table and exit")(
+      "pid", po::value<vector<int64_t>>(&pids)->composing(),
+      "scan process to show. repeatable; default: every scan in /dev/shm");
+  po::positional_options_description positional;
+  positional.add("pid", -1);
+  po::variables_map variables;
+  try {
+    po::store(
+        po::command_line_parser{argc, argv}.options(description).positional(positional).run(),
+        variables);
+    po::notify(variables);
+  } catch (const po::error& e) {
+    cerr << "[-] " << e.what() << '\n' << description << '\n';
+    return 2;
+  }
+  if (variables.contains("help")) {
+    cout << description << '\n';
+    return EXIT_SUCCESS;
+  }
+  const auto once = variables["once"].as<bool>();
+  if (interval_ms == 0U) {
+    cerr << "[-] interval must be positive\n";
+    return 2;
+  }
+  const chrono::milliseconds interval{static_cast<chrono::milliseconds::rep>(interval_ms)};
+  // Piped output gets one table per refresh instead of a redrawn screen.
+  const auto redraw = !once && isatty(STDOUT_FILENO) != 0;
+
+  Readings previous;
+  while (true) {
+    vector<string> names;
+    if (pids.empty()) {
+      names = StatsSegmentView::discover();
+    } else {
+      for (const auto pid : pids) {
+        names.push_back(StatsSegment::name_for(pid));
+      }
+    }
+    vector<StatsSnapshot> scans;
+    for (const auto& name : names) {
+      if (const auto view = StatsSegmentView::attach(name)) {
+        auto scan = view->snapshot();
+        // A scan that crashed leaves its segment behind.
+        if (is_running(scan.pid)) {
+          scans.push_back(std::move(scan));
+        }
+      }
+    }
+    if (once && scans.empty()) {
+      cerr << "[-] No abrade scans are publishing stats\n";
+      return EXIT_FAILURE;
+    }
+    if (redraw) {
+      cout << "\x1b[H\x1b[2J";
+    }
+    cout << render(scans, previous) << flush;
+    if (once) {
+      return EXIT_SUCCESS;
+    }
+    previous.clear();
+    for (const auto& scan : scans) {
+      previous.emplace(scan.pid, scan);
+    }
+    this_thread::sleep_for(interval);
+    if (!redraw) {
+      cout << '\n';
+    }
+  }
+}
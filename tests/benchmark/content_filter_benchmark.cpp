@@ -0,0 +1,83 @@
+#include <abrade/content_filter.hpp>
+#include <algorithm>
+#include <boost/regex.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace abrade;
+
+namespace {
+std::string make_body(std::size_t size) {
+  std::mt19937 random{42};
+  std::uniform_int_distribution<int> letter{'a', 'z' + 1};
+  std::string body;
+  body.reserve(size);
+  while (body.size() < size) {
+    const auto value = letter(random);
+    body.push_back(value > 'z' ? ' ' : static_cast<char>(value));
+  }
+  return body;
+}
+
+std::vector<std::string> make_literals(std::size_t count) {
+  std::vector<std::string> literals;
+  literals.reserve(count);
+  for (std::size_t index{}; index < count; ++index) {
+    literals.push_back("error template " + std::to_string(index) + " not found");
+  }
+  return literals;
+}
+
+std::vector<std::string> make_patterns(std::size_t count) {
+  std::vector<std::string> patterns;
+  patterns.reserve(count);
+  for (std::size_t index{}; index < count; ++index) {
+    patterns.push_back("error (code|template) " + std::to_string(index) + " [0-9]+ not found");
+  }
+  return patterns;
+}
+} // namespace
+
+TEST_CASE("ContentFilters literal scan", "[!benchmark]") {
+  const auto body = make_body(1024U * 1024U);
+
+  for (const std::size_t count : {1U, 10U, 100U}) {
+    const auto literals = make_literals(count);
+    const ContentFilters filters{{}, literals, {}, {}};
+    REQUIRE(filters.accepts(body));
+
+    BENCHMARK("aho-corasick, " + std::to_string(count) + " literals, 1 MiB") {
+      return filters.accepts(body);
+    };
+    BENCHMARK("per-literal contains, " + std::to_string(count) + " literals, 1 MiB") {
+      return std::ranges::none_of(literals,
+                                  [&body](const auto& literal) { return body.contains(literal); });
+    };
+  }
+}
+
+TEST_CASE("ContentFilters regex scan", "[!benchmark]") {
+  const auto body = make_body(1024U * 1024U);
+
+  for (const std::size_t count : {1U, 10U, 100U}) {
+    const auto patterns = make_patterns(count);
+    const ContentFilters filters{{}, {}, {}, patterns};
+    std::vector<boost::regex> regexes;
+    std::ranges::transform(patterns, std::back_inserter(regexes),
+                           [](const auto& pattern) { return boost::regex{pattern}; });
+    REQUIRE(filters.accepts(body));
+
+    BENCHMARK("combined dfa, " + std::to_string(count) + " patterns, 1 MiB") {
+      return filters.accepts(body);
+    };
+    BENCHMARK("per-pattern boost::regex, " + std::to_string(count) + " patterns, 1 MiB") {
+      return std::ranges::none_of(
+          regexes, [&body](const auto& regex) { return boost::regex_search(body, regex); });
+    };
+  }
+}
@@ -5,6 +5,7 @@ from __future__ import annotations
 import argparse
 import contextlib
 import http.server
+import json
 import os
 import select
 import shutil
@@ -15,6 +16,7 @@ import subprocess
 import tempfile
 import threading
 import time
+import urllib.request
 from pathlib import Path
 
 
@@ -73,12 +75,53 @@ def generate_test_certificate(work_dir: Path, openssl: str) -> tuple[Path, Path]
   return cert_file, key_file
 
 
+LARGE_BODY = b"0123456789abcdef" * (12 * 1024 * 1024 // 16) + b"LARGE BODY END\n"
+SOFT_REAL_BODY = (
+  b"<html><body><h1>Regatta results</h1><p>Race 12 was won by the Example Canoe Club crew, "
+  b"followed closely by two junior boats. Full split times, weather notes, and the protest "
+  b"committee decision are listed below for every heat of the day.</p></body></html>\n"
+)
+
+
+# Every /soft/ path answers 200, like an app that renders its own not-found page; only /soft/2 exists.
+def soft_route(path: str) -> bytes:
+  if path == "/soft/2":
+    return SOFT_REAL_BODY
+  return f"<html><body>Sorry, {path} was not found.</body></html>\n".encode()
+
+
+# Template pages that differ only in the echoed path, like a catalog rendered from one layout.
+def catalog_route(path: str) -> bytes:
+  return (
+    f"<html><body><h1>Catalog entry {path}</h1><p>Every entry in the spring catalog ships within "
+    "two business days from the regional warehouse. Returns are accepted for thirty days with "
+    "the original receipt, and gift wrapping is available at checkout.</p></body></html>\n"
+  ).encode()
+
+
 class FixtureHandler(http.server.BaseHTTPRequestHandler):
+  protocol_version = "HTTP/1.1"
+
   def do_HEAD(self) -> None:
-    if self.path in {"/found", "/secure", "/real-result", "/shell"}:
+    if self.path.startswith("/soft/"):
+      self.send_response(200)
+      self.send_header("Content-Type", "text/html")
+      self.send_header("Content-Length", str(len(soft_route(self.path))))
+      self.end_headers()
+    elif self.path in {"/found", "/secure", "/real-result", "/shell"}:
       self.send_response(200)
       self.send_header("Content-Length", "0")
       self.end_headers()
+    elif self.path == "/no-head":
+      self.send_response(405)
+      self.send_header("Allow", "GET")
+      self.send_header("Content-Length", "0")
+      self.end_headers()
+    elif self.path == "/large":
+      self.send_response(200)
+      self.send_header("Content-Type", "application/octet-stream")
+      self.send_header("Content-Length", str(len(LARGE_BODY)))
+      self.end_headers()
     else:
       self.send_response(404)
       self.send_header("Content-Length", "0")
@@ -119,7 +162,18 @@ class FixtureHandler(http.server.BaseHTTPRequestHandler):
       "/real-result": (200, b"HCRA RESULTS\nRace 12\nCrew: Example Canoe Club\n"),
       "/slow": (200, b"SLOW BODY\n"),
       "/secure": (200, b"SECURE BODY\n"),
+      "/no-head": (200, b"NO HEAD BODY\n"),
     }
+    if self.path == "/large":
+      routes["/large"] = (200, LARGE_BODY)
+    if self.path == "/rejected-large":
+      routes["/rejected-large"] = (200, b"ERROR MARKER\n" + LARGE_BODY)
+    if self.path == "/missing-large":
+      routes["/missing-large"] = (404, LARGE_BODY)
+    if self.path.startswith("/soft/"):
+      routes[self.path] = (200, soft_route(self.path))
+    if self.path.startswith("/catalog/"):
+      routes[self.path] = (200, catalog_route(self.path))
     status, body = routes.get(self.path, (404, b"missing\n"))
     self.send_response(status)
     self.send_header("Content-Type", "text/plain")
@@ -311,10 +365,34 @@ def test_stdin_head_filters_missing(exe: Path, tmp: Path, server: FixtureServer)
   require(not err.exists() or read_text(err) == "", "stdin HEAD should not write errors for 404 responses")
 
 
+def test_head_falls_back_to_ranged_get(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out = tmp / "head-fallback.txt"
+  err = tmp / "head-fallback.err"
+  result = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "--stdin", "--out", str(out), "--err", str(err)],
+    stdin="/no-head\n/found\n/missing\n",
+  )
+  require(sorted(read_text(out).splitlines()) == ["/found", "/no-head"], "HEAD fallback should find HEAD-rejecting resources")
+  require("falling back to GET" in result.stdout, "HEAD fallback should announce the switch")
+  require("head-fallback-rate=" in result.stdout, "HEAD fallback rate should be reported")
+  disabled = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/no-head", "--head-fallback", "off", "--out", str(tmp / "no-fallback.txt"), "--err", str(err)],
+  )
+  require(read_text(tmp / "no-fallback.txt") == "", "disabled HEAD fallback should keep HEAD misses")
+  require("head-fallbacks=" not in disabled.stdout, "disabled HEAD fallback should send no GETs")
+
+
 def test_get_contents(exe: Path, tmp: Path, server: FixtureServer) -> None:
   out_dir = tmp / "contents"
   err = tmp / "contents.err"
-  run_abrade(exe, tmp, [server.authority, "/found", "--contents", "--out", str(out_dir), "--err", str(err)])
+  result = run_abrade(exe, tmp, [server.authority, "/found", "--contents", "--out", str(out_dir), "--err", str(err)])
+  require("[ ] Status codes: 200=1\n" in result.stdout, "summary should count each status code")
+  for phase in ("dns", "connect", "write", "ttfb", "body"):
+    require(f"[ ] Latency {phase}: n=1 p50=" in result.stdout, f"summary should report {phase} latency percentiles")
   output = out_dir / "_found"
   require(output.exists(), "GET contents should write a file for 2xx responses")
   output_text = read_text(output)
@@ -323,6 +401,129 @@ def test_get_contents(exe: Path, tmp: Path, server: FixtureServer) -> None:
   require("Content-Type" not in output_text, "GET contents file should not contain response headers")
 
 
+def test_get_streams_large_body(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "large"
+  err = tmp / "large.err"
+  result = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/large", "--contents", "--require", "LARGE BODY END", "--out", str(out_dir), "--err", str(err)],
+  )
+  output = out_dir / "_large"
+  require(output.exists(), "GET contents should stream bodies beyond the default in-memory limit")
+  require(output.stat().st_size == len(LARGE_BODY), "streamed GET body should be written completely")
+  require("worker-utilization=" in result.stdout, "GET summary should report body worker metrics")
+  require(not (out_dir / "_large.part").exists(), "committed GET body should not leave a spool file")
+
+
+def test_error_bodies_drain_or_close(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "error-bodies"
+  err = tmp / "error-bodies.err"
+  drained = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/missing-large", "--contents", "--error-bodies", "drain", "--out", str(out_dir), "--err", str(err)],
+  )
+  require("bodies-skipped=0" in drained.stdout, "drain mode should read non-2xx bodies")
+  require("worker-jobs=0 " in drained.stdout, "drained bodies should not reach the body workers")
+  closed = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/missing-large", "--contents", "--out", str(out_dir), "--err", str(err)],
+  )
+  require("bodies-skipped=1" in closed.stdout, "default GET mode should abandon non-2xx bodies")
+  require("bytes-avoided=0 " not in closed.stdout, "close mode should report avoided body bytes")
+  require(not any(out_dir.iterdir()), "non-2xx bodies should never be written")
+
+
+def test_reject_aborts_large_body(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "rejected-large"
+  err = tmp / "rejected-large.err"
+  result = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/rejected-large", "--contents", "--reject", "ERROR MARKER", "--out", str(out_dir), "--err", str(err)],
+  )
+  require("filtered=1" in result.stdout, "an early reject should still count as filtered")
+  require("bodies-aborted=1" in result.stdout, "an early reject should abandon the transfer")
+  require("bytes-avoided=0 " not in result.stdout, "an early reject should report avoided body bytes")
+  require(not any(out_dir.iterdir()), "rejected bodies should never be written")
+
+
+def test_header_filters_skip_bodies(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out = tmp / "header-filtered.txt"
+  err = tmp / "header-filtered.err"
+  head = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "--stdin", "--max-length", "4096", "--out", str(out), "--err", str(err)],
+    stdin="/found\n/large\n",
+  )
+  require(read_text(out).splitlines() == ["/found"], "HEAD should omit responses outside the length range")
+  require("header-filtered=1" in head.stdout, "HEAD summary should count header-filtered responses")
+  out_dir = tmp / "header-filtered"
+  get = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/large", "--contents", "--content-type", "text/html", "--out", str(out_dir), "--err", str(err)],
+  )
+  require("header-filtered=1" in get.stdout, "GET summary should count header-filtered responses")
+  require("bodies-skipped=1" in get.stdout, "GET should not read bodies rejected by header filters")
+  require(not any(out_dir.iterdir()), "header-filtered bodies should never be written")
+
+
+def test_probe_promotes_hits_to_get(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "probed"
+  err = tmp / "probed.err"
+  result = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "--stdin", "--probe", "--max-length", "4096", "--out", str(out_dir), "--err", str(err)],
+    stdin="/found\n/missing\n/large\n",
+  )
+  require(read_text(out_dir / "_found") == "FOUND BODY\n", "probe mode should GET 2xx hits")
+  require(sorted(path.name for path in out_dir.iterdir()) == ["_found"], "probe mode should not GET misses")
+  require("probes=3 promoted=1" in result.stdout, "probe summary should count probes and promotions")
+  require("header-filtered=1" in result.stdout, "probe mode should apply header filters to HEAD responses")
+  require("2xx=2 non-2xx=1" in result.stdout, "probe summary should count each candidate once")
+  require(not err.exists() or read_text(err) == "", "probe mode should not write errors")
+
+
+def test_soft404_drops_calibrated_lookalikes(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out = tmp / "soft404.txt"
+  err = tmp / "soft404.err"
+  head = run_abrade(exe, tmp, [server.authority, "/soft/{1:3}", "--soft404", "--out", str(out), "--err", str(err)])
+  require("3 of 3 random candidates answered 2xx" in head.stdout, "calibration should learn soft 404s")
+  require(read_text(out).splitlines() == ["/soft/2"], "HEAD soft 404s should not be recorded")
+  require("soft-404=2" in head.stdout, "HEAD summary should count soft 404s")
+  out_dir = tmp / "soft404"
+  get = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/soft/{1:3}", "--contents", "--soft404", "--out", str(out_dir), "--err", str(err)],
+  )
+  require(sorted(path.name for path in out_dir.iterdir()) == ["_soft_2"], "GET soft 404 bodies should not be written")
+  require(read_text(out_dir / "_soft_2") == SOFT_REAL_BODY.decode(), "the real page should be written")
+  require("soft-404=2" in get.stdout, "GET summary should count soft 404s")
+  require("attempted=3 " in get.stdout, "calibration requests should not count toward the scan")
+  require(not err.exists() or read_text(err) == "", "soft-404 detection should not write errors")
+
+
+def test_cluster_keeps_exemplars_of_near_duplicates(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "clustered"
+  err = tmp / "clustered.err"
+  result = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/catalog/{1:4}", "--contents", "--cluster", "1", "--out", str(out_dir), "--err", str(err)],
+  )
+  require(sorted(path.name for path in out_dir.iterdir()) == ["_catalog_1"], "only the cluster exemplar should be written")
+  index = read_text(tmp / "clustered.clusters.tsv").splitlines()
+  require(index[0] == "0\tkept\t/catalog/1", "the index should list the kept exemplar")
+  require(sorted(index[1:]) == [f"0\tduplicate\t/catalog/{n}" for n in (2, 3, 4)], "the index should list duplicates")
+  require("near-duplicates=3" in result.stdout, "summary should count near duplicates")
+
+
 def test_screen_filters_contents(exe: Path, tmp: Path, server: FixtureServer) -> None:
   out_dir = tmp / "screened"
   err = tmp / "screened.err"
@@ -389,7 +590,7 @@ def test_error_log_records_transport_failure(exe: Path, tmp: Path, server: Fixtu
 def test_timeout_records_error(exe: Path, tmp: Path, server: FixtureServer) -> None:
   out_dir = tmp / "timeout"
   err = tmp / "timeout.err"
-  run_abrade(
+  result = run_abrade(
     exe,
     tmp,
     [server.authority, "/slow", "--contents", "--out", str(out_dir), "--err", str(err)],
@@ -400,6 +601,152 @@ def test_timeout_records_error(exe: Path, tmp: Path, server: FixtureServer) -> N
   err_text = read_text(err)
   require("/slow" in err_text, "timeout should identify the candidate URI")
   require("timeout" in err_text, "timeout should identify the timeout failure")
+  require("[ ] Error causes: get query (timeout)=1" in result.stdout, "summary should group errors by cause")
+
+
+def test_progress_lines_while_waiting(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "progress"
+  err = tmp / "progress.err"
+  result = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/slow", "--contents", "--progress", "100", "--out", str(out_dir), "--err", str(err)],
+  )
+  lines = [line for line in result.stdout.splitlines() if line.startswith("[ ] Progress: ")]
+  require(len(lines) >= 3, "a slow run should print periodic progress lines")
+  require("\r" not in result.stdout, "progress should not redraw in place when stdout is not a terminal")
+  require("in-flight=1 [ttfb=1] hits=0 errors=0.0%" in lines[0], "progress should report the in-flight candidate and its state")
+  require("0.0% ETA --:--:--" in lines[0], "progress should report completion of the known cardinality")
+
+
+def test_calibrate_sweeps_concurrency(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out = tmp / "calibrate.txt"
+  err = tmp / "calibrate.err"
+  result = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "--stdin", "--calibrate-only", "--max", "16", "--out", str(out), "--err", str(err)],
+    stdin="/found\n" * 80,
+  )
+  steps = [line for line in result.stdout.splitlines() if line.startswith("[ ] Calibration: ")]
+  require(len(steps) == 2, "calibration should sweep 8 and 16 coroutines before running out of candidates")
+  require(steps[0].startswith("[ ] Calibration: 8 coros: ") and "0.0% errors" in steps[0], "calibration should report each level")
+  require(steps[1].endswith(" ms (30 candidates)"), "the last step should take the remaining candidates")
+  require("[ ] Calibrated concurrency: --init " in result.stdout, "calibration should recommend concurrency bounds")
+  require(len(read_text(out).splitlines()) == 80, "calibration candidates should be scanned like any other")
+
+
+def test_metrics_endpoint_serves_openmetrics(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "metrics"
+  err = tmp / "metrics.err"
+  with socket.socket() as probe:
+    probe.bind(("127.0.0.1", 0))
+    port = probe.getsockname()[1]
+  results: list[subprocess.CompletedProcess[str]] = []
+  run = threading.Thread(
+    target=lambda: results.append(
+      run_abrade(
+        exe,
+        tmp,
+        [server.authority, "/slow", "--contents", "--metrics-listen", f"127.0.0.1:{port}", "--out", str(out_dir), "--err", str(err)],
+      )
+    )
+  )
+  run.start()
+  scraped = ""
+  content_type = ""
+  deadline = time.monotonic() + 5
+  while not scraped and time.monotonic() < deadline:
+    try:
+      with urllib.request.urlopen(f"http://127.0.0.1:{port}/metrics", timeout=2) as response:
+        content_type = response.headers["Content-Type"]
+        scraped = response.read().decode("utf-8")
+    except OSError:
+      time.sleep(0.05)
+  run.join(timeout=30)
+  require(len(results) == 1, "abrade should finish after serving metrics")
+  require(content_type.startswith("application/openmetrics-text"), "metrics should use the OpenMetrics content type")
+  require("\nabrade_in_flight 1\n" in scraped, "metrics should report the in-flight candidate")
+  require("\nabrade_coroutines_waiting{state=\"ttfb\"} 1\n" in scraped, "metrics should report the coroutine state census")
+  require("abrade_phase_latency_seconds_bucket{phase=\"connect\",le=\"+Inf\"} 1\n" in scraped, "metrics should export phase histograms")
+  require(scraped.endswith("# EOF\n"), "metrics should end with the OpenMetrics terminator")
+  require(f"Serving metrics at http://127.0.0.1:{port}/metrics" in results[0].stdout, "abrade should announce the endpoint")
+
+
+def test_run_report_json(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "report"
+  err = tmp / "report.err"
+  report_path = tmp / "report.json"
+  result = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/found", "--contents", "--report", str(report_path), "--out", str(out_dir), "--err", str(err)],
+  )
+  require(f"[ ] Run report written to {report_path}" in result.stdout, "abrade should announce the report")
+  report = json.loads(read_text(report_path))
+  require(report["report_version"] == 1, "report should carry its format version")
+  require(report["cardinality"] == 1 and report["log_cardinality"] is None, "report should carry the cardinality")
+  require(report["config"]["host"] == server.authority, "report should carry the configuration")
+  require(report["config"]["contents"] is True, "report should carry the request mode")
+  require(report["counters"]["requests"] == 1 and report["counters"]["hits"] == 1, "report should carry counters")
+  require(report["status_codes"] == {"200": 1}, "report should count each status code")
+  require(report["errors_by_cause"] == [], "a clean run should report no error causes")
+  require(report["latency_ms"]["ttfb"]["count"] == 1, "report should carry phase latency percentiles")
+  require(report["latency_ms"]["socks"]["count"] == 0, "unused phases should report zero samples")
+  require(report["controller"]["recommended_coroutines"] == 1, "report should carry the controller state")
+  require(isinstance(report["controller"]["samples"], list), "report should carry the controller samples")
+  require(set(report["resources"]) == {"peak_rss_bytes", "rss_bytes", "user_cpu_seconds", "system_cpu_seconds", "open_fds"}, "report should carry resource usage")
+
+
+def test_trace_records_request_spans(exe: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "trace"
+  err = tmp / "trace.err"
+  trace_path = tmp / "trace.json"
+  result = run_abrade(
+    exe,
+    tmp,
+    [server.authority, "/found", "--contents", "--trace", str(trace_path), "--trace-sample", "1", "--out", str(out_dir), "--err", str(err)],
+  )
+  require(f"[ ] Trace written to {trace_path}: 1 candidates" in result.stdout, "abrade should announce the trace")
+  trace = json.loads(read_text(trace_path))
+  spans = [event for event in trace["traceEvents"] if event["ph"] == "X"]
+  names = [span["name"] for span in spans]
+  for name in ("dns", "connect", "write", "ttfb", "body", "filter", "write-out", "candidate"):
+    require(name in names, f"trace should include a {name} span")
+  require(len({span["tid"] for span in spans}) == 1, "one candidate's spans should share a lane")
+  candidate = next(span for span in spans if span["name"] == "candidate")
+  require(candidate["args"]["candidate"] == "/found", "the candidate span should name its candidate")
+  require(all(candidate["ts"] <= span["ts"] and span["ts"] + span["dur"] <= candidate["ts"] + candidate["dur"] for span in spans), "request spans should nest inside the candidate span")
+  require(any(event["ph"] == "C" and event["name"] == "coroutines" for event in trace["traceEvents"]), "trace should record concurrency")
+
+
+def test_top_shows_shared_memory_stats(exe: Path, top: Path, tmp: Path, server: FixtureServer) -> None:
+  out_dir = tmp / "top"
+  err = tmp / "top.err"
+  results: list[subprocess.CompletedProcess[str]] = []
+  run = threading.Thread(
+    target=lambda: results.append(
+      run_abrade(exe, tmp, [server.authority, "/slow", "--contents", "--shm-stats", "--out", str(out_dir), "--err", str(err)])
+    )
+  )
+  run.start()
+  table = ""
+  deadline = time.monotonic() + 5
+  while server.authority not in table and time.monotonic() < deadline:
+    shown = subprocess.run([str(top), "--once"], text=True, stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=10, check=False)
+    table = shown.stdout
+    time.sleep(0.05)
+  run.join(timeout=30)
+  require(len(results) == 1, "abrade should finish while publishing stats")
+  require(table.startswith("PID "), "abrade_top should print a table header")
+  row = next((line for line in table.splitlines() if server.authority in line), "")
+  require("/slow" in row, "abrade_top should show the running scan's pattern")
+  published = [line for line in results[0].stdout.splitlines() if line.startswith("[ ] Publishing stats to shared memory /abrade.")]
+  require(len(published) == 1, "abrade should announce its stats segment")
+  pid = published[0].rsplit(".", 1)[1]
+  require(row.split()[0] == pid, "abrade_top should show the scan's pid")
+  gone = subprocess.run([str(top), "--once", pid], text=True, stdout=subprocess.PIPE, stderr=subprocess.PIPE, timeout=10, check=False)
+  require(gone.returncode == 1, "the stats segment should be removed when abrade exits")
 
 
 def test_socks_proxy_head(exe: Path, tmp: Path, server: FixtureServer) -> None:
@@ -554,6 +901,7 @@ def main() -> None:
   parser = argparse.ArgumentParser()
   parser.add_argument("abrade", type=Path)
   parser.add_argument("--openssl")
+  parser.add_argument("--top", type=Path)
   args = parser.parse_args()
 
   exe = args.abrade.resolve()
@@ -566,12 +914,27 @@ def main() -> None:
     with FixtureServer(tls=False, work_dir=tmp) as server:
       test_head_found(exe, tmp, server)
       test_stdin_head_filters_missing(exe, tmp, server)
+      test_head_falls_back_to_ranged_get(exe, tmp, server)
       test_get_contents(exe, tmp, server)
+      test_get_streams_large_body(exe, tmp, server)
+      test_error_bodies_drain_or_close(exe, tmp, server)
+      test_reject_aborts_large_body(exe, tmp, server)
+      test_header_filters_skip_bodies(exe, tmp, server)
+      test_probe_promotes_hits_to_get(exe, tmp, server)
+      test_soft404_drops_calibrated_lookalikes(exe, tmp, server)
+      test_cluster_keeps_exemplars_of_near_duplicates(exe, tmp, server)
       test_screen_filters_contents(exe, tmp, server)
       test_body_filters_distinguish_shell_200_pages(exe, tmp, server)
       test_filter_option_errors_return_2(exe, tmp, server)
       test_error_log_records_transport_failure(exe, tmp, server)
       test_timeout_records_error(exe, tmp, server)
+      test_progress_lines_while_waiting(exe, tmp, server)
+      test_calibrate_sweeps_concurrency(exe, tmp, server)
+      test_metrics_endpoint_serves_openmetrics(exe, tmp, server)
+      test_run_report_json(exe, tmp, server)
+      test_trace_records_request_spans(exe, tmp, server)
+      if args.top:
+        test_top_shows_shared_memory_stats(exe, args.top.resolve(), tmp, server)
       test_socks_proxy_head(exe, tmp, server)
       test_socks_proxy_get_contents(exe, tmp, server)
       test_relative_redirect_follow(exe, tmp, server)
@@ -1,11 +1,19 @@
 #include <abrade/action.hpp>
 #include <abrade/content_filter.hpp>
+#include <abrade/exception.hpp>
+#include <abrade/header_filter.hpp>
+#include <abrade/near_duplicates.hpp>
 #include <abrade/run_stats.hpp>
+#include <abrade/soft_not_found.hpp>
+#include <boost/beast/http/field.hpp>
+#include <boost/beast/http/fields.hpp>
 #include <boost/filesystem.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
 #include <fstream>
 #include <iterator>
 #include <string>
+#include <string_view>
 #include <utility>
 
 using namespace abrade;
@@ -35,27 +43,120 @@ std::string read_file(const boost::filesystem::path& path) {
   std::ifstream file{path.string()};
   return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
 }
+
+boost::beast::http::fields header(const char* content_type, const char* length) {
+  boost::beast::http::fields fields;
+  fields.set(boost::beast::http::field::content_type, content_type);
+  fields.set(boost::beast::http::field::content_length, length);
+  return fields;
+}
 } // namespace
 
+TEST_CASE("HeaderFilters") {
+  SECTION("accepts everything when unconfigured") {
+    const HeaderFilters filters;
+
+    REQUIRE(filters.empty());
+    REQUIRE(filters.accepts(boost::beast::http::fields{}));
+  }
+
+  SECTION("matches media types case-insensitively and by type wildcard") {
+    const HeaderFilters filters{{"Text/HTML", "application/*"}, 0, HeaderFilters::unbounded_length,
+                                {}, {}};
+
+    REQUIRE(filters.accepts(header("text/html; charset=UTF-8", "10")));
+    REQUIRE(filters.accepts(header("application/json", "10")));
+    REQUIRE_FALSE(filters.accepts(header("text/plain", "10")));
+    REQUIRE_FALSE(filters.accepts(boost::beast::http::fields{}));
+  }
+
+  SECTION("applies an inclusive length range to declared lengths only") {
+    const HeaderFilters filters{{}, 100, 200, {}, {}};
+
+    REQUIRE(filters.accepts(header("text/html", "100")));
+    REQUIRE(filters.accepts(header("text/html", "200")));
+    REQUIRE_FALSE(filters.accepts(header("text/html", "99")));
+    REQUIRE_FALSE(filters.accepts(header("text/html", "201")));
+    REQUIRE(filters.accepts(header("text/html", "lots")));
+    REQUIRE(filters.accepts(boost::beast::http::fields{}));
+    REQUIRE(filters.exceeds_length(201));
+    REQUIRE_FALSE(filters.length_accepts(99));
+  }
+
+  SECTION("takes a partial response's length from its Content-Range") {
+    const HeaderFilters filters{{}, 100, 200, {}, {}};
+    auto fields = header("text/html", "1");
+
+    fields.set(boost::beast::http::field::content_range, "bytes 0-0/150");
+    REQUIRE(filters.accepts(fields));
+    fields.set(boost::beast::http::field::content_range, "bytes 0-0/5000");
+    REQUIRE_FALSE(filters.accepts(fields));
+    fields.set(boost::beast::http::field::content_range, "bytes 0-0/*");
+    REQUIRE(filters.accepts(fields));
+  }
+
+  SECTION("searches header lines for required and rejected regexes") {
+    const HeaderFilters filters{{}, 0, HeaderFilters::unbounded_length, {"^Server: nginx"},
+                                {"^Set-Cookie: .*soft404"}};
+    auto fields = header("text/html", "10");
+    fields.set(boost::beast::http::field::server, "nginx/1.25");
+
+    REQUIRE(filters.accepts(fields));
+    fields.set(boost::beast::http::field::set_cookie, "state=soft404");
+    REQUIRE_FALSE(filters.accepts(fields));
+    REQUIRE_FALSE(filters.accepts(header("text/html", "10")));
+  }
+}
+
 TEST_CASE("HeadAction") {
   SECTION("appends only successful candidates to the output file") {
     const ScopedTempDir temp;
     const auto output_path = temp.path / "found.txt";
     HeadAction action{output_path.string(), false};
+    const boost::beast::http::fields fields;
 
-    action.process(200, "/ok");
-    action.process(204, "/created");
-    action.process(404, "/missing");
+    REQUIRE(action.process(200, fields, "/ok") == Discovery::found);
+    REQUIRE(action.process(204, fields, "/created") == Discovery::found);
+    REQUIRE(action.process(404, fields, "/missing") == Discovery::miss);
 
     REQUIRE(read_file(output_path) == "/ok\n/created\n");
   }
+
+  SECTION("omits successful candidates rejected by header filters") {
+    const ScopedTempDir temp;
+    const auto output_path = temp.path / "found.txt";
+    HeadAction action{output_path.string(), false, HeaderFilters{{"text/html"}, 1, 1000, {}, {}}};
+
+    REQUIRE(action.process(200, header("text/html", "512"), "/page") == Discovery::found);
+    REQUIRE(action.process(200, header("text/html", "0"), "/empty") ==
+            Discovery::header_filtered);
+    REQUIRE(action.process(200, header("image/png", "512"), "/image") ==
+            Discovery::header_filtered);
+
+    REQUIRE(read_file(output_path) == "/page\n");
+  }
+
+  SECTION("learns soft 404s while calibrating and omits look-alikes afterwards") {
+    const ScopedTempDir temp;
+    const auto output_path = temp.path / "found.txt";
+    SoftNotFound soft_not_found;
+    HeadAction action{output_path.string(), false, HeaderFilters{}, &soft_not_found};
+
+    REQUIRE(action.process(200, header("text/html", "1200"), "/calibration") == Discovery::miss);
+    soft_not_found.finish_calibration();
+    REQUIRE(action.process(200, header("text/html", "1210"), "/missing") ==
+            Discovery::soft_not_found);
+    REQUIRE(action.process(200, header("text/html", "9000"), "/real") == Discovery::found);
+
+    REQUIRE(read_file(output_path) == "/real\n");
+  }
 }
 
 TEST_CASE("GetAction") {
   SECTION("writes successful response bodies to sanitized candidate paths") {
     const ScopedTempDir temp;
     RunStats stats;
-    GetAction action{temp.path.string(), ContentFilters{}, false, stats};
+    GetAction action{temp.path.string(), ContentFilters{}, stats};
 
     action.process(200, std::string{"payload"}, "/items/1?format=json");
     action.process(404, std::string{"missing"}, "/items/2");
@@ -69,7 +170,7 @@ TEST_CASE("GetAction") {
     const ScopedTempDir temp;
     RunStats stats;
     ContentFilters filters{{"clean"}, {"blocked-marker"}, {}, {}};
-    GetAction action{temp.path.string(), std::move(filters), false, stats};
+    GetAction action{temp.path.string(), std::move(filters), stats};
 
     action.process(200, std::string{"clean payload"}, "/clean");
     action.process(200, std::string{"wrong payload"}, "/missing-required");
@@ -86,7 +187,7 @@ TEST_CASE("GetAction") {
     const ScopedTempDir temp;
     RunStats stats;
     ContentFilters filters{{}, {}, {"HCRA\\s+Race", "Division:\\s+Open"}, {"cancelled|postponed"}};
-    GetAction action{temp.path.string(), std::move(filters), false, stats};
+    GetAction action{temp.path.string(), std::move(filters), stats};
 
     action.process(200, std::string{"HCRA Race\nDivision: Open\n"}, "/accepted");
     action.process(200, std::string{"HCRA Race\nDivision: Novice\n"}, "/missing-regex");
@@ -97,4 +198,176 @@ TEST_CASE("GetAction") {
     REQUIRE_FALSE(boost::filesystem::exists(temp.path / "_rejected"));
     REQUIRE(stats.filtered() == 2);
   }
+
+  SECTION("applies streamed filters to matches that straddle chunk boundaries") {
+    const ScopedTempDir temp;
+    RunStats stats;
+    ContentFilters filters{{"needle"}, {}, {"HCRA\\s+Race"}, {}};
+    GetAction action{temp.path.string(), std::move(filters), stats};
+
+    {
+      auto response = action.open(200, "/chunked");
+      REQUIRE(response.write("hay nee"));
+      REQUIRE(response.write("dle HCRA "));
+      REQUIRE(response.write("  Race tail"));
+      response.commit();
+    }
+
+    REQUIRE(read_file(temp.path / "_chunked") == "hay needle HCRA   Race tail");
+    REQUIRE_FALSE(boost::filesystem::exists(temp.path / "_chunked.part"));
+    REQUIRE(stats.bytes_written() == 27);
+  }
+
+  SECTION("removes spool files for rejected and abandoned bodies") {
+    const ScopedTempDir temp;
+    RunStats stats;
+    ContentFilters filters{{}, {"not found"}, {}, {}};
+    GetAction action{temp.path.string(), std::move(filters), stats};
+
+    {
+      auto response = action.open(200, "/rejected");
+      REQUIRE(response.write("page not "));
+      REQUIRE_FALSE(response.write("found here"));
+      response.commit();
+    }
+    {
+      auto response = action.open(200, "/abandoned");
+      REQUIRE(response.write("partial"));
+    }
+
+    REQUIRE(boost::filesystem::is_empty(temp.path));
+    REQUIRE(stats.filtered() == 1);
+    REQUIRE(stats.bytes_written() == 0);
+  }
+
+  SECTION("applies the length range to bodies that did not declare one") {
+    const ScopedTempDir temp;
+    RunStats stats;
+    GetAction action{temp.path.string(), ContentFilters{}, stats,
+                     HeaderFilters{{"text/html"}, 4, 8, {}, {}}};
+
+    REQUIRE(action.admits(header("text/html", "6")));
+    REQUIRE_FALSE(action.admits(header("text/plain", "6")));
+    {
+      auto response = action.open(200, "/oversized");
+      REQUIRE(response.write("12345"));
+      REQUIRE_FALSE(response.write("6789"));
+      response.commit();
+    }
+    action.process(200, std::string{"abc"}, "/short");
+    action.process(200, std::string{"abcdef"}, "/fits");
+
+    REQUIRE(read_file(temp.path / "_fits") == "abcdef");
+    REQUIRE_FALSE(boost::filesystem::exists(temp.path / "_oversized"));
+    REQUIRE_FALSE(boost::filesystem::exists(temp.path / "_short"));
+    REQUIRE(stats.filtered() == 2);
+  }
+
+  SECTION("drops bodies that match a soft 404 learned during calibration") {
+    const ScopedTempDir temp;
+    RunStats stats;
+    SoftNotFound soft_not_found;
+    GetAction action{temp.path.string(), ContentFilters{}, stats, HeaderFilters{},
+                     &soft_not_found};
+    const auto fields = header("text/html", "0");
+    const auto stream = [&action, &fields](std::string_view candidate, std::string_view body) {
+      auto response = action.open(200, fields, candidate);
+      REQUIRE(response.write(body));
+      response.commit();
+      return response.soft_not_found();
+    };
+
+    REQUIRE(stream("/calibration", "Sorry, the page /calibration was not found on this server."));
+    soft_not_found.finish_calibration();
+    REQUIRE(stream("/missing", "Sorry, the page /missing was not found on this server."));
+    REQUIRE_FALSE(stream("/real", "Quarterly results: revenue grew in every region we serve."));
+
+    REQUIRE(soft_not_found.size() == 1);
+    REQUIRE(read_file(temp.path / "_real") ==
+            "Quarterly results: revenue grew in every region we serve.");
+    REQUIRE_FALSE(boost::filesystem::exists(temp.path / "_calibration"));
+    REQUIRE_FALSE(boost::filesystem::exists(temp.path / "_missing"));
+    REQUIRE(stats.soft_not_found() == 1);
+    REQUIRE(stats.filtered() == 0);
+  }
+
+  SECTION("keeps only the first bodies of each near-duplicate cluster") {
+    const ScopedTempDir temp;
+    const auto index_path = temp.path / "clusters.tsv";
+    RunStats stats;
+    NearDuplicates near_duplicates{1, index_path.string()};
+    GetAction action{(temp.path / "out").string(), ContentFilters{}, stats,
+                     HeaderFilters{}, nullptr, &near_duplicates};
+
+    action.process(200, std::string{"Item 1 of the spring catalog, ships in two days."}, "/a");
+    action.process(200, std::string{"Item 2 of the spring catalog, ships in two days."}, "/b");
+    action.process(200, std::string{"Quarterly results: revenue grew in every region."}, "/c");
+
+    REQUIRE(boost::filesystem::exists(temp.path / "out" / "_a"));
+    REQUIRE_FALSE(boost::filesystem::exists(temp.path / "out" / "_b"));
+    REQUIRE(boost::filesystem::exists(temp.path / "out" / "_c"));
+    REQUIRE(stats.near_duplicates() == 1);
+    near_duplicates.flush();
+    REQUIRE(read_file(index_path) == "0\tkept\t/a\n0\tduplicate\t/b\n1\tkept\t/c\n");
+  }
+
+  SECTION("keeps a cluster's exemplar slot when its body cannot be moved into place") {
+    const ScopedTempDir temp;
+    const auto index_path = temp.path / "clusters.tsv";
+    RunStats stats;
+    NearDuplicates near_duplicates{1, index_path.string()};
+    GetAction action{(temp.path / "out").string(), ContentFilters{}, stats,
+                     HeaderFilters{}, nullptr, &near_duplicates};
+    boost::filesystem::create_directories(temp.path / "out" / "_a" / "occupied");
+
+    REQUIRE_THROWS_AS(
+        action.process(200, std::string{"Item 1 of the spring catalog, ships in two days."}, "/a"),
+        AbradeException);
+    action.process(200, std::string{"Item 2 of the spring catalog, ships in two days."}, "/b");
+
+    REQUIRE(boost::filesystem::exists(temp.path / "out" / "_b"));
+    REQUIRE(stats.near_duplicates() == 0);
+    near_duplicates.flush();
+    REQUIRE(read_file(index_path) == "0\tkept\t/b\n");
+  }
+}
+
+TEST_CASE("NearDuplicates") {
+  const ScopedTempDir temp;
+  NearDuplicates near_duplicates{2, (temp.path / "clusters.tsv").string()};
+
+  SECTION("clusters signatures within the distance of a founder") {
+    const std::uint64_t founder{0x0123456789ABCDEFULL};
+    const auto six_bits_off = founder ^ 0x8000'2100'0040'0201ULL;
+    const auto seven_bits_off = six_bits_off ^ 0x0000'0000'0000'8000ULL;
+
+    REQUIRE(near_duplicates.assign(founder).cluster == 0);
+    REQUIRE(near_duplicates.assign(six_bits_off).cluster == 0);
+    REQUIRE(near_duplicates.assign(seven_bits_off).cluster == 1);
+    REQUIRE(near_duplicates.size() == 2);
+  }
+
+  SECTION("marks members beyond the exemplar limit as duplicates") {
+    REQUIRE(near_duplicates.assign(42).is_exemplar);
+    REQUIRE(near_duplicates.assign(42).is_exemplar);
+    REQUIRE_FALSE(near_duplicates.assign(43).is_exemplar);
+    REQUIRE(near_duplicates.assign(~std::uint64_t{42}).is_exemplar);
+  }
+
+  SECTION("reopens a released exemplar slot and lists only recorded members") {
+    const auto first = near_duplicates.assign(42);
+    const auto second = near_duplicates.assign(42);
+    near_duplicates.release(second);
+    const auto third = near_duplicates.assign(42);
+    const auto fourth = near_duplicates.assign(42);
+    near_duplicates.record(first, "/1");
+    near_duplicates.record(third, "/3");
+    near_duplicates.record(fourth, "/4");
+
+    REQUIRE(third.is_exemplar);
+    REQUIRE_FALSE(fourth.is_exemplar);
+    near_duplicates.flush();
+    REQUIRE(read_file(temp.path / "clusters.tsv") ==
+            "0\tkept\t/1\n0\tkept\t/3\n0\tduplicate\t/4\n");
+  }
 }
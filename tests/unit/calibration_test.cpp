@@ -0,0 +1,104 @@
+#include <abrade/calibration.hpp>
+#include <abrade/generator.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace abrade;
+
+namespace {
+/// A full step at `level` that reached `throughput` with `failed` of its candidates failing.
+CalibrationStep step(std::size_t level, double throughput, std::size_t failed = 0) {
+  CalibrationStep measured;
+  measured.concurrency = level;
+  measured.finished = CalibrationSweep::candidates(level);
+  measured.failed = failed;
+  measured.seconds = static_cast<double>(measured.finished) / throughput;
+  return measured;
+}
+} // namespace
+
+TEST_CASE("CalibrationSweep") {
+  SECTION("doubles until throughput stalls and recommends bounds around the knee") {
+    CalibrationSweep sweep{1, 1000};
+    const std::vector<double> throughputs{80.0, 160.0, 320.0, 400.0, 410.0, 405.0};
+    for (const auto throughput : throughputs) {
+      const auto level = sweep.next_level();
+      REQUIRE(level);
+      sweep.record(step(*level, throughput));
+    }
+    REQUIRE_FALSE(sweep.next_level());
+    REQUIRE(sweep.curve().size() == 6);
+    REQUIRE(sweep.curve().back().concurrency == 256);
+    REQUIRE(sweep.initial() == 64);
+    REQUIRE(sweep.minimum() == 16);
+    REQUIRE(sweep.maximum() == 256);
+  }
+
+  SECTION("stops at the first step over the error threshold and caps the maximum below it") {
+    CalibrationSweep sweep{1, 1000};
+    sweep.record(step(8, 80.0));
+    sweep.record(step(16, 160.0));
+    sweep.record(step(32, 170.0, 20));
+    REQUIRE_FALSE(sweep.next_level());
+    REQUIRE(sweep.initial() == 16);
+    REQUIRE(sweep.minimum() == 4);
+    REQUIRE(sweep.maximum() == 16);
+  }
+
+  SECTION("stays within the configured bounds") {
+    CalibrationSweep sweep{10, 20};
+    REQUIRE(sweep.next_level() == 10U);
+    sweep.record(step(10, 100.0));
+    REQUIRE(sweep.next_level() == 20U);
+    sweep.record(step(20, 200.0));
+    REQUIRE_FALSE(sweep.next_level());
+    REQUIRE(sweep.initial() == 20);
+    REQUIRE(sweep.minimum() == 10);
+    REQUIRE(sweep.maximum() == 20);
+  }
+
+  SECTION("stops when the candidates run out") {
+    CalibrationSweep sweep{1, 1000};
+    auto partial = step(8, 80.0);
+    partial.finished--;
+    sweep.record(partial);
+    REQUIRE_FALSE(sweep.next_level());
+    REQUIRE(sweep.initial() == 8);
+  }
+}
+
+TEST_CASE("CalibrationController") {
+  SECTION("holds its level and measures successes and failures") {
+    CalibrationController controller{12};
+    for (int completion{}; completion < 4; ++completion) {
+      if (completion != 0) {
+        controller.register_latency(std::chrono::milliseconds{20});
+      }
+      controller.register_completion(12);
+    }
+    const auto measured = controller.step();
+    REQUIRE(controller.recommended_coroutines() == 12);
+    REQUIRE(controller.samples().empty());
+    REQUIRE(measured.concurrency == 12);
+    REQUIRE(measured.finished == 4);
+    REQUIRE(measured.failed == 1);
+    REQUIRE(measured.error_rate() == 0.25);
+    REQUIRE(measured.latency.count() == 3);
+    REQUIRE(measured.describe().starts_with("[ ] Calibration: 12 coros: "));
+    REQUIRE(measured.describe().ends_with(" ms (4 candidates)"));
+  }
+}
+
+TEST_CASE("LimitedGenerator") {
+  SECTION("leaves candidates past the limit in the source") {
+    ListGenerator source{{"/a", "/b", "/c"}};
+    LimitedGenerator limited{source, 2};
+    REQUIRE(limited.next() == "/a");
+    REQUIRE(limited.next() == "/b");
+    REQUIRE_FALSE(limited.next());
+    REQUIRE(source.next() == "/c");
+  }
+}
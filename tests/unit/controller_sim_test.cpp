@@ -0,0 +1,84 @@
+#include <abrade/controller.hpp>
+#include <abrade/controller_sim.hpp>
+#include <abrade/run_stats.hpp>
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+
+using namespace abrade;
+
+namespace {
+const Scenario& scenario(std::string_view name) {
+  return *std::ranges::find(scenarios, name, &Scenario::name);
+}
+} // namespace
+
+TEST_CASE("ControllerSimulation") {
+  SimulationSettings settings;
+  settings.duration = std::chrono::seconds{20};
+
+  SECTION("serves a fixed concurrency below capacity at its Little's law rate") {
+    const ServerModel server{200, std::chrono::milliseconds{100}, std::chrono::milliseconds{0},
+                             0,   0.0,                            0.0};
+    RunStats stats;
+    FixedController controller{100, 1000};
+    ControllerSimulation simulation{server, settings};
+    const auto result = simulation.run(controller, stats);
+
+    REQUIRE(result.seconds.size() == 20);
+    REQUIRE(std::abs(result.throughput - 1000.0) < 1.0);
+    REQUIRE(result.ideal_throughput == 2000.0);
+    REQUIRE(std::abs(result.latency_ms - 100.0) < 0.001);
+    REQUIRE(result.concurrency == 100.0);
+    REQUIRE(result.oscillation == 0.0);
+    REQUIRE(result.convergence_seconds == 0.0);
+    REQUIRE(result.overload_episodes == 0);
+    REQUIRE(result.error_rate == 0.0);
+    REQUIRE(stats.candidates_finished() == stats.success_2xx());
+    REQUIRE_FALSE(controller.samples().empty());
+    REQUIRE(controller.samples().front().seconds == 1.0);
+  }
+
+  SECTION("refuses requests past the cliff and counts the overload") {
+    RunStats stats;
+    FixedController controller{1000, 1000};
+    ControllerSimulation simulation{scenario("cliff").server, settings};
+    const auto result = simulation.run(controller, stats);
+
+    REQUIRE(result.error_rate > 0.4);
+    REQUIRE(result.overload_episodes == 1);
+    REQUIRE(stats.errors() > 0);
+    REQUIRE(stats.timeouts() == 0);
+  }
+
+  SECTION("times out requests queued past the timeout") {
+    settings.timeout = std::chrono::seconds{5};
+    RunStats stats;
+    FixedController controller{1000, 1000};
+    ControllerSimulation simulation{scenario("slow").server, settings};
+    const auto result = simulation.run(controller, stats);
+
+    REQUIRE(stats.timeouts() > 0);
+    REQUIRE(result.throughput < 20.0);
+  }
+
+  SECTION("replays a seed exactly") {
+    const auto run = [&settings](std::uint64_t seed) {
+      settings.seed = seed;
+      RunStats stats;
+      GradientController controller{50, 10, 1000, 1, 1000};
+      ControllerSimulation simulation{scenario("noisy").server, settings};
+      return simulation.run(controller, stats);
+    };
+    const auto first = run(7);
+    const auto second = run(7);
+
+    REQUIRE(first.throughput == second.throughput);
+    REQUIRE(first.latency_ms == second.latency_ms);
+    REQUIRE(first.concurrency == second.concurrency);
+    REQUIRE(first.throughput != run(8).throughput);
+  }
+}
@@ -1,5 +1,15 @@
 #include <abrade/controller.hpp>
+#include <abrade/controller_timer.hpp>
+#include <abrade/exception.hpp>
+#include <abrade/run_stats.hpp>
+#include <algorithm>
+#include <boost/asio/io_context.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 using namespace abrade;
 
@@ -8,8 +18,53 @@ TEST_CASE("FixedController") {
     FixedController controller{7, 1};
 
     REQUIRE(controller.recommended_coroutines() == 7);
+    REQUIRE(controller.measured_velocity() == 0.0);
     controller.register_completion(3);
     REQUIRE(controller.recommended_coroutines() == 7);
+    REQUIRE(controller.measured_velocity() > 0.0);
+    REQUIRE(controller.samples().size() == 1);
+    REQUIRE(controller.samples().front().velocity == controller.measured_velocity());
+  }
+
+  SECTION("keeps recording samples without printing them once muted") {
+    FixedController controller{7, 1};
+    std::ostringstream printed;
+    auto* const output = std::cout.rdbuf(printed.rdbuf());
+
+    controller.register_completion(3);
+    controller.mute();
+    controller.register_completion(3);
+    std::cout.rdbuf(output);
+
+    REQUIRE(controller.samples().size() == 2);
+    REQUIRE(printed.str().starts_with("[ ] Request velocity: "));
+    REQUIRE(printed.str().find('\n') == printed.str().size() - 1);
+  }
+}
+
+TEST_CASE("ControllerTimer") {
+  SECTION("closes samples on windows once they hold the minimum completions") {
+    boost::asio::io_context ios;
+    FixedController controller{3, 1000};
+    ControllerTimer timer{ios, controller, std::chrono::milliseconds{1}, 2};
+
+    controller.register_completion(3);
+    controller.tick();
+    REQUIRE(controller.samples().empty());
+    controller.register_completion(3);
+    REQUIRE(controller.samples().empty());
+    controller.tick();
+    REQUIRE(controller.samples().size() == 1);
+    REQUIRE(controller.samples().front().coroutines == 3);
+    REQUIRE(controller.measured_velocity() > 0.0);
+
+    controller.register_completion(2);
+    controller.register_completion(2);
+    timer.start();
+    ios.run_one();
+    REQUIRE(controller.samples().size() == 2);
+    timer.stop();
+    ios.run();
   }
 }
 
@@ -17,9 +72,15 @@ TEST_CASE("AdaptiveController") {
   SECTION("raises low-sample recommendations without exceeding the maximum") {
     AdaptiveController controller{2, 4, 1, 1, 3};
 
+    REQUIRE(controller.measured_velocity() == 0.0);
     controller.register_completion(2);
     REQUIRE(controller.recommended_coroutines() == 3);
+    REQUIRE(controller.measured_velocity() > 0.0);
     controller.register_completion(2);
+    REQUIRE(controller.samples().size() == 2);
+    REQUIRE(controller.samples().front().coroutines == 2);
+    REQUIRE(controller.samples().front().recommended == 2);
+    REQUIRE(controller.samples().back().recommended == 3);
     REQUIRE(controller.recommended_coroutines() == 3);
   }
 
@@ -32,3 +93,165 @@ TEST_CASE("AdaptiveController") {
     REQUIRE(controller.recommended_coroutines() == 1);
   }
 }
+
+namespace {
+/// Records `count` finished candidates, the first `failed` of them as errors of `cause`.
+void finish(RunStats& stats, int count, int failed, const ErrorCause& cause) {
+  for (int candidate{}; candidate < count; ++candidate) {
+    stats.record_candidate_started();
+    if (candidate < failed) {
+      stats.record_error(cause);
+    }
+    stats.record_candidate_finished();
+  }
+}
+
+/// Records `count` responses whose first byte took `latency`.
+void respond(RunStats& stats, int count, std::chrono::milliseconds latency) {
+  for (int response{}; response < count; ++response) {
+    stats.record_phase(Phase::first_byte, latency);
+  }
+}
+} // namespace
+
+TEST_CASE("AimdController") {
+  const auto refused = ErrorCause::of(std::runtime_error{"refused"});
+  const auto timeout = ErrorCause::of(AbradeException::timeout("get query"));
+
+  SECTION("doubles until the maximum while healthy and only when the scraper keeps up") {
+    RunStats stats;
+    AimdController controller{stats, 10, 4, 1, 1, 50};
+
+    controller.register_completion(10);
+    REQUIRE(controller.recommended_coroutines() == 20);
+    controller.register_completion(5);
+    REQUIRE(controller.recommended_coroutines() == 20);
+    controller.register_completion(20);
+    REQUIRE(controller.recommended_coroutines() == 40);
+    controller.register_completion(40);
+    REQUIRE(controller.recommended_coroutines() == 50);
+    REQUIRE(controller.samples().size() == 4);
+    REQUIRE(controller.congestion().empty());
+  }
+
+  SECTION("halves on errors, waits one sample, then increases additively") {
+    RunStats stats;
+    AimdController controller{stats, 40, 4, 1, 1, 1000};
+
+    finish(stats, 100, 10, refused);
+    controller.register_completion(40);
+    REQUIRE(controller.recommended_coroutines() == 20);
+    REQUIRE(controller.congestion() == "errors");
+    finish(stats, 100, 10, refused);
+    controller.register_completion(20);
+    REQUIRE(controller.recommended_coroutines() == 20);
+    finish(stats, 100, 0, refused);
+    controller.register_completion(20);
+    REQUIRE(controller.recommended_coroutines() == 24);
+  }
+
+  SECTION("judges only candidates finished after it was created") {
+    RunStats stats;
+    finish(stats, 100, 50, refused);
+    AimdController controller{stats, 10, 4, 1, 1, 50};
+
+    finish(stats, 100, 0, refused);
+    controller.register_completion(10);
+    REQUIRE(controller.recommended_coroutines() == 20);
+    REQUIRE(controller.congestion().empty());
+  }
+
+  SECTION("backs off on a timeout rate below the error threshold") {
+    RunStats stats;
+    AimdController controller{stats, 40, 4, 1, 10, 1000};
+
+    finish(stats, 100, 2, timeout);
+    controller.register_completion(40);
+    REQUIRE(controller.recommended_coroutines() == 20);
+    REQUIRE(controller.congestion() == "timeouts");
+  }
+
+  SECTION("backs off when time to first byte inflates, but not below the minimum") {
+    RunStats stats;
+    AimdController controller{stats, 16, 4, 1, 40, 1000};
+
+    respond(stats, 10, std::chrono::milliseconds{10});
+    controller.register_completion(16);
+    REQUIRE(controller.recommended_coroutines() == 32);
+    respond(stats, 10, std::chrono::milliseconds{15});
+    controller.register_completion(32);
+    REQUIRE(controller.recommended_coroutines() == 64);
+    respond(stats, 10, std::chrono::milliseconds{25});
+    controller.register_completion(64);
+    REQUIRE(controller.recommended_coroutines() == 40);
+    REQUIRE(controller.congestion() == "latency");
+  }
+}
+
+namespace {
+/// Completes one sample at the recommendation against a target that queues beyond 64 requests.
+void serve(GradientController& controller) {
+  const auto coroutines = controller.recommended_coroutines();
+  const auto queueing = std::max(1.0, static_cast<double>(coroutines) / 64.0);
+  controller.register_latency(std::chrono::microseconds{std::llround(100'000.0 * queueing)});
+  controller.register_completion(coroutines);
+}
+} // namespace
+
+TEST_CASE("GradientController") {
+  SECTION("doubles through startup, then settles just past the knee") {
+    GradientController controller{8, 10, 1, 1, 1000};
+
+    for (const size_t expected : {16U, 32U, 64U, 128U, 128U}) {
+      serve(controller);
+      REQUIRE(controller.recommended_coroutines() == expected);
+      REQUIRE(controller.in_startup());
+    }
+    serve(controller);
+    REQUIRE_FALSE(controller.in_startup());
+    REQUIRE(controller.recommended_coroutines() == 64);
+    REQUIRE(controller.min_rtt() == 0.1);
+    REQUIRE(controller.bandwidth_delay_product() == 64.0);
+    for (int sample{}; sample < 10; ++sample) {
+      serve(controller);
+      REQUIRE(controller.recommended_coroutines() == 72);
+    }
+    REQUIRE(controller.samples().size() == 16);
+  }
+
+  SECTION("drains the queue to remeasure an expired minimum RTT") {
+    GradientController controller{8, 10, 1, 1, 1000};
+
+    for (int sample{}; sample < 16; ++sample) {
+      serve(controller);
+    }
+    REQUIRE_FALSE(controller.probing_rtt());
+    serve(controller);
+    REQUIRE(controller.probing_rtt());
+    REQUIRE(controller.recommended_coroutines() == 32);
+    serve(controller);
+    REQUIRE_FALSE(controller.probing_rtt());
+    REQUIRE(controller.recommended_coroutines() == 72);
+    REQUIRE(controller.min_rtt() == 0.1);
+  }
+
+  SECTION("only grows while the scraper keeps up") {
+    GradientController controller{10, 4, 1, 1, 1000};
+
+    controller.register_latency(std::chrono::milliseconds{10});
+    controller.register_completion(5);
+    REQUIRE(controller.recommended_coroutines() == 10);
+    controller.register_latency(std::chrono::milliseconds{10});
+    controller.register_completion(10);
+    REQUIRE(controller.recommended_coroutines() == 20);
+  }
+
+  SECTION("holds the recommendation through samples without latencies") {
+    GradientController controller{10, 4, 1, 1, 1000};
+
+    controller.register_completion(10);
+    REQUIRE(controller.recommended_coroutines() == 10);
+    REQUIRE(controller.bandwidth_delay_product() == 0.0);
+    REQUIRE(controller.samples().size() == 1);
+  }
+}
@@ -1401,3 +1401,14 @@ TEST_CASE("UriGenerator") {
             std::log(static_cast<double>(std::numeric_limits<size_t>::max())));
   }
 }
+
+TEST_CASE("ListGenerator") {
+  SECTION("returns its targets in order, then nothing") {
+    ListGenerator generator{{"/a", "/b"}};
+
+    REQUIRE(generator.next() == "/a");
+    REQUIRE(generator.next() == "/b");
+    REQUIRE_FALSE(generator.next());
+    REQUIRE_FALSE(generator.next());
+  }
+}
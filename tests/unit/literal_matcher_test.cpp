@@ -0,0 +1,115 @@
+#include <abrade/content_filter.hpp>
+#include <abrade/literal_matcher.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace abrade;
+
+namespace {
+std::vector<std::size_t> matches(const LiteralMatcher& matcher, std::string_view text) {
+  std::vector<std::size_t> found;
+  static_cast<void>(matcher.scan(LiteralMatcher::start_state, text,
+                                 [&found](std::size_t index) { found.push_back(index); }));
+  return found;
+}
+} // namespace
+
+TEST_CASE("LiteralMatcher") {
+  SECTION("reports every occurrence, including overlapping and nested literals") {
+    const LiteralMatcher matcher{{"he", "she", "his", "hers"}};
+
+    REQUIRE(matches(matcher, "ushers") == std::vector<std::size_t>{1, 0, 3});
+  }
+
+  SECTION("finds literals that straddle chunk boundaries") {
+    const LiteralMatcher matcher{{"not found", "error"}};
+    std::vector<std::size_t> found;
+    const auto record = [&found](std::size_t index) { found.push_back(index); };
+
+    auto state = matcher.scan(LiteralMatcher::start_state, "page not fo", record);
+    state = matcher.scan(state, "und; err", record);
+    static_cast<void>(matcher.scan(state, "or", record));
+
+    REQUIRE(found == std::vector<std::size_t>{0, 1});
+  }
+
+  SECTION("treats bytes outside the literal alphabet as resets") {
+    const LiteralMatcher matcher{{"abc"}};
+
+    REQUIRE(matches(matcher, "ab\xff"
+                             "abc")
+                .size() == 1);
+    REQUIRE(matches(matcher, "ab-c").empty());
+  }
+
+  SECTION("is empty when only empty literals are configured") {
+    REQUIRE(LiteralMatcher{{}}.empty());
+    REQUIRE(LiteralMatcher{{""}}.empty());
+  }
+}
+
+TEST_CASE("ContentFilters") {
+  SECTION("keeps conjunctive literal semantics across many literals") {
+    const ContentFilters filters{{"alpha", "beta"}, {"gamma", "delta"}, {}, {}};
+
+    REQUIRE(filters.accepts("alpha beta"));
+    REQUIRE_FALSE(filters.accepts("alpha only"));
+    REQUIRE_FALSE(filters.accepts("alpha beta delta"));
+  }
+
+  SECTION("treats an empty required literal as present and an empty rejected literal as a block") {
+    REQUIRE(ContentFilters{{""}, {}, {}, {}}.accepts("anything"));
+    REQUIRE_FALSE(ContentFilters{{}, {""}, {}, {}}.accepts("anything"));
+  }
+
+  SECTION("agrees between whole-body and chunked evaluation") {
+    const ContentFilters filters{{"marker"}, {"blocked"}, {"id=[0-9]+;"}, {}};
+    const std::string body{"head marker id=12345; tail"};
+
+    ContentScan scan{filters};
+    for (std::size_t offset{}; offset < body.size(); offset += 3) {
+      scan.feed(std::string_view{body}.substr(offset, 3));
+    }
+    scan.finish();
+
+    REQUIRE(filters.accepts(body));
+    REQUIRE(scan.accepts());
+  }
+
+  SECTION("settles a rejection as soon as a rejected filter matches") {
+    const ContentFilters filters{{"marker"}, {"not found"}, {}, {}};
+    ContentScan scan{filters};
+
+    scan.feed("page not ");
+    REQUIRE_FALSE(scan.rejected());
+    scan.feed("found; marker");
+    REQUIRE(scan.rejected());
+    REQUIRE_FALSE(scan.satisfied());
+  }
+
+  SECTION("stops scanning once every requirement is met and nothing can reject") {
+    const ContentFilters filters{{"marker"}, {}, {"id=[0-9]+;"}, {}};
+    ContentScan scan{filters};
+
+    scan.feed("marker id=1");
+    REQUIRE_FALSE(scan.satisfied());
+    scan.feed("2; tail");
+    REQUIRE(scan.satisfied());
+    scan.feed("anything after is ignored");
+    scan.finish();
+    REQUIRE(scan.accepts());
+  }
+
+  SECTION("never settles early while rejected filters are configured") {
+    const ContentFilters filters{{"marker"}, {}, {}, {"blocked"}};
+    ContentScan scan{filters};
+
+    scan.feed("marker");
+    REQUIRE_FALSE(scan.satisfied());
+    scan.feed(" blocked");
+    REQUIRE(scan.rejected());
+  }
+}
@@ -0,0 +1,126 @@
+#include <abrade/controller.hpp>
+#include <abrade/exception.hpp>
+#include <abrade/metrics.hpp>
+#include <abrade/run_stats.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/http.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+using namespace abrade;
+
+namespace {
+std::string scrape(std::string_view target, std::string& content_type) {
+  namespace http = boost::beast::http;
+  RunStats stats;
+  stats.record_attempt();
+  stats.record_response(200);
+  FixedController controller{4, 1};
+  boost::asio::io_context ios;
+  MetricsServer server{ios, {boost::asio::ip::make_address("127.0.0.1"), 0}, stats, controller};
+  server.start();
+  std::string body;
+  boost::asio::spawn(
+      ios,
+      [&](const boost::asio::yield_context& yield) {
+        boost::asio::ip::tcp::socket socket{ios};
+        socket.async_connect(server.local_endpoint(), yield);
+        http::request<http::empty_body> request{http::verb::get, std::string{target}, 11};
+        http::async_write(socket, request, yield);
+        boost::beast::flat_buffer buffer;
+        http::response<http::string_body> response;
+        http::async_read(socket, buffer, response, yield);
+        content_type = std::string{response[http::field::content_type]};
+        body = response.body();
+        server.stop();
+      },
+      boost::asio::detached);
+  ios.run();
+  return body;
+}
+} // namespace
+
+TEST_CASE("openmetrics") {
+  SECTION("exports counters, controller gauges, and phase histograms") {
+    RunStats stats;
+    stats.record_attempt();
+    stats.record_candidate_started();
+    stats.enter(CoroutineState::body);
+    stats.record_response(404);
+    stats.record_error(ErrorCause::of(AbradeException::timeout("tcp \"connect\"")));
+    stats.record_bytes_received(512);
+    stats.record_phase(Phase::first_byte, std::chrono::milliseconds{3});
+    stats.record_phase(Phase::first_byte, std::chrono::milliseconds{40});
+    const FixedController controller{12, 1};
+
+    const auto text = openmetrics(stats, controller);
+
+    REQUIRE(text.contains("# TYPE abrade_requests counter\n"));
+    REQUIRE(text.contains("\nabrade_requests_total 1\n"));
+    REQUIRE(text.contains("\nabrade_responses_total{class=\"other\"} 1\n"));
+    REQUIRE(text.contains("\nabrade_responses_by_status_total{code=\"404\"} 1\n"));
+    REQUIRE(text.contains("\nabrade_errors_by_cause_total{action=\"tcp \\\"connect\\\"\","
+                          "category=\"timeout\",reason=\"\"} 1\n"));
+    REQUIRE(text.contains("\nabrade_bytes_received_total 512\n"));
+    REQUIRE(text.contains("\nabrade_in_flight 1\n"));
+    REQUIRE(text.contains("# TYPE abrade_coroutines_waiting gauge\n"));
+    REQUIRE(text.contains("\nabrade_coroutines_waiting{state=\"body\"} 1\n"));
+    REQUIRE(text.contains("\nabrade_coroutines_waiting{state=\"dns\"} 0\n"));
+    REQUIRE(text.contains("\nabrade_controller_recommended_coroutines 12\n"));
+    REQUIRE(text.contains("\nabrade_controller_velocity 0\n"));
+    REQUIRE(text.contains("# TYPE abrade_phase_latency_seconds histogram\n"));
+    REQUIRE(text.contains("abrade_phase_latency_seconds_bucket{phase=\"ttfb\",le=\"0.001\"} 0\n"));
+    REQUIRE(text.contains("abrade_phase_latency_seconds_bucket{phase=\"ttfb\",le=\"0.005\"} 1\n"));
+    REQUIRE(text.contains("abrade_phase_latency_seconds_bucket{phase=\"ttfb\",le=\"+Inf\"} 2\n"));
+    REQUIRE(text.contains("abrade_phase_latency_seconds_sum{phase=\"ttfb\"} 0.043\n"));
+    REQUIRE(text.contains("abrade_phase_latency_seconds_count{phase=\"dns\"} 0\n"));
+    REQUIRE(text.ends_with("# EOF\n"));
+  }
+}
+
+TEST_CASE("MetricsServer") {
+  SECTION("serves the snapshot at /metrics") {
+    std::string content_type;
+    const auto body = scrape("/metrics", content_type);
+
+    REQUIRE(content_type.starts_with("application/openmetrics-text"));
+    REQUIRE(body.contains("\nabrade_responses_total{class=\"2xx\"} 1\n"));
+    REQUIRE(body.contains("\nabrade_controller_recommended_coroutines 4\n"));
+  }
+
+  SECTION("answers other targets with 404") {
+    std::string content_type;
+
+    REQUIRE(scrape("/", content_type) == "not found\n");
+  }
+
+  SECTION("stops accepting once the acceptor is closed") {
+    RunStats stats;
+    const FixedController controller{1, 1};
+    boost::asio::io_context ios;
+    MetricsServer server{ios, {boost::asio::ip::make_address("127.0.0.1"), 0}, stats, controller};
+    server.start();
+    boost::asio::post(ios, [&] { server.stop(); });
+    ios.run_for(std::chrono::seconds{5});
+
+    REQUIRE(ios.stopped());
+  }
+
+  SECTION("reports a listen address that cannot be bound") {
+    RunStats stats;
+    const FixedController controller{1, 1};
+    boost::asio::io_context ios;
+    const MetricsServer first{
+        ios, {boost::asio::ip::make_address("127.0.0.1"), 0}, stats, controller};
+
+    REQUIRE_THROWS_AS(MetricsServer(ios, first.local_endpoint(), stats, controller),
+                      AbradeException);
+  }
+}
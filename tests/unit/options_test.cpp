@@ -2,7 +2,9 @@
 #include <algorithm>
 #include <boost/tokenizer.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
 #include <iterator>
+#include <limits>
 #include <ranges>
 #include <string>
 #include <vector>
@@ -222,6 +224,153 @@ TEST_CASE("Options") {
     }
   }
 
+  SECTION("Parses error body handling correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10] --contents"};
+
+    SECTION("default") { REQUIRE(opt(cmdline).is_close_error_bodies() == true); }
+
+    SECTION("with drain") {
+      REQUIRE(opt(cmdline + " --error-bodies drain").is_close_error_bodies() == false);
+    }
+
+    SECTION("with an illegal value") { REQUIRE_THROWS(opt(cmdline + " --error-bodies keep")); }
+  }
+
+  SECTION("Parses HEAD fallback correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    REQUIRE(opt(cmdline).is_head_fallback());
+    REQUIRE_FALSE(opt(cmdline + " --head-fallback off").is_head_fallback());
+    REQUIRE_THROWS(opt(cmdline + " --head-fallback always"));
+  }
+
+  SECTION("Parses body worker settings correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10] --contents"};
+
+    SECTION("default") {
+      REQUIRE(opt(cmdline).get_workers() == 2);
+      REQUIRE(opt(cmdline).get_worker_queue() == 64);
+    }
+
+    SECTION("with inline processing and a custom queue") {
+      const auto options = opt(cmdline + " --workers 0 --worker-queue 8");
+      REQUIRE(options.get_workers() == 0);
+      REQUIRE(options.get_worker_queue() == 8);
+    }
+
+    SECTION("with an empty queue") { REQUIRE_THROWS(opt(cmdline + " --worker-queue 0")); }
+  }
+
+  SECTION("Parses the progress interval correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    REQUIRE(opt(cmdline).get_progress_interval() == 1000);
+    REQUIRE(opt(cmdline + " --progress 250").get_progress_interval() == 250);
+    REQUIRE(opt(cmdline + " --progress 0").get_pretty_print().contains("Progress updates: Off"));
+  }
+
+  SECTION("Parses the metrics endpoint correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    REQUIRE(opt(cmdline).get_metrics_listen().empty());
+    REQUIRE(opt(cmdline + " --metrics-listen 127.0.0.1:9464").get_metrics_listen() ==
+            "127.0.0.1:9464");
+    REQUIRE(opt(cmdline + " --metrics-listen [::1]:9464").get_pretty_print().contains(
+        "Metrics endpoint: http://[::1]:9464/metrics"));
+    REQUIRE_THROWS(opt(cmdline + " --metrics-listen 127.0.0.1"));
+    REQUIRE_THROWS(opt(cmdline + " --metrics-listen localhost:9464"));
+  }
+
+  SECTION("Parses the run report path") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    REQUIRE(opt(cmdline).get_report_path().empty());
+    const auto options = opt(cmdline + " --report run.json");
+    REQUIRE(options.get_report_path() == "run.json");
+    REQUIRE(options.get_pretty_print().contains("[ ] Run report: run.json\n"));
+  }
+
+  SECTION("Parses tracing correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    REQUIRE(opt(cmdline).get_trace_path().empty());
+    REQUIRE(opt(cmdline).get_trace_sample() == 100);
+    const auto options = opt(cmdline + " --trace run.trace.json --trace-sample 10");
+    REQUIRE(options.get_trace_path() == "run.trace.json");
+    REQUIRE(options.get_trace_sample() == 10);
+    REQUIRE(options.get_pretty_print().contains("[ ] Trace: run.trace.json (1 in 10 candidates)"));
+    REQUIRE_THROWS(opt(cmdline + " --trace-sample 0"));
+  }
+
+  SECTION("Parses shared-memory stats publishing") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    REQUIRE_FALSE(opt(cmdline).is_shm_stats());
+#if defined(_WIN32)
+    REQUIRE_THROWS(opt(cmdline + " --shm-stats"));
+#else
+    const auto options = opt(cmdline + " --shm-stats");
+    REQUIRE(options.is_shm_stats());
+    REQUIRE(options.get_pretty_print().contains("[ ] Shared-memory stats: Yes\n"));
+#endif
+  }
+
+  SECTION("Parses probe mode correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    REQUIRE_FALSE(opt(cmdline).is_probe());
+    const auto options = opt(cmdline + " --probe --require FOUND");
+    REQUIRE(options.is_probe());
+    REQUIRE(options.is_contents());
+    REQUIRE(options.get_output_path() == "lospi.net-contents");
+  }
+
+  SECTION("Parses near-duplicate clustering correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    REQUIRE(opt(cmdline).get_cluster_exemplars() == 0);
+    const auto options = opt(cmdline + " --contents --cluster 3");
+    REQUIRE(options.get_cluster_exemplars() == 3);
+    REQUIRE(options.get_cluster_index_path() == "lospi.net-contents.clusters.tsv");
+    REQUIRE_THROWS(opt(cmdline + " --cluster 3"));
+  }
+
+  SECTION("Parses soft-404 detection correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    REQUIRE_FALSE(opt(cmdline).is_soft_not_found());
+    REQUIRE(opt(cmdline + " --soft404").is_soft_not_found());
+  }
+
+  SECTION("Parses header filters correctly") {
+    const auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    SECTION("default") {
+      const auto options = opt(cmdline);
+      REQUIRE(options.get_content_types().empty());
+      REQUIRE(options.get_min_length() == 0);
+      REQUIRE(options.get_max_length() == std::numeric_limits<std::uint64_t>::max());
+    }
+
+    SECTION("in HEAD mode") {
+      const auto options =
+          opt(cmdline + " --content-type text/html --content-type application/* --min-length 10 "
+                        "--max-length 4096 --require-header ^Server: --reject-header soft404");
+      REQUIRE(options.get_content_types() ==
+              std::vector<std::string>{"text/html", "application/*"});
+      REQUIRE(options.get_min_length() == 10);
+      REQUIRE(options.get_max_length() == 4096);
+      REQUIRE(options.get_required_header_regexes() == std::vector<std::string>{"^Server:"});
+      REQUIRE(options.get_rejected_header_regexes() == std::vector<std::string>{"soft404"});
+    }
+
+    SECTION("with invalid values") {
+      REQUIRE_THROWS(opt(cmdline + " --min-length 10 --max-length 9"));
+      REQUIRE_THROWS(opt(cmdline + " --require-header ["));
+      REQUIRE_THROWS(opt(cmdline + " --reject-header ["));
+    }
+  }
+
   SECTION("Parses output correctly with") {
     auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
 
@@ -332,6 +481,19 @@ TEST_CASE("Options") {
     SECTION("with fixed options") {
       auto options = opt(cmdline + " --optimize");
       REQUIRE(options.is_optimizer() == true);
+      REQUIRE(options.get_controller() == "adaptive");
+    }
+
+    SECTION("with a named controller") {
+      REQUIRE(opt(cmdline).get_controller() == "fixed");
+      const auto options = opt(cmdline + " --controller aimd");
+      REQUIRE(options.is_optimizer());
+      REQUIRE(options.get_controller() == "aimd");
+      REQUIRE(options.get_pretty_print().contains("[ ] Concurrency controller: aimd"));
+      REQUIRE(opt(cmdline + " --optimize --controller adaptive").get_controller() == "adaptive");
+      REQUIRE(opt(cmdline + " --controller gradient").get_controller() == "gradient");
+      REQUIRE_THROWS(opt(cmdline + " --optimize --controller aimd"));
+      REQUIRE_THROWS(opt(cmdline + " --controller vegas"));
     }
   }
 
@@ -471,4 +633,45 @@ TEST_CASE("Options") {
 
     SECTION("with an illegal value") { REQUIRE_THROWS(opt(cmdline + " --sint=0")); }
   }
+
+  SECTION("Parses sample window correctly") {
+    auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    SECTION("with no options") {
+      auto options = opt(cmdline);
+      REQUIRE(options.get_sample_window() == 1000);
+      REQUIRE(options.get_sample_minimum() == 20);
+    }
+
+    SECTION("with non-default values") {
+      auto options = opt(cmdline + " --swin=0 --smin=5");
+      REQUIRE(options.get_sample_window() == 0);
+      REQUIRE(options.get_sample_minimum() == 5);
+    }
+
+    SECTION("with an illegal minimum") { REQUIRE_THROWS(opt(cmdline + " --smin=0")); }
+  }
+
+  SECTION("Parses calibration correctly") {
+    auto cmdline = std::string{"lospi.net ?asdf[1-10]"};
+
+    SECTION("with no options") {
+      auto options = opt(cmdline);
+      REQUIRE_FALSE(options.is_calibrate());
+      REQUIRE_FALSE(options.is_calibrate_only());
+    }
+
+    SECTION("with calibrate") {
+      auto options = opt(cmdline + " --calibrate");
+      REQUIRE(options.is_calibrate());
+      REQUIRE_FALSE(options.is_calibrate_only());
+      REQUIRE(options.get_pretty_print().contains("[ ] Calibrate concurrency: Yes"));
+    }
+
+    SECTION("with calibrate-only") {
+      auto options = opt(cmdline + " --calibrate-only");
+      REQUIRE(options.is_calibrate());
+      REQUIRE(options.is_calibrate_only());
+    }
+  }
 }
@@ -0,0 +1,342 @@
+#include <abrade/action.hpp>
+#include <abrade/connection.hpp>
+#include <abrade/content_filter.hpp>
+#include <abrade/controller.hpp>
+#include <abrade/generator.hpp>
+#include <abrade/header_filter.hpp>
+#include <abrade/query.hpp>
+#include <abrade/redirect_policy.hpp>
+#include <abrade/run_stats.hpp>
+#include <abrade/scraper.hpp>
+#include <abrade/scraper_runtime.hpp>
+#include <abrade/worker_pool.hpp>
+#include <abrade/writer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/filesystem.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace abrade;
+
+namespace {
+struct ScopedTempDir {
+  ScopedTempDir()
+      : path{boost::filesystem::temp_directory_path() /
+             boost::filesystem::unique_path("abrade-query-test-%%%%-%%%%-%%%%")} {
+    boost::filesystem::create_directories(path);
+  }
+
+  ScopedTempDir(const ScopedTempDir&) = delete;
+  ScopedTempDir(ScopedTempDir&&) = delete;
+  ScopedTempDir& operator=(const ScopedTempDir&) = delete;
+  ScopedTempDir& operator=(ScopedTempDir&&) = delete;
+
+  ~ScopedTempDir() {
+    boost::system::error_code ignored;
+    boost::filesystem::remove_all(path, ignored);
+  }
+
+  boost::filesystem::path path;
+};
+
+std::string read_file(const boost::filesystem::path& path) {
+  std::ifstream file{path.string()};
+  return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+/// Canned answer of `ScriptedServer` to one request.
+struct Reply {
+  unsigned int status;
+  std::string body;
+  bool keep_alive;
+  std::string content_type;
+  /// Sends the body chunked, so neither HEAD nor GET declares its length.
+  bool chunked{};
+};
+
+Reply reply(unsigned int status, std::string body = {}, bool keep_alive = true,
+            std::string content_type = "text/plain") {
+  return Reply{status, std::move(body), keep_alive, std::move(content_type), false};
+}
+
+using Script = std::function<Reply(boost::beast::http::verb, std::string_view)>;
+
+/// Loopback HTTP server that answers from a script and logs every request line it reads.
+struct ScriptedServer {
+  ScriptedServer(boost::asio::io_context& io_context, Script reply_script)
+      : ios{io_context},
+        acceptor{io_context, {boost::asio::ip::make_address("127.0.0.1"), 0}},
+        script{std::move(reply_script)} {
+    boost::asio::spawn(
+        ios, [this](const boost::asio::yield_context& yield) { accept(yield); },
+        boost::asio::detached);
+  }
+
+  [[nodiscard]] std::string host() const {
+    return "127.0.0.1:" + std::to_string(acceptor.local_endpoint().port());
+  }
+
+  void stop() {
+    boost::system::error_code ignored;
+    acceptor.close(ignored);
+  }
+
+  std::vector<std::string> requests;
+
+private:
+  void accept(const boost::asio::yield_context& yield) {
+    while (acceptor.is_open()) {
+      boost::asio::ip::tcp::socket socket{ios};
+      boost::system::error_code ec;
+      acceptor.async_accept(socket, yield[ec]);
+      if (ec) {
+        return;
+      }
+      boost::asio::spawn(
+          ios,
+          [this, client = std::move(socket)](const boost::asio::yield_context& session) mutable {
+            serve(client, session);
+          },
+          boost::asio::detached);
+    }
+  }
+
+  void serve(boost::asio::ip::tcp::socket& socket, const boost::asio::yield_context& yield) {
+    namespace http = boost::beast::http;
+    boost::beast::flat_buffer buffer;
+    boost::system::error_code ec;
+    while (true) {
+      http::request<http::empty_body> request;
+      http::async_read(socket, buffer, request, yield[ec]);
+      if (ec) {
+        return;
+      }
+      requests.push_back(std::string{request.method_string()} + " " +
+                         std::string{request.target()});
+      const auto answer = script(request.method(), std::string{request.target()});
+      if (request.method() == http::verb::head) {
+        http::response<http::empty_body> response;
+        response.result(answer.status);
+        response.set(http::field::content_type, answer.content_type);
+        if (!answer.chunked) {
+          response.content_length(answer.body.size());
+        }
+        response.keep_alive(answer.keep_alive);
+        http::response_serializer<http::empty_body> serializer{response};
+        serializer.split(true);
+        http::async_write_header(socket, serializer, yield[ec]);
+      } else {
+        http::response<http::string_body> response;
+        response.result(answer.status);
+        response.set(http::field::content_type, answer.content_type);
+        response.body() = answer.body;
+        response.keep_alive(answer.keep_alive);
+        if (answer.chunked) {
+          response.chunked(true);
+        } else {
+          response.prepare_payload();
+        }
+        http::async_write(socket, response, yield[ec]);
+      }
+      if (ec || !answer.keep_alive) {
+        socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+        return;
+      }
+    }
+  }
+
+  boost::asio::io_context& ios;
+  boost::asio::ip::tcp::acceptor acceptor;
+  Script script;
+};
+
+/// Result of one `--probe` scan against a `ScriptedServer`.
+struct ProbeRun {
+  std::vector<std::string> requests;
+  RunStats stats;
+};
+
+/// Probes `targets` one at a time and saves accepted bodies under `output`.
+void probe(ProbeRun& run, const Script& script, std::vector<std::string> targets,
+           const boost::filesystem::path& output, bool head_fallback = true,
+           RedirectPolicy redirects = {},
+           std::uint64_t max_length = std::numeric_limits<std::uint64_t>::max()) {
+  boost::asio::io_context ios;
+  ScriptedServer server{ios, script};
+  WorkerPool workers{ios, 0U, 1U, run.stats};
+  const HeaderFilters text_only{{"text/plain"}, 0U, max_length, {}, {}};
+  GetQuery get{GetAction{output.string(), ContentFilters{}, run.stats, text_only},
+               false,
+               false,
+               RedirectPolicy{},
+               false,
+               workers,
+               run.stats};
+  RequestWriter writer{server.host(), false, "abrade-test", run.stats};
+  ListGenerator generator{std::move(targets)};
+  FixedController controller{1, 1000};
+  Scraper<ListGenerator, ProbeQuery, PlaintextConnection, RequestWriter, FileErrorLog> scraper{
+      ProbeQuery{std::move(get), writer, false, std::move(redirects), head_fallback, run.stats},
+      PlaintextConnection{server.host(), false, ios, run.stats},
+      RequestWriter{writer},
+      FileErrorLog{(output / "errors.log").string(), false},
+      controller,
+      ios,
+      run.stats};
+  scraper.run(generator, [&server] { server.stop(); });
+  run.requests = server.requests;
+}
+} // namespace
+
+TEST_CASE("ProbeQuery") {
+  SECTION("promotes a 2xx HEAD answer to GET on the same connection") {
+    const ScopedTempDir temp;
+    ProbeRun run;
+    probe(
+        run,
+        [](boost::beast::http::verb /*method*/, std::string_view /*target*/) {
+          return reply(200, "alpha");
+        },
+        {"/a"}, temp.path);
+
+    REQUIRE(run.requests == std::vector<std::string>{"HEAD /a", "GET /a"});
+    REQUIRE(read_file(temp.path / "_a") == "alpha");
+    REQUIRE(run.stats.probes() == 1);
+    REQUIRE(run.stats.promotions() == 1);
+    REQUIRE(run.stats.hits() == 1);
+  }
+
+  SECTION("never fetches a candidate whose HEAD answer is a miss") {
+    const ScopedTempDir temp;
+    ProbeRun run;
+    probe(
+        run,
+        [](boost::beast::http::verb /*method*/, std::string_view /*target*/) {
+          return reply(404, "missing");
+        },
+        {"/a"}, temp.path, false);
+
+    REQUIRE(run.requests == std::vector<std::string>{"HEAD /a"});
+    REQUIRE_FALSE(boost::filesystem::exists(temp.path / "_a"));
+    REQUIRE(run.stats.promotions() == 0);
+    REQUIRE(run.stats.hits() == 0);
+  }
+
+  SECTION("never fetches a 2xx HEAD answer rejected by header filters") {
+    const ScopedTempDir temp;
+    ProbeRun run;
+    probe(
+        run,
+        [](boost::beast::http::verb /*method*/, std::string_view /*target*/) {
+          return reply(200, "<html>", true, "text/html");
+        },
+        {"/a"}, temp.path);
+
+    REQUIRE(run.requests == std::vector<std::string>{"HEAD /a"});
+    REQUIRE(run.stats.header_filtered() == 1);
+    REQUIRE(run.stats.promotions() == 0);
+    REQUIRE(run.stats.hits() == 0);
+  }
+
+  SECTION("drops a chunked body that outgrows the maximum length as header-filtered") {
+    const ScopedTempDir temp;
+    ProbeRun run;
+    probe(
+        run,
+        [](boost::beast::http::verb /*method*/, std::string_view /*target*/) {
+          auto answer = reply(200, "alpha alpha alpha");
+          answer.chunked = true;
+          return answer;
+        },
+        {"/a"}, temp.path, true, {}, 8U);
+
+    REQUIRE(run.requests == std::vector<std::string>{"HEAD /a", "GET /a"});
+    REQUIRE_FALSE(boost::filesystem::exists(temp.path / "_a"));
+    REQUIRE(run.stats.promotions() == 1);
+    REQUIRE(run.stats.header_filtered() == 1);
+    REQUIRE(run.stats.filtered() == 0);
+    REQUIRE(run.stats.hits() == 0);
+    REQUIRE_FALSE(run.stats.has_errors());
+  }
+
+  SECTION("retries a hit as GET on a new connection when the server closes after HEAD") {
+    const ScopedTempDir temp;
+    ProbeRun run;
+    probe(
+        run,
+        [](boost::beast::http::verb method, std::string_view /*target*/) {
+          return reply(200, "alpha", method != boost::beast::http::verb::head);
+        },
+        {"/a", "/b"}, temp.path);
+
+    REQUIRE(run.requests == std::vector<std::string>{"HEAD /a", "GET /a", "HEAD /b", "GET /b"});
+    REQUIRE(read_file(temp.path / "_a") == "alpha");
+    REQUIRE(read_file(temp.path / "_b") == "alpha");
+    REQUIRE(run.stats.promotions() == 2);
+    REQUIRE(run.stats.hits() == 2);
+    REQUIRE_FALSE(run.stats.has_errors());
+  }
+
+  SECTION("retries a hit that has no redirects left to spend") {
+    const ScopedTempDir temp;
+    ProbeRun run;
+    probe(
+        run,
+        [](boost::beast::http::verb method, std::string_view /*target*/) {
+          return reply(200, "alpha", method != boost::beast::http::verb::head);
+        },
+        {"/a"}, temp.path, true, RedirectPolicy{.max_redirects = 0});
+
+    REQUIRE(run.requests == std::vector<std::string>{"HEAD /a", "GET /a"});
+    REQUIRE(read_file(temp.path / "_a") == "alpha");
+    REQUIRE(run.stats.hits() == 1);
+  }
+
+  SECTION("falls back to GET for every candidate once the server refuses HEAD") {
+    const ScopedTempDir temp;
+    ProbeRun run;
+    probe(
+        run,
+        [](boost::beast::http::verb method, std::string_view target) {
+          if (method == boost::beast::http::verb::head) {
+            return reply(405);
+          }
+          return target == "/a" ? reply(200, "alpha") : reply(404);
+        },
+        {"/a", "/b"}, temp.path);
+
+    REQUIRE(run.requests == std::vector<std::string>{"HEAD /a", "GET /a", "GET /b"});
+    REQUIRE(read_file(temp.path / "_a") == "alpha");
+    REQUIRE(run.stats.head_fallbacks() == 2);
+    REQUIRE(run.stats.hits() == 1);
+    REQUIRE_FALSE(run.stats.has_errors());
+  }
+
+  SECTION("keeps sending HEAD when the fallback is off") {
+    const ScopedTempDir temp;
+    ProbeRun run;
+    probe(
+        run,
+        [](boost::beast::http::verb method, std::string_view /*target*/) {
+          return method == boost::beast::http::verb::head ? reply(405) : reply(200, "alpha");
+        },
+        {"/a", "/b"}, temp.path, false);
+
+    REQUIRE(run.requests == std::vector<std::string>{"HEAD /a", "HEAD /b"});
+    REQUIRE_FALSE(boost::filesystem::exists(temp.path / "_a"));
+    REQUIRE(run.stats.hits() == 0);
+  }
+}
@@ -0,0 +1,133 @@
+#include <abrade/regex_set.hpp>
+#include <boost/regex.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace abrade;
+
+namespace {
+std::vector<bool> scan(const RegexSet& set, std::size_t count, std::string_view body) {
+  RegexSet::Scanner scanner{set};
+  scanner.feed(body);
+  std::vector<bool> matched;
+  for (std::size_t index{}; index < count; ++index) {
+    matched.push_back(scanner.matched(index));
+  }
+  return matched;
+}
+} // namespace
+
+TEST_CASE("RegexSet") {
+  SECTION("reports which patterns matched in one pass") {
+    const std::vector<std::string> patterns{"id=[0-9]+;", "cancel(led)?|postponed", "x{3}"};
+    const RegexSet set{patterns};
+
+    REQUIRE(scan(set, patterns.size(), "race postponed, id=12;") ==
+            std::vector<bool>{true, true, false});
+  }
+
+  SECTION("carries partial matches across chunk boundaries") {
+    const RegexSet set{{"HCRA\\s+Race [0-9]{2}"}};
+    RegexSet::Scanner scanner{set};
+
+    scanner.feed("results: HCRA  ");
+    REQUIRE_FALSE(scanner.matched(0));
+    scanner.feed("Race 1");
+    scanner.feed("2 final");
+    REQUIRE(scanner.matched(0));
+  }
+
+  SECTION("leaves constructs the DFA cannot express to boost::regex") {
+    const std::vector<std::string> unsupported{
+        "^start", "end$", "\\bword", "(a)\\1", "(?=a)b", "(?i)abc", "a*+", "[[:alpha:]]", "a{",
+        "x{,2}",  "[]a]"};
+    const RegexSet set{unsupported};
+
+    for (std::size_t index{}; index < unsupported.size(); ++index) {
+      INFO(unsupported[index]);
+      REQUIRE_FALSE(set.supports(index));
+    }
+    REQUIRE(set.empty());
+    REQUIRE(RegexSet{{"a.b", "[^\\d-]x", "(?:ab|cd)*?e", "\\x41\\.\\e"}}.supports(3));
+  }
+
+  SECTION("agrees with boost::regex on supported syntax") {
+    const std::vector<std::string> patterns{
+        "a.c", "colou?r", "(ab|cd)+e", "[a-c][^a-c]", "x{2,3}y",
+        "\\d\\d-\\w+", "\\s\\S", "[\\d_-]{3}", "(a|)b", "",
+        "(?:not )*found", "\\.\\*\\x2B", "[.-/]z", "q(u|x{0,2})*k"};
+    const std::vector<std::string> bodies{
+        "", "abc", "color", "colouur", "ababcde", "a-c", "xxy",
+        "xxxxy", "12-ab", "\t\n x", "_-5", "b", "not found", "not not",
+        "found", ".*+", "/z", "quxxk", "qk", "quuuxk", std::string{"a\0c", 3}};
+    const RegexSet set{patterns};
+
+    for (std::size_t index{}; index < patterns.size(); ++index) {
+      REQUIRE(set.supports(index));
+    }
+    for (const auto& body : bodies) {
+      const auto matched = scan(set, patterns.size(), body);
+      for (std::size_t index{}; index < patterns.size(); ++index) {
+        INFO("pattern " << patterns[index] << " body " << body);
+        REQUIRE(matched[index] == boost::regex_search(body, boost::regex{patterns[index]}));
+      }
+    }
+  }
+
+  SECTION("agrees with boost::regex on every escaped punctuation byte") {
+    for (char value{' '}; value <= '~'; ++value) {
+      if ((value >= '0' && value <= '9') || (value >= 'a' && value <= 'z') ||
+          (value >= 'A' && value <= 'Z')) {
+        continue;
+      }
+      const std::string escaped{'\\', value};
+      const std::vector<std::string> patterns{escaped, "a" + escaped + "b", "[" + escaped + "]"};
+      const std::vector<std::string> bodies{"",       "word",     " word ", std::string{value},
+                                            "a" + std::string{value} + "b", "ab", "a b"};
+      const RegexSet set{patterns};
+
+      for (const auto& body : bodies) {
+        const auto matched = scan(set, patterns.size(), body);
+        for (std::size_t index{}; index < patterns.size(); ++index) {
+          if (!set.supports(index)) {
+            continue;
+          }
+          INFO("pattern " << patterns[index] << " body " << body);
+          REQUIRE(matched[index] == boost::regex_search(body, boost::regex{patterns[index]}));
+        }
+      }
+    }
+    for (const std::string anchor : {"\\<", "\\>", "\\`", "\\'"}) {
+      INFO(anchor);
+      REQUIRE_FALSE(RegexSet{{anchor}}.supports(0));
+    }
+  }
+
+  SECTION("stays linear on inputs that make backtracking matchers explode") {
+    const RegexSet set{{"(x+x+)+y", "(a|aa)*b"}};
+    const std::string body(1024U * 1024U, 'x');
+
+    REQUIRE(scan(set, 2, body) == std::vector<bool>{false, false});
+  }
+
+  SECTION("keeps matching correctly after flushing the state cache") {
+    const std::string pattern{"a[ab]{12}c"};
+    const RegexSet set{{pattern}};
+    std::string body;
+    std::uint32_t random{2463534242U};
+    for (std::size_t index{}; index < 200000U; ++index) {
+      random ^= random << 13U;
+      random ^= random >> 17U;
+      random ^= random << 5U;
+      body.push_back((random & 1U) == 0U ? 'a' : 'b');
+    }
+
+    REQUIRE_FALSE(scan(set, 1, body).front());
+    body += "c";
+    REQUIRE(scan(set, 1, body).front() == boost::regex_search(body, boost::regex{pattern}));
+  }
+}
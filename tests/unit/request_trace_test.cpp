@@ -0,0 +1,80 @@
+#include <abrade/exception.hpp>
+#include <abrade/request_trace.hpp>
+#include <abrade/run_stats.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <sstream>
+#include <string>
+
+using namespace abrade;
+
+TEST_CASE("RequestTracer") {
+  SECTION("samples one candidate in every sample_every and reuses lanes") {
+    RequestTracer tracer{2};
+
+    const auto first = tracer.begin_candidate();
+    REQUIRE(first == 1U);
+    REQUIRE_FALSE(tracer.begin_candidate());
+    const auto third = tracer.begin_candidate();
+    REQUIRE(third == 2U);
+    tracer.end_candidate(*first, "/a", std::chrono::steady_clock::now(), {});
+    REQUIRE_FALSE(tracer.begin_candidate());
+    REQUIRE(tracer.begin_candidate() == 1U);
+    REQUIRE(tracer.sampled_candidates() == 3U);
+  }
+
+  SECTION("attributes phases to the candidate bound to the request socket") {
+    RequestTracer tracer{1};
+    RunStats stats;
+    stats.attach_tracer(tracer);
+    const int traced_socket{};
+    const int other_socket{};
+    {
+      CandidateTrace trace{stats.tracer(), "/found?q=\"x\""};
+      {
+        const auto binding = trace.bind(&traced_socket);
+        stats.record_phase(Phase::connect, std::chrono::steady_clock::now(), &traced_socket);
+        stats.trace_span(&traced_socket, "filter", std::chrono::steady_clock::now());
+        stats.record_phase(Phase::connect, std::chrono::steady_clock::now(), &other_socket);
+      }
+      stats.record_phase(Phase::write, std::chrono::steady_clock::now(), &traced_socket);
+      trace.fail(ErrorCause::of(AbradeException::timeout("get query")));
+      trace.finish(3, 4);
+    }
+    std::ostringstream out;
+    tracer.write(out);
+    const auto json = out.str();
+
+    REQUIRE(tracer.events() == 4U);
+    REQUIRE(stats.latency(Phase::connect).count() == 2U);
+    REQUIRE(json.starts_with("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"sample_every\":1,"
+                             "\"sampled_candidates\":1,\"dropped_events\":0},\"traceEvents\":["));
+    REQUIRE(json.contains("{\"name\":\"connect\",\"cat\":\"abrade\",\"ph\":\"X\",\"ts\":"));
+    REQUIRE(json.contains("{\"name\":\"filter\",\"cat\":\"abrade\",\"ph\":\"X\",\"ts\":"));
+    REQUIRE_FALSE(json.contains("\"name\":\"write\""));
+    REQUIRE(json.contains("\"args\":{\"candidate\":\"/found?q=\\\"x\\\"\","
+                          "\"error\":\"get query (timeout)\"}}"));
+    REQUIRE(json.contains("\"ph\":\"C\""));
+    REQUIRE(json.contains("\"args\":{\"active\":3,\"recommended\":4}}"));
+    REQUIRE(json.ends_with("]}\n"));
+  }
+
+  SECTION("leaves unsampled candidates untraced") {
+    RequestTracer tracer{2};
+    tracer.begin_candidate();
+    const int socket{};
+    CandidateTrace trace{&tracer, "/skipped"};
+    const auto binding = trace.bind(&socket);
+    tracer.span(&socket, "connect", std::chrono::steady_clock::now());
+    trace.finish(1, 1);
+
+    REQUIRE(tracer.events() == 0U);
+  }
+
+  SECTION("does nothing without a tracer") {
+    CandidateTrace trace{nullptr, "/plain"};
+    const int socket{};
+    const auto binding = trace.bind(&socket);
+    trace.finish(1, 1);
+  }
+}
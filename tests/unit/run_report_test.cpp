@@ -0,0 +1,98 @@
+#include <abrade/controller.hpp>
+#include <abrade/exception.hpp>
+#include <abrade/options.hpp>
+#include <abrade/run_report.hpp>
+#include <abrade/run_stats.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace abrade;
+
+namespace {
+Options report_options() {
+  std::vector<const char*> cmdline{"abrade",    "lospi.net", "/{1:5}",   "--contents",
+                                   "--require", "say \"hi\"", "--report", "run.json"};
+  return Options{static_cast<int>(cmdline.size()), cmdline.data()};
+}
+} // namespace
+
+TEST_CASE("JsonWriter") {
+  SECTION("separates members and elements and escapes strings") {
+    std::ostringstream out;
+    detail::JsonWriter json{out};
+    json.begin_object();
+    json.member("text", "a\"b\\c\n\x01");
+    json.member("missing", std::optional<int>{});
+    json.member("present", std::optional<double>{1.5});
+    json.member("list", std::vector<std::string>{"x", "y"});
+    json.begin_array("objects");
+    json.begin_object();
+    json.member("flag", true);
+    json.end_object();
+    json.begin_object();
+    json.end_object();
+    json.end_array();
+    json.member("infinite", 1.0 / 0.0);
+    json.end_object();
+
+    REQUIRE(out.str() == "{\"text\":\"a\\\"b\\\\c\\n\\u0001\",\"missing\":null,\"present\":1.5,"
+                         "\"list\":[\"x\",\"y\"],\"objects\":[{\"flag\":true},{}],"
+                         "\"infinite\":null}");
+  }
+}
+
+TEST_CASE("run_report_json") {
+  SECTION("reports configuration, counters, latency, controller samples, and resources") {
+    const auto options = report_options();
+    RunStats stats;
+    stats.record_attempt();
+    stats.record_response(200);
+    stats.record_response(404);
+    stats.record_error(ErrorCause::of(AbradeException::timeout("tcp connect")));
+    stats.record_phase(Phase::first_byte, std::chrono::milliseconds{3});
+    FixedController controller{7, 1};
+    controller.register_completion(5);
+    ResourceUsage resources;
+    resources.user_cpu_seconds = 0.25;
+
+    const auto json =
+        run_report_json(RunReport{options, stats, controller, 5U, std::nullopt, resources});
+
+    REQUIRE(json.starts_with("{\"report_version\":1,\"elapsed_seconds\":"));
+    REQUIRE(json.contains(",\"cardinality\":5,\"log_cardinality\":null,"));
+    REQUIRE(json.contains("\"host\":\"lospi.net\",\"pattern\":\"/{1:5}\",\"stdin\":false,"));
+    REQUIRE(json.contains("\"required_literals\":[\"say \\\"hi\\\"\"],"));
+    REQUIRE(json.contains("\"max_length\":null,"));
+    REQUIRE(json.contains("\"counters\":{\"requests\":1,"));
+    REQUIRE(json.contains("\"responses_2xx\":1,\"responses_other\":1,"));
+    REQUIRE(json.contains("\"status_codes\":{\"200\":1,\"404\":1}"));
+    REQUIRE(json.contains("\"errors_by_cause\":[{\"action\":\"tcp connect\",\"category\":"
+                          "\"timeout\",\"reason\":\"\",\"count\":1}]"));
+    REQUIRE(json.contains("\"dns\":{\"count\":0,\"p50\":0,"));
+    REQUIRE(json.contains("\"ttfb\":{\"count\":1,\"p50\":3,\"p90\":3,\"p99\":3,\"p99_9\":3,"
+                          "\"max\":3}"));
+    REQUIRE(json.contains("\"controller\":{\"recommended_coroutines\":7,\"samples\":[{"));
+    REQUIRE(json.contains(",\"coroutines\":5,\"recommended\":7}]}"));
+    REQUIRE(json.contains("\"resources\":{\"peak_rss_bytes\":null,\"rss_bytes\":null,"
+                          "\"user_cpu_seconds\":0.25,\"system_cpu_seconds\":null,"
+                          "\"open_fds\":null}}\n"));
+  }
+}
+
+TEST_CASE("ResourceUsage") {
+  SECTION("samples the running process") {
+    const auto usage = ResourceUsage::sample();
+
+#if !defined(_WIN32)
+    REQUIRE(usage.peak_rss_bytes.value_or(0U) > 0U);
+    REQUIRE(usage.user_cpu_seconds.has_value());
+#endif
+#if defined(__linux__)
+    REQUIRE(usage.rss_bytes.value_or(0U) > 0U);
+    REQUIRE(usage.open_fds.value_or(0U) >= 3U);
+#endif
+  }
+}
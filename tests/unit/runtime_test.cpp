@@ -1,11 +1,29 @@
+#include <abrade/exception.hpp>
+#include <abrade/head_fallback.hpp>
 #include <abrade/http_status.hpp>
+#include <abrade/latency_histogram.hpp>
+#include <abrade/progress.hpp>
 #include <abrade/run_stats.hpp>
 #include <abrade/scraper_runtime.hpp>
+#include <abrade/worker_pool.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/spawn.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/filesystem.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
+#include <iostream>
 #include <iterator>
+#include <optional>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace abrade;
 
@@ -46,6 +64,39 @@ TEST_CASE("HttpStatus") {
   }
 }
 
+TEST_CASE("HeadFallback") {
+  SECTION("switches to ranged GET when the server refuses HEAD") {
+    HeadFallback fallback{true};
+
+    REQUIRE_FALSE(fallback.should_recheck(200));
+    REQUIRE(fallback.should_recheck(405));
+    REQUIRE(fallback.observe(405, 206));
+    REQUIRE(fallback.active());
+    REQUIRE_FALSE(fallback.observe(405, 206));
+    REQUIRE_FALSE(fallback.should_recheck(404));
+  }
+
+  SECTION("switches when GET finds what HEAD misses, within the verification budget") {
+    HeadFallback fallback{true};
+    for (std::size_t index{}; index < HeadFallback::verification_budget; ++index) {
+      REQUIRE(fallback.should_recheck(404));
+      REQUIRE_FALSE(fallback.observe(404, 404));
+    }
+    REQUIRE_FALSE(fallback.should_recheck(404));
+    REQUIRE_FALSE(fallback.observe(405, 405));
+    REQUIRE(fallback.observe(404, 200));
+    REQUIRE(fallback.active());
+  }
+
+  SECTION("never rechecks when disabled") {
+    HeadFallback fallback{false};
+
+    REQUIRE_FALSE(fallback.should_recheck(405));
+    REQUIRE_FALSE(fallback.activate());
+    REQUIRE_FALSE(fallback.active());
+  }
+}
+
 TEST_CASE("ScraperRuntime") {
   SECTION("creates candidates from generated URIs") {
     const auto candidate = make_candidate("/items/1");
@@ -66,6 +117,28 @@ TEST_CASE("ScraperRuntime") {
   }
 }
 
+TEST_CASE("ErrorCause") {
+  SECTION("separates the failed action from its error category") {
+    const auto refused = ErrorCause::of(AbradeException{
+        "tcp connect",
+        boost::asio::error::make_error_code(boost::asio::error::connection_refused)});
+
+    REQUIRE(refused.action == "tcp connect");
+    REQUIRE(refused.category == "system");
+    REQUIRE(refused.label().starts_with("tcp connect (system: "));
+  }
+
+  SECTION("recognises timeouts, codeless protocol failures, and other exceptions") {
+    const auto timeout = AbradeException::timeout("get query");
+
+    REQUIRE(std::string{timeout.what()} == "get query timeout");
+    REQUIRE(ErrorCause::of(timeout).label() == "get query (timeout)");
+    REQUIRE(ErrorCause::of(AbradeException{"ssl sni"}).label() == "ssl sni (abrade)");
+    REQUIRE(ErrorCause::of(std::logic_error{"bad state"}).label() ==
+            "candidate (runtime: bad state)");
+  }
+}
+
 TEST_CASE("RunStats") {
   SECTION("distinguishes responses, filtered bodies, errors, and bytes written") {
     RunStats stats;
@@ -76,7 +149,9 @@ TEST_CASE("RunStats") {
     stats.record_attempt();
     stats.record_response(404);
     stats.record_filtered();
-    stats.record_error();
+    stats.record_body_skipped(512);
+    stats.record_body_aborted(256);
+    stats.record_error(ErrorCause::of(AbradeException::timeout("tcp connect")));
 
     REQUIRE(stats.attempted() == 2);
     REQUIRE(stats.success_2xx() == 1);
@@ -84,10 +159,260 @@ TEST_CASE("RunStats") {
     REQUIRE(stats.filtered() == 1);
     REQUIRE(stats.errors() == 1);
     REQUIRE(stats.bytes_written() == 1024);
+    REQUIRE(stats.bodies_skipped() == 1);
+    REQUIRE(stats.bodies_aborted() == 1);
+    REQUIRE(stats.bytes_avoided() == 768);
     REQUIRE(stats.has_errors());
     REQUIRE(stats.summary().contains("attempted=2"));
     REQUIRE(stats.summary().contains("2xx=1"));
     REQUIRE(stats.summary().contains("non-2xx=1"));
     REQUIRE(stats.summary().contains("bytes-written=1024"));
+    REQUIRE(stats.summary().contains("bodies-aborted=1"));
+    REQUIRE(stats.summary().contains("bytes-avoided=768"));
+  }
+
+  SECTION("counts every status code and groups errors by cause") {
+    RunStats stats;
+    const auto reset_code =
+        boost::asio::error::make_error_code(boost::asio::error::connection_reset);
+    const auto reset = ErrorCause::of(AbradeException{"ssl handshake", reset_code});
+
+    stats.record_response(404);
+    stats.record_response(200);
+    stats.record_response(404);
+    stats.record_error(ErrorCause::of(AbradeException::timeout("tcp connect")));
+    stats.record_error(reset);
+    stats.record_error(reset);
+
+    REQUIRE(stats.status_codes().at(404) == 2);
+    REQUIRE(stats.error_causes().at(reset) == 2);
+    REQUIRE(stats.summary().contains("\n[ ] Status codes: 200=1 404=2"));
+    REQUIRE(stats.summary().contains("\n[ ] Error causes: ssl handshake (system: "));
+    REQUIRE(stats.summary().contains(")=2; tcp connect (timeout)=1"));
+  }
+
+  SECTION("prints latency percentiles only for phases that were recorded") {
+    RunStats stats;
+
+    for (int sample{1}; sample <= 100; ++sample) {
+      stats.record_phase(Phase::first_byte, std::chrono::milliseconds{sample});
+    }
+
+    REQUIRE(stats.latency(Phase::first_byte).count() == 100);
+    REQUIRE(stats.latency(Phase::resolve).count() == 0);
+    REQUIRE(stats.summary().contains("[ ] Latency ttfb: n=100 p50="));
+    REQUIRE_FALSE(stats.summary().contains("Latency dns"));
+  }
+
+  SECTION("counts coroutines in each state while their phases are timed") {
+    RunStats stats;
+    const int socket{};
+    {
+      PhaseTimer phase{stats, Phase::resolve, &socket};
+      const StateScope output{stats, CoroutineState::output};
+      REQUIRE(stats.waiting(CoroutineState::resolve) == 1U);
+      REQUIRE(stats.waiting(CoroutineState::output) == 1U);
+      phase.next(Phase::connect);
+      REQUIRE(stats.waiting(CoroutineState::resolve) == 0U);
+      REQUIRE(stats.waiting(CoroutineState::connect) == 1U);
+      phase.finish();
+      REQUIRE(stats.waiting(CoroutineState::connect) == 0U);
+    }
+    {
+      const PhaseTimer abandoned{stats, Phase::tls, &socket};
+      REQUIRE(stats.waiting(CoroutineState::tls) == 1U);
+    }
+
+    REQUIRE(stats.waiting(CoroutineState::tls) == 0U);
+    REQUIRE(stats.waiting(CoroutineState::output) == 0U);
+    REQUIRE(stats.latency(Phase::resolve).count() == 1U);
+    REQUIRE(stats.latency(Phase::connect).count() == 1U);
+    REQUIRE(stats.latency(Phase::tls).count() == 0U);
+  }
+}
+
+TEST_CASE("LatencyHistogram") {
+  SECTION("reports percentiles within the bucket precision") {
+    LatencyHistogram histogram;
+    for (int sample{1}; sample <= 1000; ++sample) {
+      histogram.record(std::chrono::microseconds{sample * 100});
+    }
+
+    REQUIRE(histogram.count() == 1000);
+    REQUIRE(histogram.max() == 100000);
+    const auto within = [](std::uint64_t reported, std::uint64_t expected) {
+      return reported >= expected && reported <= expected + expected / 16U;
+    };
+    REQUIRE(within(histogram.percentile(0.5), 50000));
+    REQUIRE(within(histogram.percentile(0.9), 90000));
+    REQUIRE(within(histogram.percentile(0.99), 99000));
+    REQUIRE(histogram.percentile(0.999) <= histogram.max());
+    REQUIRE(histogram.percentile(1.0) == 100000);
+  }
+
+  SECTION("keeps small values exact and empty histograms at zero") {
+    LatencyHistogram histogram;
+
+    REQUIRE(histogram.percentile(0.5) == 0);
+    histogram.record(std::chrono::microseconds{3});
+    histogram.record(std::chrono::microseconds{-5});
+    REQUIRE(histogram.percentile(0.5) == 0);
+    REQUIRE(histogram.percentile(1.0) == 3);
+  }
+
+  SECTION("covers the full 64-bit range") {
+    LatencyHistogram histogram;
+    histogram.record(std::chrono::hours{24 * 365});
+
+    REQUIRE(histogram.percentile(0.5) == histogram.max());
+  }
+}
+
+TEST_CASE("ProgressLine") {
+  SECTION("reports rates since the previous refresh, hits, errors, and completion") {
+    RunStats stats;
+    boost::asio::io_context ios;
+    ProgressLine progress{ios, stats, std::chrono::milliseconds{100}, 8, std::cout, false};
+    const auto start = std::chrono::steady_clock::now();
+    static_cast<void>(progress.render(start));
+
+    for (int candidate{}; candidate < 5; ++candidate) {
+      stats.record_candidate_started();
+      stats.record_attempt();
+    }
+    for (int candidate{}; candidate < 4; ++candidate) {
+      stats.record_candidate_finished();
+    }
+    stats.record_hit();
+    stats.record_error(ErrorCause::of(std::runtime_error{"failed"}));
+    stats.record_bytes_received(2U * 1024U * 1024U);
+    const auto line = progress.render(start + std::chrono::seconds{2});
+
+    REQUIRE(stats.in_flight() == 1);
+    REQUIRE(line.starts_with("[ ] Progress: "));
+    REQUIRE(line.contains(" 2.5 req/s in-flight=1 hits=1 errors=25.0% 1.00 MiB/s 50.0% ETA "));
+    REQUIRE(progress.render(start + std::chrono::seconds{3}).contains(" 0.0 req/s "));
+  }
+
+  SECTION("shows the states in-flight coroutines are waiting in") {
+    RunStats stats;
+    boost::asio::io_context ios;
+    ProgressLine progress{ios, stats, std::chrono::milliseconds{100}, std::nullopt, std::cout,
+                          false};
+    stats.record_candidate_started();
+    stats.record_candidate_started();
+    stats.enter(CoroutineState::first_byte);
+    stats.enter(CoroutineState::connect);
+
+    const auto line = progress.render(std::chrono::steady_clock::now());
+    REQUIRE(line.contains(" in-flight=2 [connect=1 ttfb=1] hits=0 "));
+  }
+
+  SECTION("omits completion without a known candidate count") {
+    RunStats stats;
+    boost::asio::io_context ios;
+    ProgressLine progress{ios, stats, std::chrono::milliseconds{100}, std::nullopt, std::cout,
+                          false};
+
+    const auto line = progress.render(std::chrono::steady_clock::now());
+    REQUIRE(line.ends_with(" MiB/s"));
+    REQUIRE_FALSE(line.contains("ETA"));
+  }
+
+  SECTION("refreshes on its timer until stopped") {
+    RunStats stats;
+    boost::asio::io_context ios;
+    std::ostringstream periodic;
+    std::ostringstream in_place;
+    ProgressLine lines{ios, stats, std::chrono::milliseconds{5}, 10, periodic, false};
+    ProgressLine redrawn{ios, stats, std::chrono::milliseconds{5}, 10, in_place, true};
+    boost::asio::steady_timer finish{ios, std::chrono::milliseconds{40}};
+    lines.start();
+    redrawn.start();
+    finish.async_wait([&](const boost::system::error_code&) {
+      lines.stop();
+      redrawn.stop();
+    });
+    ios.run();
+
+    REQUIRE(periodic.str().starts_with("[ ] Progress: "));
+    REQUIRE_FALSE(periodic.str().contains('\r'));
+    REQUIRE(in_place.str().starts_with("\r[ ] Progress: "));
+    REQUIRE(in_place.str().ends_with("\x1b[K\n"));
+  }
+}
+
+TEST_CASE("WorkerPool") {
+  SECTION("runs jobs off the networking thread and bounds the queue") {
+    RunStats stats;
+    boost::asio::io_context ios;
+    WorkerPool workers{ios, 2, 1, stats};
+    const auto network_thread = std::this_thread::get_id();
+    std::vector<int> results;
+    std::size_t off_thread{};
+
+    for (int job{}; job < 3; ++job) {
+      boost::asio::spawn(
+          ios,
+          [&, job](const boost::asio::yield_context& yield) {
+            results.push_back(workers.run(
+                [&off_thread, network_thread, job] {
+                  if (std::this_thread::get_id() != network_thread) {
+                    off_thread++;
+                  }
+                  return job * 10;
+                },
+                yield));
+          },
+          boost::asio::detached);
+    }
+    ios.run();
+
+    REQUIRE(results.size() == 3);
+    REQUIRE(off_thread == 3);
+    REQUIRE(stats.worker_jobs() == 3);
+    REQUIRE(stats.worker_queue_peak() == 1);
+    REQUIRE(stats.worker_waits() >= 2);
+    REQUIRE(stats.summary().contains("workers=2 worker-jobs=3"));
+  }
+
+  SECTION("rethrows job failures on the calling coroutine") {
+    RunStats stats;
+    boost::asio::io_context ios;
+    WorkerPool workers{ios, 1, 4, stats};
+    bool caught{};
+
+    boost::asio::spawn(
+        ios,
+        [&](const boost::asio::yield_context& yield) {
+          try {
+            workers.run([] { throw std::runtime_error{"scan failed"}; }, yield);
+          } catch (const std::runtime_error&) {
+            caught = true;
+          }
+        },
+        boost::asio::detached);
+    ios.run();
+
+    REQUIRE(caught);
+  }
+
+  SECTION("runs jobs inline without threads and reports no worker metrics") {
+    RunStats stats;
+    boost::asio::io_context ios;
+    WorkerPool workers{ios, 0, 1, stats};
+    int result{};
+
+    boost::asio::spawn(
+        ios,
+        [&](const boost::asio::yield_context& yield) {
+          result = workers.run([] { return 7; }, yield);
+        },
+        boost::asio::detached);
+    ios.run();
+
+    REQUIRE(result == 7);
+    REQUIRE(stats.worker_jobs() == 0);
+    REQUIRE_FALSE(stats.summary().contains("workers="));
   }
 }
@@ -0,0 +1,99 @@
+#include <abrade/simhash.hpp>
+#include <abrade/soft_not_found.hpp>
+#include <boost/beast/http/field.hpp>
+#include <boost/beast/http/fields.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace abrade;
+
+namespace {
+ResponseFingerprint fingerprint(unsigned int status, std::uint64_t length, std::string_view body) {
+  boost::beast::http::fields fields;
+  fields.set(boost::beast::http::field::content_type, "text/html");
+  fields.set(boost::beast::http::field::server, "fixture");
+  auto result = ResponseFingerprint::of(status, fields);
+  result.length = length;
+  result.body_hash = SimHash::of(body);
+  return result;
+}
+} // namespace
+
+TEST_CASE("SimHash") {
+  SECTION("keeps near-duplicate pages within a few bits") {
+    const auto learned = SimHash::of("<html><body><h1>Not Found</h1><p>We looked everywhere for "
+                                     "/x8f2k1 but could not find that page. Try the search box "
+                                     "or return to the home page.</p></body></html>");
+    const auto echoed = SimHash::of("<html><body><h1>Not Found</h1><p>We looked everywhere for "
+                                    "/items/42 but could not find that page. Try the search box "
+                                    "or return to the home page.</p></body></html>");
+    const auto real = SimHash::of("<html><body><h1>Item 42</h1><p>Brass fittings, sold in "
+                                  "packs of ten, ship within two days from our warehouse.</p>"
+                                  "</body></html>");
+
+    REQUIRE(SimHash::distance(learned, echoed) <= SoftNotFound::max_body_distance);
+    REQUIRE(SimHash::distance(learned, real) > SoftNotFound::max_body_distance);
+  }
+
+  SECTION("hashes streamed chunks like the whole body, case-insensitively") {
+    SimHash streamed;
+    streamed.feed("Page not fo");
+    streamed.feed("und, sorry");
+
+    REQUIRE(streamed.finish() == SimHash::of("page NOT found, sorry"));
+    REQUIRE(SimHash::of("") == 0U);
+  }
+
+  SECTION("ignores words echoed from the requested path") {
+    const auto echoed = [](std::string_view path) {
+      SimHash hash;
+      hash.ignore(path);
+      hash.feed("<p>Sorry, ");
+      hash.feed(path);
+      hash.feed(" was not found.</p>");
+      return hash.finish();
+    };
+
+    REQUIRE(echoed("/soft/1q9zk4m2x7c0v8b3n") == echoed("/soft/3"));
+    REQUIRE(echoed("/soft/3") == SimHash::of("<p>Sorry, was not found.</p>"));
+  }
+}
+
+TEST_CASE("SoftNotFound") {
+  SECTION("learns only 2xx answers and matches close fingerprints") {
+    SoftNotFound soft_not_found;
+    soft_not_found.learn(fingerprint(404, 100, "not found"));
+    soft_not_found.learn(fingerprint(200, 1000, "sorry that page was not found"));
+    soft_not_found.finish_calibration();
+
+    REQUIRE_FALSE(soft_not_found.calibrating());
+    REQUIRE(soft_not_found.size() == 1);
+    REQUIRE(soft_not_found.matches(fingerprint(200, 1050, "sorry that page was not found")));
+    REQUIRE_FALSE(soft_not_found.matches(fingerprint(200, 5000, "sorry that page was not found")));
+    REQUIRE_FALSE(soft_not_found.matches(fingerprint(203, 1000, "sorry that page was not found")));
+    REQUIRE_FALSE(soft_not_found.matches(fingerprint(200, 1000, "a genuinely different article")));
+  }
+
+  SECTION("compares header names but not values") {
+    SoftNotFound soft_not_found;
+    soft_not_found.learn(fingerprint(200, 10, "missing"));
+    auto extra_header = fingerprint(200, 10, "missing");
+    extra_header.header_names.emplace_back("set-cookie");
+
+    REQUIRE(soft_not_found.matches(fingerprint(200, 10, "missing")));
+    REQUIRE_FALSE(soft_not_found.matches(extra_header));
+  }
+
+  SECTION("derives deterministic random targets from a sample candidate") {
+    const auto targets = SoftNotFound::calibration_targets("/items/1?view=full#top", 3, 7);
+
+    REQUIRE(targets.size() == 3);
+    REQUIRE(targets == SoftNotFound::calibration_targets("/items/1?view=full#top", 3, 7));
+    REQUIRE(targets[0].starts_with("/items/1?view=full"));
+    REQUIRE(targets[0].size() == std::string{"/items/1?view=full"}.size() + 16U);
+    REQUIRE(targets[0] != targets[1]);
+    REQUIRE(SoftNotFound::calibration_targets("", 1, 7)[0].starts_with("/"));
+  }
+}
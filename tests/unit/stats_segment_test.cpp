@@ -0,0 +1,66 @@
+#include <abrade/controller.hpp>
+#include <abrade/run_stats.hpp>
+#include <abrade/stats_segment.hpp>
+#include <boost/asio/io_context.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <unistd.h>
+
+using namespace abrade;
+
+TEST_CASE("StatsSegment") {
+  SECTION("publishes stats, the census, and the controller to readers") {
+    RunStats stats;
+    stats.record_candidate_started();
+    stats.record_candidate_started();
+    stats.record_attempt();
+    stats.record_response(200);
+    stats.record_hit();
+    stats.record_candidate_finished();
+    stats.record_bytes_received(4096);
+    stats.enter(CoroutineState::first_byte);
+    FixedController controller{9, 1};
+    boost::asio::io_context ios;
+    const std::string long_host(300, 'h');
+    StatsSegment segment{ios, stats, controller, long_host, "/{1:10}", 10U};
+    REQUIRE(segment.name() == "/abrade." + std::to_string(getpid()));
+
+    const auto view = StatsSegmentView::attach(segment.name());
+    REQUIRE(view);
+    auto snapshot = view->snapshot();
+    REQUIRE(snapshot.pid == getpid());
+    REQUIRE(snapshot.host == std::string(255, 'h'));
+    REQUIRE(snapshot.pattern == "/{1:10}");
+    REQUIRE(snapshot.cardinality == 10U);
+    REQUIRE(snapshot.requests == 1U);
+    REQUIRE(snapshot.in_flight == 1U);
+    REQUIRE(snapshot.hits == 1U);
+    REQUIRE(snapshot.bytes_received == 4096U);
+    REQUIRE(snapshot.waiting[static_cast<std::size_t>(CoroutineState::first_byte)] == 1U);
+    REQUIRE(snapshot.recommended_coroutines == 9U);
+    REQUIRE_FALSE(snapshot.finished);
+
+    stats.record_attempt();
+    controller.register_completion(1);
+    REQUIRE(view->snapshot().requests == 1U);
+    segment.stop();
+    snapshot = view->snapshot();
+    REQUIRE(snapshot.requests == 2U);
+    REQUIRE(snapshot.velocity > 0.0);
+    REQUIRE(snapshot.finished);
+  }
+
+  SECTION("removes the segment with its publisher") {
+    RunStats stats;
+    const FixedController controller{1, 1};
+    boost::asio::io_context ios;
+    std::string name;
+    {
+      const StatsSegment segment{ios, stats, controller, "lospi.net", "<stdin>", std::nullopt};
+      name = segment.name();
+      REQUIRE(StatsSegmentView::attach(name)->snapshot().cardinality == std::nullopt);
+    }
+    REQUIRE_FALSE(StatsSegmentView::attach(name));
+    REQUIRE_FALSE(StatsSegmentView::attach("/abrade.missing"));
+  }
+}